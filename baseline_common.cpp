@@ -1,77 +1,198 @@
 #include "baseline_common.hpp"
 
 #include <algorithm>
+#include <array>
 #include <numeric>
+#include <utility>
 
 #include "common.hpp"
 
 void BaselineCommon::addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition)
 {
     ids.clear();
+    keepPassingIds(mergeShardData(aShardData), aPassCondition);
+}
+
+void BaselineCommon::addDependencyData(const ShardData& aData)
+{
+    Timer sTimer("DefaultEstimator merge sharded data");
+
+    addToCounter("DefaultEstimator merge sharded data", Counter::IDS_INGESTED, aData.total_size);
+    addToCounter("DefaultEstimator merge sharded data", Counter::BYTES_ALLOCATED, sizeof(uint64_t) * aData.total_size);
+    pending_ids.insert(pending_ids.end(), aData.ids.begin(), aData.ids.end());
+}
+
+void BaselineCommon::finishDependencies(uint32_t aPassCondition)
+{
+    ids.clear();
+    keepPassingIds(std::exchange(pending_ids, {}), aPassCondition);
+}
+
+uint64_t BaselineCommon::estimateMemoryUsage() const
+{
+    return sizeof(uint64_t) * ids.capacity();
+}
+
+bool BaselineCommon::contains(uint64_t aId) const
+{
+    if (ids.empty())
+    {
+        return false;
+    }
+
+    // Branchless lower bound: the loop has a fixed trip count and compiles to conditional moves.
+    const uint64_t* sBase   = ids.data();
+    size_t          sLength = ids.size();
+    while (sLength > 1)
+    {
+        const size_t sHalf = sLength / 2;
+        sBase              = sBase[sHalf] < aId ? sBase + sHalf : sBase;
+        sLength -= sHalf;
+    }
+    sBase += *sBase < aId;
 
-    const auto sDeps = mergeShardData(aShardData);
+    return sBase != ids.data() + ids.size() && *sBase == aId;
+}
+
+void BaselineCommon::containsBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    // Runs the branchless search of contains() for a group of ids in lockstep. Every lookup of a round is
+    // independent of the others, and the next probe of every id is prefetched, so the cache misses of the
+    // group overlap instead of forming one dependent chain per id.
+    constexpr size_t GROUP_SIZE = 16;
+
+    const uint64_t* sEnd = ids.data() + ids.size();
+    for (size_t sOffset = 0; sOffset < aIds.size(); sOffset += GROUP_SIZE)
     {
-        Timer                 sTimer("Default estimator coverage calculation");
-        std::vector<uint64_t> sTmp;
-        size_t                sCount = std::accumulate(sDeps.begin(),
-                                        sDeps.end(),
-                                        0,
-                                        [](const auto& acc, const auto& e) { return acc + e.size(); });
-        sTmp.reserve(sCount);
-
-        for (const auto& x : sDeps)
-            sTmp.insert(sTmp.end(), x.begin(), x.end());
-
-        std::sort(sTmp.begin(), sTmp.end());
-
-        uint64_t sLastId = 0;
-        sCount           = 0;
-        for (const auto& x : sTmp)
+        const size_t sCount = std::min(GROUP_SIZE, aIds.size() - sOffset);
+        if (ids.empty())
         {
-            if (sLastId != x)
-            {
-                if (sCount >= aPassCondition)
-                    ids.insert(sLastId);
-                sLastId = x;
-                sCount  = 1;
-            }
-            else
+            std::fill_n(aResults.begin() + sOffset, sCount, 0);
+            continue;
+        }
+
+        std::array<const uint64_t*, GROUP_SIZE> sBases;
+        sBases.fill(ids.data());
+
+        size_t sLength = ids.size();
+        while (sLength > 1)
+        {
+            const size_t sHalf     = sLength / 2;
+            const size_t sNextHalf = (sLength - sHalf) / 2;
+            for (size_t i = 0; i < sCount; ++i)
             {
-                sCount++;
+                sBases[i] = sBases[i][sHalf] < aIds[sOffset + i] ? sBases[i] + sHalf : sBases[i];
+                __builtin_prefetch(sBases[i] + sNextHalf);
             }
+            sLength -= sHalf;
         }
-        if (!sTmp.empty())
+
+        for (size_t i = 0; i < sCount; ++i)
         {
-            if (sCount >= aPassCondition)
-                ids.insert(sLastId);
+            const uint64_t  sId   = aIds[sOffset + i];
+            const uint64_t* sBase = sBases[i] + (*sBases[i] < sId);
+            aResults[sOffset + i] = sBase != sEnd && *sBase == sId;
         }
     }
 }
 
-uint64_t BaselineCommon::estimateMemoryUsage() const
+const std::vector<uint64_t>& BaselineCommon::getIds() const
 {
-    return sizeof(uint64_t) * ids.size();
+    return ids;
 }
 
-const std::set<uint64_t>& BaselineCommon::getIds() const
+std::vector<uint64_t> BaselineCommon::mergeShardData(const std::vector<ShardData>& aShardData) const
 {
-    return ids;
+    Timer sTimer("DefaultEstimator merge sharded data");
+
+    size_t sCount = 0;
+    for (const auto& sDependency : aShardData)
+    {
+        sCount += sDependency.total_size;
+    }
+
+    std::vector<uint64_t> sResult;
+    sResult.reserve(sCount);
+    addToCounter("DefaultEstimator merge sharded data", Counter::IDS_INGESTED, sCount);
+    addToCounter("DefaultEstimator merge sharded data", Counter::BYTES_ALLOCATED, sizeof(uint64_t) * sCount);
+
+    for (const auto& sDependency : aShardData)
+    {
+        sResult.insert(sResult.end(), sDependency.ids.begin(), sDependency.ids.end());
+    }
+
+    return sResult;
 }
 
-std::vector<std::vector<uint64_t>> BaselineCommon::mergeShardData(const std::vector<ShardData>& aShardData) const
+void BaselineCommon::keepPassingIds(std::vector<uint64_t> aIds, uint32_t aPassCondition)
 {
-    std::vector<std::vector<uint64_t>> sResult;
-    sResult.reserve(aShardData.size());
+    Timer sTimer("Default estimator coverage calculation");
 
-    for (const auto& sDependency : aShardData)
+    // The radix sort scatters through a buffer as large as the input.
+    addToCounter("Default estimator coverage calculation", Counter::BYTES_ALLOCATED, sizeof(uint64_t) * aIds.size());
+    details::radixSort(aIds);
+
+    // Compact the survivors in place: aIds is not read behind the write position.
+    size_t sSurvivorCount = 0;
+    for (size_t sBegin = 0; sBegin < aIds.size();)
     {
-        sResult.push_back({});
-        Timer sTimer("DefaultEstimator merge sharded data");
-        for (const auto& sShard : sDependency.data)
+        size_t sEnd = sBegin + 1;
+        while (sEnd < aIds.size() && aIds[sEnd] == aIds[sBegin])
+        {
+            ++sEnd;
+        }
+
+        if (sEnd - sBegin >= aPassCondition)
         {
-            sResult.back().insert(sResult.back().end(), sShard.begin(), sShard.end());
+            aIds[sSurvivorCount++] = aIds[sBegin];
         }
+        sBegin = sEnd;
     }
 
-    return sResult;
+    aIds.resize(sSurvivorCount);
+    aIds.shrink_to_fit();
+    ids = std::move(aIds);
 }
+
+namespace details
+{
+    void radixSort(std::vector<uint64_t>& aValues)
+    {
+        // LSD radix sort over 11-bit digits: 6 passes, each histogram fits in L1.
+        constexpr uint32_t DIGIT_BITS  = 11;
+        constexpr uint32_t DIGIT_COUNT = (64 + DIGIT_BITS - 1) / DIGIT_BITS;
+        constexpr uint64_t BUCKETS     = uint64_t{1} << DIGIT_BITS;
+        constexpr uint64_t MASK        = BUCKETS - 1;
+
+        std::array<std::array<size_t, BUCKETS>, DIGIT_COUNT> sHistograms{};
+        for (auto sValue : aValues)
+        {
+            for (uint32_t sDigit = 0; sDigit < DIGIT_COUNT; ++sDigit)
+            {
+                ++sHistograms[sDigit][(sValue >> (sDigit * DIGIT_BITS)) & MASK];
+            }
+        }
+
+        std::vector<uint64_t> sBuffer(aValues.size());
+        for (uint32_t sDigit = 0; sDigit < DIGIT_COUNT; ++sDigit)
+        {
+            auto& sHistogram = sHistograms[sDigit];
+
+            // Every value has the same digit, the pass would be an identity permutation.
+            if (std::find(sHistogram.begin(), sHistogram.end(), aValues.size()) != sHistogram.end())
+            {
+                continue;
+            }
+
+            std::exclusive_scan(sHistogram.begin(), sHistogram.end(), sHistogram.begin(), size_t{0});
+
+            const uint32_t sShift = sDigit * DIGIT_BITS;
+            for (auto sValue : aValues)
+            {
+                sBuffer[sHistogram[(sValue >> sShift) & MASK]++] = sValue;
+            }
+
+            aValues.swap(sBuffer);
+        }
+    }
+}  // namespace details
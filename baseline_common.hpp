@@ -2,17 +2,33 @@
 
 #include "shard_data.hpp"
 
-#include <set>
+#include <span>
 #include <vector>
 
 class BaselineCommon
 {
 public:
-    void                      addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
-    uint64_t                  estimateMemoryUsage() const;
-    const std::set<uint64_t>& getIds() const;
+    void                         addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
+    // addShardData for callers that get the dependencies one at a time, see streamShardDataFromDependencies:
+    // addDependencyData collects the ids of a dependency, finishDependencies applies aPassCondition to all of them.
+    void                         addDependencyData(const ShardData& aData);
+    void                         finishDependencies(uint32_t aPassCondition);
+    uint64_t                     estimateMemoryUsage() const;
+    bool                         contains(uint64_t aId) const;
+    // aResults[i] is set to contains(aIds[i]). aResults must be at least as long as aIds.
+    void                         containsBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
+    const std::vector<uint64_t>& getIds() const;
 
 private:
-    std::set<uint64_t>                 ids;
-    std::vector<std::vector<uint64_t>> mergeShardData(const std::vector<ShardData>& aShardData) const;
-};
\ No newline at end of file
+    // Sorted and free of duplicates.
+    std::vector<uint64_t> ids;
+    // Ids of the dependencies added since the last finishDependencies, unsorted.
+    std::vector<uint64_t> pending_ids;
+    std::vector<uint64_t> mergeShardData(const std::vector<ShardData>& aShardData) const;
+    void                  keepPassingIds(std::vector<uint64_t> aIds, uint32_t aPassCondition);
+};
+
+namespace details
+{
+    void radixSort(std::vector<uint64_t>& aValues);
+}
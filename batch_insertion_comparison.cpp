@@ -0,0 +1,54 @@
+#include "estimators.hpp"
+#include "shard_data.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    template <typename Function>
+    double measureIdsPerSecond(size_t aIdCount, Function&& aFunction)
+    {
+        const auto sBegin = std::chrono::steady_clock::now();
+        aFunction();
+        const std::chrono::duration<double> sElapsed = std::chrono::steady_clock::now() - sBegin;
+
+        return aIdCount / sElapsed.count();
+    }
+
+    template <typename Estimator>
+    void compareInsertion(const std::string&           aName,
+                          const std::vector<uint64_t>& aIds,
+                          Estimator                    aScalar,
+                          Estimator                    aBatched)
+    {
+        const auto sScalar = measureIdsPerSecond(aIds.size(),
+                                                 [&]
+                                                 {
+                                                     // addh() is the scalar reference entry point.
+                                                     for (auto sId : aIds)
+                                                     {
+                                                         aScalar.getInternalState().addh(sId);
+                                                     }
+                                                 });
+        const auto sBatched = measureIdsPerSecond(aIds.size(), [&] { aBatched.addBatch(aIds); });
+
+        std::cout << "Sketch, ids, scalar ids/sec, batched ids/sec, speedup: " << aName << ' ' << aIds.size()
+                  << ' ' << static_cast<uint64_t>(sScalar) << ' ' << static_cast<uint64_t>(sBatched) << ' '
+                  << sBatched / sScalar << std::endl;
+    }
+}  // namespace
+
+int main()
+{
+    for (uint32_t sSize : {1'000'000, 10'000'000, 30'000'000})
+    {
+        const auto sIds = generateIds(sSize, {}, sSize);
+
+        compareInsertion("HyperLogLogEstimator", sIds, HyperLogLogEstimator(20), HyperLogLogEstimator(20));
+        compareInsertion("BBitMinHashEstimator", sIds, BBitMinHashEstimator(16), BBitMinHashEstimator(16));
+        compareInsertion("RangeMinHashEstimator", sIds, RangeMinHashEstimator(1024), RangeMinHashEstimator(1024));
+    }
+
+    return 0;
+}
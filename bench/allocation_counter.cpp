@@ -0,0 +1,61 @@
+#include "allocation_counter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocation_count{0};
+}  // namespace
+
+uint64_t allocationCount()
+{
+    return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t aSize)
+{
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* sPointer = std::malloc(aSize ? aSize : 1))
+    {
+        return sPointer;
+    }
+    throw std::bad_alloc();
+}
+
+// Over-aligned types such as SplitBlockBloomFilter::Block go through these.
+void* operator new(std::size_t aSize, std::align_val_t aAlignment)
+{
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    const auto sAlignment = static_cast<std::size_t>(aAlignment);
+    const auto sSize      = (std::max<std::size_t>(aSize, 1) + sAlignment - 1) / sAlignment * sAlignment;
+    if (void* sPointer = std::aligned_alloc(sAlignment, sSize))
+    {
+        return sPointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* aPointer) noexcept
+{
+    std::free(aPointer);
+}
+
+void operator delete(void* aPointer, std::size_t) noexcept
+{
+    std::free(aPointer);
+}
+
+void operator delete(void* aPointer, std::align_val_t) noexcept
+{
+    std::free(aPointer);
+}
+
+void operator delete(void* aPointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(aPointer);
+}
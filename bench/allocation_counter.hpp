@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of global operator new calls made by the process so far, over-aligned allocations included.
+uint64_t allocationCount();
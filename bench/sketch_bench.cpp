@@ -0,0 +1,751 @@
+#include <benchmark/benchmark.h>
+
+#include "allocation_counter.hpp"
+#include "baseline_common.hpp"
+#include "estimators.hpp"
+#include "experiment_arena.hpp"
+#include "incremental_estimator.hpp"
+#include "loopback_channel.hpp"
+#include "presence_checkers.hpp"
+#include "segment.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    constexpr uint64_t BENCH_SEED = 1337;
+
+    // Generating tens of millions of ids dominates otherwise, so every (size, shard count) pair is generated once.
+    const ShardData& getShardData(uint32_t aSegmentSize, uint32_t aShardCount)
+    {
+        static std::map<std::tuple<uint32_t, uint32_t>, ShardData> sCache;
+
+        auto sIt = sCache.find({aSegmentSize, aShardCount});
+        if (sIt == sCache.end())
+        {
+            sIt = sCache
+                      .emplace(std::tuple{aSegmentSize, aShardCount},
+                               generateShardData(aSegmentSize, aShardCount, ShardDataDistribution::EVEN, BENCH_SEED))
+                      .first;
+        }
+
+        return sIt->second;
+    }
+
+    // Reports the heap allocations made since construction, averaged per benchmark iteration.
+    class AllocationCounter
+    {
+    public:
+        AllocationCounter() : begin(allocationCount()) {}
+
+        void report(benchmark::State& aState) const
+        {
+            aState.counters["allocs"] = benchmark::Counter(static_cast<double>(allocationCount() - begin),
+                                                           benchmark::Counter::kAvgIterations);
+        }
+
+    private:
+        uint64_t begin{0};
+    };
+
+    void reportBytesPerId(benchmark::State& aState, uint64_t aBytes, uint64_t aIdCount)
+    {
+        aState.counters["bytes_per_id"] = static_cast<double>(aBytes) / static_cast<double>(aIdCount);
+    }
+
+    // Args: segment size, shard count, sketch parameter (bucket log2 / b-bit register log2 / sketch size).
+    template <typename Estimator>
+    void BM_PerShardBuild(benchmark::State& aState)
+    {
+        const auto& sData = getShardData(aState.range(0), aState.range(1));
+        Estimator   sEstimator(aState.range(2));
+
+        AllocationCounter sAllocations;
+        uint64_t          sStateBytes = 0;
+        for (auto _ : aState)
+        {
+            sStateBytes = 0;
+            for (const auto& sShard : sData.shards())
+            {
+                auto sState = sEstimator.constructDefault();
+                Estimator::addBatchToState(sState, sShard);
+                sStateBytes += getStateBytes(sState, sEstimator.estimateMemoryUsage());
+                benchmark::DoNotOptimize(sState);
+            }
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sData.total_size);
+        sAllocations.report(aState);
+        reportBytesPerId(aState, sStateBytes, sData.total_size);
+    }
+
+    // Args: segment size, shard count, sketch parameter. Full addShardData path including the shard merge.
+    template <typename Estimator>
+    void BM_DependencyBuild(benchmark::State& aState)
+    {
+        const std::vector<ShardData> sData{getShardData(aState.range(0), aState.range(1))};
+
+        AllocationCounter sAllocations;
+        uint64_t          sMemoryUsage = 0;
+        for (auto _ : aState)
+        {
+            Estimator sEstimator(aState.range(2));
+            sEstimator.addShardData(sData, 1);
+            sMemoryUsage = sEstimator.estimateMemoryUsage();
+            benchmark::DoNotOptimize(sEstimator.estimateCoverage());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sData.front().total_size);
+        sAllocations.report(aState);
+        reportBytesPerId(aState, sMemoryUsage, sData.front().total_size);
+    }
+
+    // Args: segment size, shard count, sketch parameter. Refreshes one shard of an incrementally maintained
+    // estimator, to be compared with a full BM_DependencyBuild.
+    template <typename Estimator>
+    void BM_IncrementalShardUpdate(benchmark::State& aState)
+    {
+        const std::vector<ShardData>    sData{getShardData(aState.range(0), aState.range(1))};
+        IncrementalEstimator<Estimator> sEstimator(aState.range(2));
+        sEstimator.addShardData(sData, 1);
+
+        size_t sShard = 0;
+        for (auto _ : aState)
+        {
+            sEstimator.replaceShard(0, sShard, sData.front().shard(sShard));
+            benchmark::DoNotOptimize(sEstimator.estimateCoverage());
+            sShard = (sShard + 1) % sData.front().shardCount();
+        }
+
+        aState.SetItemsProcessed(aState.iterations());
+    }
+
+    // Args: segment size, shard count, sketch parameter. Same as BM_DependencyBuild, but the per-shard sketches
+    // come from a cache that outlives the iterations, as in a sweep over experiments sharing their shards.
+    template <typename Estimator>
+    void BM_CachedDependencyBuild(benchmark::State& aState)
+    {
+        std::vector<ShardData> sData{getShardData(aState.range(0), aState.range(1))};
+        SketchCache            sCache(uint64_t{1} << 30);
+        fingerprintShards(sData.front());
+
+        for (auto _ : aState)
+        {
+            Estimator sEstimator(aState.range(2));
+            sEstimator.setSketchCache(&sCache);
+            sEstimator.addShardData(sData, 1);
+            benchmark::DoNotOptimize(sEstimator.estimateCoverage());
+        }
+
+        const auto sStatistics    = sCache.getStatistics();
+        aState.counters["hits"]   = sStatistics.hits;
+        aState.counters["misses"] = sStatistics.misses;
+        aState.SetItemsProcessed(aState.iterations() * sData.front().total_size);
+    }
+
+    // Args: segment size, shard count, sketch parameter. Maps a store of precomputed per-shard sketches and merges
+    // them, the counterpart of BM_DependencyBuild that skips ingestion.
+    template <typename Estimator>
+    void BM_StoredSketchMerge(benchmark::State& aState)
+    {
+        const auto& sData = getShardData(aState.range(0), aState.range(1));
+        const auto  sPath = "sketch_bench_" + Estimator::Name + ".sks";
+        {
+            SketchStoreWriter sWriter;
+            Estimator(aState.range(2)).storeShardSketches(sData, sWriter);
+            sWriter.write(sPath);
+        }
+
+        for (auto _ : aState)
+        {
+            MappedSketchStore sStore(sPath);
+            Estimator         sEstimator(aState.range(2));
+            sEstimator.addStoredSketches(sStore);
+            benchmark::DoNotOptimize(sEstimator.estimateCoverage());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sData.shardCount());
+        std::remove(sPath.c_str());
+    }
+
+    // Args: segment size, shard count, sketch parameter. Encodes prebuilt per-shard sketches for the wire.
+    template <typename Estimator>
+    void BM_WireEncode(benchmark::State& aState)
+    {
+        const auto&     sData = getShardData(aState.range(0), aState.range(1));
+        const Estimator sEstimator(aState.range(2));
+
+        std::vector<typename Estimator::InternalStateType> sStates;
+        uint64_t                                           sStateBytes = 0;
+        for (const auto& sShard : sData.shards())
+        {
+            sStates.push_back(sEstimator.constructDefault());
+            Estimator::addBatchToState(sStates.back(), sShard);
+            sStateBytes += getStateBytes(sStates.back(), sEstimator.estimateMemoryUsage());
+        }
+
+        uint64_t sEncodedBytes = 0;
+        for (auto _ : aState)
+        {
+            sEncodedBytes = 0;
+            for (auto& sState : sStates)
+            {
+                sEncodedBytes += encodeSketch(sState, sEstimator.getSketchParameters()).size();
+            }
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sStates.size());
+        aState.counters["encoded_bytes_per_shard"] = static_cast<double>(sEncodedBytes) / sStates.size();
+        aState.counters["state_bytes_per_shard"]   = static_cast<double>(sStateBytes) / sStates.size();
+    }
+
+    // Args: segment size, shard count, sketch parameter. Decodes and merges the encoded per-shard sketches.
+    template <typename Estimator>
+    void BM_WireDecodeMerge(benchmark::State& aState)
+    {
+        const auto&     sData = getShardData(aState.range(0), aState.range(1));
+        const Estimator sEncoder(aState.range(2));
+
+        std::vector<std::vector<std::byte>> sMessages;
+        for (const auto& sShard : sData.shards())
+        {
+            sMessages.push_back(sEncoder.encodeShardSketch(sShard));
+        }
+
+        for (auto _ : aState)
+        {
+            Estimator sEstimator(aState.range(2));
+            for (const auto& sMessage : sMessages)
+            {
+                sEstimator.addEncodedSketch(sMessage);
+            }
+            benchmark::DoNotOptimize(sEstimator.estimateCoverage());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sMessages.size());
+    }
+
+    // Args: segment size, shard count, sketch parameter, what is shipped (0: ids, 1: encoded sketches). Four
+    // simulated nodes ship the shards of a segment to an aggregator over a pipe, which ingests or merges every
+    // message as it arrives.
+    template <typename Factory>
+    void runLoopbackAggregationBenchmark(benchmark::State& aState, Factory&& aFactory)
+    {
+        constexpr uint32_t NODE_COUNT = 4;
+
+        const auto& sData         = getShardData(aState.range(0), aState.range(1));
+        const bool  sShipSketches = aState.range(3) != 0;
+        const auto  sEncoder      = aFactory();
+
+        const auto sSendNode = [&](uint32_t aNode, LoopbackChannel& aChannel)
+        {
+            for (size_t i = aNode; i < sData.shardCount(); i += NODE_COUNT)
+            {
+                if (sShipSketches)
+                {
+                    aChannel.send(sEncoder.encodeShardSketch(sData.shard(i)));
+                }
+                else
+                {
+                    aChannel.send(std::as_bytes(sData.shard(i)));
+                }
+            }
+        };
+
+        uint64_t sBytesShipped = 0;
+        for (auto _ : aState)
+        {
+            auto sAggregate = aFactory();
+            sBytesShipped   = aggregateOverLoopback(
+                "Loopback aggregation",
+                NODE_COUNT,
+                sSendNode,
+                [&](std::span<const std::byte> aMessage)
+                {
+                    if (sShipSketches)
+                    {
+                        sAggregate.addEncodedSketch(aMessage);
+                    }
+                    else
+                    {
+                        sAggregate.addBatch({reinterpret_cast<const uint64_t*>(aMessage.data()),
+                                             aMessage.size() / sizeof(uint64_t)});
+                    }
+                });
+            benchmark::DoNotOptimize(sAggregate);
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sData.total_size);
+        reportBytesPerId(aState, sBytesShipped, sData.total_size);
+    }
+
+    template <typename Estimator>
+    void BM_LoopbackAggregation(benchmark::State& aState)
+    {
+        runLoopbackAggregationBenchmark(aState, [&] { return Estimator(aState.range(2)); });
+    }
+
+    // Sketch parameter: bit count log2.
+    void BM_BloomFilterLoopbackAggregation(benchmark::State& aState)
+    {
+        runLoopbackAggregationBenchmark(aState, [&] { return BloomFilterPresenceChecker(aState.range(2), 4); });
+    }
+
+    template <typename Sketch, typename Factory, typename Merge>
+    void runMergeBenchmark(benchmark::State& aState, Factory&& aFactory, Merge&& aMerge)
+    {
+        const auto& sData = getShardData(aState.range(0), 2);
+
+        auto sLeft  = aFactory();
+        auto sRight = aFactory();
+        for (auto sId : sData.shard(0))
+        {
+            sLeft.addh(sId);
+        }
+        for (auto sId : sData.shard(1))
+        {
+            sRight.addh(sId);
+        }
+
+        AllocationCounter sAllocations;
+        for (auto _ : aState)
+        {
+            Sketch sResult = sLeft;
+            aMerge(sResult, sRight);
+            benchmark::DoNotOptimize(sResult);
+        }
+
+        aState.SetItemsProcessed(aState.iterations());
+        sAllocations.report(aState);
+    }
+
+    // Args: segment size, bucket log2.
+    void BM_HllMerge(benchmark::State& aState)
+    {
+        runMergeBenchmark<sketch::hll_t>(
+            aState,
+            [&] { return sketch::hll_t(aState.range(1), sketch::hll::ORIGINAL); },
+            [](sketch::hll_t& aLeft, const sketch::hll_t& aRight) { aLeft += aRight; });
+    }
+
+    // Args: segment size, bucket log2. Two shards of the segment, so small segments stay sparse.
+    void BM_SparseHllMerge(benchmark::State& aState)
+    {
+        runMergeBenchmark<SparseHyperLogLog>(
+            aState,
+            [&] { return SparseHyperLogLog(aState.range(1), sketch::hll::ORIGINAL); },
+            [](SparseHyperLogLog& aLeft, const SparseHyperLogLog& aRight) { aLeft += aRight; });
+    }
+
+    // Args: segment size, bit count log2.
+    void BM_BloomFilterUnion(benchmark::State& aState)
+    {
+        runMergeBenchmark<sketch::bf_t>(
+            aState,
+            [&] { return sketch::bf_t(aState.range(1), 4); },
+            [](sketch::bf_t& aLeft, const sketch::bf_t& aRight) { aLeft |= aRight; });
+    }
+
+    // Args: segment size, bit count log2.
+    void BM_BloomFilterIntersection(benchmark::State& aState)
+    {
+        runMergeBenchmark<sketch::bf_t>(
+            aState,
+            [&] { return sketch::bf_t(aState.range(1), 4); },
+            [](sketch::bf_t& aLeft, const sketch::bf_t& aRight) { aLeft = aLeft & aRight; });
+    }
+
+    // Args: segment size, hll count.
+    void BM_HllFilterMerge(benchmark::State& aState)
+    {
+        runMergeBenchmark<sketch::hlf_t>(
+            aState,
+            [&] { return sketch::hlf_t(aState.range(1), BENCH_SEED, 20); },
+            [](sketch::hlf_t& aLeft, const sketch::hlf_t& aRight) { aLeft += aRight; });
+    }
+
+    // Args: segment size, sketch parameter.
+    template <typename Estimator>
+    void BM_CardinalityEstimate(benchmark::State& aState)
+    {
+        const auto& sData = getShardData(aState.range(0), 1);
+        Estimator   sEstimator(aState.range(1));
+        sEstimator.addBatch(sData.ids);
+
+        // A batch of copies is refreshed before it is estimated, so that sketches caching their estimate have to
+        // recompute it. The copies are not timed, and pausing once per batch keeps the pause overhead small against
+        // estimates well under a microsecond. Reusing the states keeps their destruction out of the timed region.
+        constexpr benchmark::IterationCount BATCH_SIZE = 64;
+
+        std::vector<typename Estimator::InternalStateType> sStates(BATCH_SIZE, sEstimator.getInternalState());
+        while (aState.KeepRunningBatch(BATCH_SIZE))
+        {
+            aState.PauseTiming();
+            std::fill(sStates.begin(), sStates.end(), sEstimator.getInternalState());
+            aState.ResumeTiming();
+
+            for (auto& sState : sStates)
+            {
+                benchmark::DoNotOptimize(sState.cardinality_estimate());
+            }
+        }
+
+        aState.SetItemsProcessed(aState.iterations());
+    }
+
+    template <typename Checker>
+    void runMayContainBenchmark(benchmark::State& aState, Checker& aChecker, uint32_t aSegmentSize)
+    {
+        const std::vector<ShardData> sData{getShardData(aSegmentSize, 1)};
+        aChecker.addShardData(sData, 1);
+
+        const auto sProbes = generateIds(1 << 16, {}, BENCH_SEED + 1);
+
+        for (auto _ : aState)
+        {
+            for (auto sProbe : sProbes)
+            {
+                benchmark::DoNotOptimize(aChecker.isPresent(sProbe));
+            }
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sProbes.size());
+        reportBytesPerId(aState, aChecker.estimateMemoryUsage(), aSegmentSize);
+    }
+
+    // Probes through the PresenceChecker interface, one isPresentBatch call per iteration.
+    void runIsPresentBatchBenchmark(benchmark::State& aState, PresenceChecker& aChecker, uint32_t aSegmentSize)
+    {
+        const std::vector<ShardData> sData{getShardData(aSegmentSize, 1)};
+        aChecker.addShardData(sData, 1);
+
+        const auto           sProbes = generateIds(1 << 16, {}, BENCH_SEED + 1);
+        std::vector<uint8_t> sResults(sProbes.size());
+
+        for (auto _ : aState)
+        {
+            aChecker.isPresentBatch(sProbes, sResults);
+            benchmark::DoNotOptimize(sResults.data());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sProbes.size());
+        reportBytesPerId(aState, aChecker.estimateMemoryUsage(), aSegmentSize);
+    }
+
+    // Args: segment size.
+    void BM_BaselineIsPresent(benchmark::State& aState)
+    {
+        BaselinePresenceChecker sChecker;
+        runMayContainBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size.
+    void BM_BaselineIsPresentBatch(benchmark::State& aState)
+    {
+        BaselinePresenceChecker sChecker;
+        runIsPresentBatchBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size, bit count log2, hash function count.
+    void BM_BloomFilterMayContain(benchmark::State& aState)
+    {
+        BloomFilterPresenceChecker sChecker(aState.range(1), aState.range(2));
+        runMayContainBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size, bit count log2, hash function count.
+    void BM_BloomFilterIsPresentBatch(benchmark::State& aState)
+    {
+        BloomFilterPresenceChecker sChecker(aState.range(1), aState.range(2));
+        runIsPresentBatchBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size, hll count.
+    void BM_HllFilterMayContain(benchmark::State& aState)
+    {
+        HyperLogLogPresenceChecker sChecker(aState.range(1), 20);
+        runMayContainBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size, counter count log2, hash function count.
+    void BM_CountingBloomFilterMayContain(benchmark::State& aState)
+    {
+        CountingBloomFilterPresenceChecker sChecker(aState.range(1), aState.range(2));
+        runMayContainBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size, block count log2. Same memory as BM_BloomFilterMayContain with 8 more bits of size.
+    void BM_SplitBlockBloomFilterMayContain(benchmark::State& aState)
+    {
+        SplitBlockBloomFilterPresenceChecker sChecker(aState.range(1));
+        runMayContainBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size, block count log2.
+    void BM_SplitBlockBloomFilterIsPresentBatch(benchmark::State& aState)
+    {
+        SplitBlockBloomFilterPresenceChecker sChecker(aState.range(1));
+        runIsPresentBatchBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size.
+    void BM_BinaryFuseFilterIsPresentBatch(benchmark::State& aState)
+    {
+        BinaryFuseFilterPresenceChecker sChecker;
+        runIsPresentBatchBenchmark(aState, sChecker, aState.range(0));
+    }
+
+    // Args: segment size.
+    void BM_BinaryFuseFilterBuild(benchmark::State& aState)
+    {
+        const std::vector<ShardData> sData{getShardData(aState.range(0), 1)};
+
+        for (auto _ : aState)
+        {
+            BinaryFuseFilterPresenceChecker sChecker;
+            sChecker.addShardData(sData, 1);
+            benchmark::DoNotOptimize(sChecker.estimateMemoryUsage());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * aState.range(0));
+    }
+
+    // Args: segment size. Erases a tenth of the ids and inserts them again, the filter is at most 90% full.
+    void BM_CuckooFilterEraseInsert(benchmark::State& aState)
+    {
+        const uint32_t sSize = aState.range(0);
+        const auto     sIds  = generateIds(sSize, {}, BENCH_SEED);
+
+        CuckooFilterPresenceChecker sChecker(std::bit_width(uint64_t{sSize} * 10 / 9 / 4));
+        sChecker.addBatch(sIds);
+
+        const auto sChurn = std::span<const uint64_t>(sIds).first(sSize / 10);
+        for (auto _ : aState)
+        {
+            sChecker.eraseBatch(sChurn);
+            sChecker.addBatch(sChurn);
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sChurn.size() * 2);
+    }
+
+    // Args: segment size, 0 for a virtual isPresent call per id, 1 for std::visit over AnyPresenceChecker per id.
+    void BM_PresenceCheckerDispatch(benchmark::State& aState)
+    {
+        AnyPresenceChecker sChecker = SplitBlockBloomFilterPresenceChecker(20);
+        addShardData(sChecker, {getShardData(aState.range(0), 1)}, 1);
+
+        // Opaque to the optimizer, so the virtual call is not devirtualized.
+        const PresenceChecker* sInterface = &std::get<SplitBlockBloomFilterPresenceChecker>(sChecker);
+        benchmark::DoNotOptimize(sInterface);
+
+        const auto sProbes = generateIds(1 << 16, {}, BENCH_SEED + 1);
+        for (auto _ : aState)
+        {
+            if (aState.range(1))
+            {
+                for (auto sProbe : sProbes)
+                {
+                    benchmark::DoNotOptimize(isPresent(sChecker, sProbe));
+                }
+            }
+            else
+            {
+                for (auto sProbe : sProbes)
+                {
+                    benchmark::DoNotOptimize(sInterface->isPresent(sProbe));
+                }
+            }
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sProbes.size());
+    }
+
+    // Args: segment size, shard count, sketch parameter, 1 to pipeline the stages, 0 to run them in sequence.
+    // Every iteration generates a dependency and two union prototypes of it and ingests them: pipelined, the next
+    // dependency is generated while the current one is ingested, as in the drivers, and shard sketches are merged
+    // while the others are still built.
+    template <typename Estimator>
+    void BM_EndToEndIngest(benchmark::State& aState)
+    {
+        const uint32_t  sSize      = aState.range(0);
+        const bool      sPipelined = aState.range(3) != 0;
+        ExperimentArena sArena;
+
+        Dependencies sDeps;
+        sDeps.size               = sSize;
+        sDeps.shard_count        = aState.range(1);
+        sDeps.shard_distribution = ShardDataDistribution::RANDOM;
+        sDeps.seed               = BENCH_SEED;
+        sDeps.prototypes         = {{ShardDataPrototype::UNION, uint64_t{sSize} * 3 / 2, sSize},
+                                    {ShardDataPrototype::UNION, uint64_t{sSize} * 3 / 2, sSize}};
+
+        for (auto _ : aState)
+        {
+            sArena.reset();
+            sDeps.memory_resource = sArena.getResource();
+
+            Estimator sEstimator(aState.range(2));
+            if (sPipelined)
+            {
+                sEstimator.setIngestionMode(IngestionMode::PIPELINED);
+                streamShardDataFromDependencies(
+                    sDeps, 1, [&](size_t, const ShardData& aData) { sEstimator.addDependencyData(aData); });
+            }
+            else
+            {
+                sEstimator.addShardData(getShardDataFromDependencies(sDeps), 1);
+            }
+            benchmark::DoNotOptimize(sEstimator.estimateCoverage());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sSize * (sDeps.prototypes.size() + 1));
+    }
+
+    // Args: segment size, 1 to allocate from an ExperimentArena reset every iteration, 0 for the default resource.
+    // Generates a dependency and a union prototype of it, as getShardDataFromDependencies does.
+    void BM_ShardDataGeneration(benchmark::State& aState)
+    {
+        const uint32_t  sSize = aState.range(0);
+        ExperimentArena sArena;
+
+        AllocationCounter sAllocations;
+        for (auto _ : aState)
+        {
+            sArena.reset();
+            auto* sResource = aState.range(1) ? sArena.getResource() : std::pmr::get_default_resource();
+
+            const auto sMain = generateShardData(sSize, 40, ShardDataDistribution::RANDOM, BENCH_SEED, sResource);
+            const auto sUnion
+                = generateShardDataUsingExisting(sMain,
+                                                 {ShardDataPrototype::UNION, uint64_t{sSize} * 3 / 2, sSize},
+                                                 ShardDataDistribution::RANDOM,
+                                                 BENCH_SEED + 1,
+                                                 sResource);
+            benchmark::DoNotOptimize(sUnion.ids.data());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * sSize * 2);
+        sAllocations.report(aState);
+    }
+
+    // Args: segment size, shard count, dependency count.
+    void BM_BaselineCommon(benchmark::State& aState)
+    {
+        std::vector<ShardData> sData;
+        for (int64_t i = 0; i < aState.range(2); ++i)
+        {
+            sData.push_back(generateShardData(aState.range(0), aState.range(1), ShardDataDistribution::EVEN, i));
+        }
+
+        AllocationCounter sAllocations;
+        uint64_t          sMemoryUsage = 0;
+        for (auto _ : aState)
+        {
+            BaselineCommon sBaseline;
+            sBaseline.addShardData(sData, 1);
+            sMemoryUsage = sBaseline.estimateMemoryUsage();
+            benchmark::DoNotOptimize(sBaseline.getIds().data());
+        }
+
+        aState.SetItemsProcessed(aState.iterations() * aState.range(0) * aState.range(2));
+        sAllocations.report(aState);
+        reportBytesPerId(aState, sMemoryUsage, aState.range(0) * aState.range(2));
+    }
+}  // namespace
+
+BENCHMARK(BM_PerShardBuild<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {1, 40, 1'000}, {10, 14, 20}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PerShardBuild<BBitMinHashEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {1, 40}, {10, 16}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_PerShardBuild<RangeMinHashEstimator>)
+    ->ArgsProduct({{1 << 20}, {1, 40}, {256, 4096}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_DependencyBuild<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40}, {14, 20}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_IncrementalShardUpdate<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40}, {14, 20}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_CachedDependencyBuild<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40}, {14, 20}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_StoredSketchMerge<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20}, {40}, {14, 20}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StoredSketchMerge<BBitMinHashEstimator>)
+    ->ArgsProduct({{1 << 20}, {40}, {10, 16}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WireEncode<HyperLogLogEstimator>)->ArgsProduct({{1 << 20}, {40, 1'000}, {14, 20}});
+BENCHMARK(BM_WireEncode<BBitMinHashEstimator>)->ArgsProduct({{1 << 20}, {40}, {10, 16}});
+BENCHMARK(BM_WireEncode<RangeMinHashEstimator>)->ArgsProduct({{1 << 20}, {40}, {256, 4096}});
+BENCHMARK(BM_WireDecodeMerge<HyperLogLogEstimator>)->ArgsProduct({{1 << 20}, {40, 1'000}, {14, 20}});
+BENCHMARK(BM_WireDecodeMerge<BBitMinHashEstimator>)->ArgsProduct({{1 << 20}, {40}, {10, 16}});
+BENCHMARK(BM_LoopbackAggregation<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40, 1'000}, {14, 20}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+// Every shard filter has the full size, so 1000 shards only run with the smaller filter.
+BENCHMARK(BM_BloomFilterLoopbackAggregation)
+    ->ArgsProduct({{1 << 20}, {40}, {24, 28}, {0, 1}})
+    ->ArgsProduct({{1 << 20}, {1'000}, {24}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_DependencyBuild<KOfNCoverageEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40}, {1024, 16384}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_HllMerge)->ArgsProduct({{1 << 16}, {10, 14, 20}});
+BENCHMARK(BM_SparseHllMerge)->ArgsProduct({{1 << 12, 1 << 16}, {10, 14, 20}});
+BENCHMARK(BM_BloomFilterUnion)->ArgsProduct({{1 << 16}, {20, 24, 28}});
+BENCHMARK(BM_BloomFilterIntersection)->ArgsProduct({{1 << 16}, {20, 24, 28}});
+BENCHMARK(BM_HllFilterMerge)->ArgsProduct({{1 << 16}, {1, 8}});
+
+BENCHMARK(BM_CardinalityEstimate<HyperLogLogEstimator>)->ArgsProduct({{1 << 20}, {10, 14, 20}});
+BENCHMARK(BM_CardinalityEstimate<BBitMinHashEstimator>)->ArgsProduct({{1 << 20}, {10, 16}});
+BENCHMARK(BM_CardinalityEstimate<RangeMinHashEstimator>)->ArgsProduct({{1 << 20}, {256, 4096}});
+
+BENCHMARK(BM_BaselineIsPresent)->Arg(1 << 20)->Arg(1 << 23);
+BENCHMARK(BM_BaselineIsPresentBatch)->Arg(1 << 20)->Arg(1 << 23);
+BENCHMARK(BM_BloomFilterMayContain)->ArgsProduct({{1 << 20, 1 << 23}, {24, 28}, {2, 4}});
+BENCHMARK(BM_BloomFilterIsPresentBatch)->ArgsProduct({{1 << 20, 1 << 23}, {24, 28}, {2, 4}});
+BENCHMARK(BM_HllFilterMayContain)->ArgsProduct({{1 << 20}, {1, 4, 8}});
+BENCHMARK(BM_CountingBloomFilterMayContain)->ArgsProduct({{1 << 20, 1 << 23}, {24, 27}, {2, 4}});
+
+BENCHMARK(BM_SplitBlockBloomFilterMayContain)->ArgsProduct({{1 << 20, 1 << 23}, {16, 20}});
+BENCHMARK(BM_SplitBlockBloomFilterIsPresentBatch)->ArgsProduct({{1 << 20, 1 << 23}, {16, 20}});
+
+BENCHMARK(BM_BinaryFuseFilterIsPresentBatch)->Arg(1 << 20)->Arg(1 << 23);
+BENCHMARK(BM_BinaryFuseFilterBuild)->Arg(1 << 20)->Arg(1 << 23)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_CuckooFilterEraseInsert)->Arg(1 << 20)->Arg(1 << 23);
+
+BENCHMARK(BM_PresenceCheckerDispatch)->ArgsProduct({{1 << 20}, {0, 1}});
+
+BENCHMARK(BM_EndToEndIngest<HyperLogLogEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40, 1'000}, {14, 20}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_EndToEndIngest<BBitMinHashEstimator>)
+    ->ArgsProduct({{1 << 20, 1 << 23}, {40}, {16}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_ShardDataGeneration)->ArgsProduct({{1 << 20, 1 << 23}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_BaselineCommon)->ArgsProduct({{1 << 20, 1 << 23}, {40}, {1, 4}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,272 @@
+#include "binary_fuse_filter.hpp"
+
+#include "random.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t ARITY                   = 3;
+    constexpr uint32_t MAX_ATTEMPTS            = 100;
+    constexpr uint32_t MAX_SEGMENT_LENGTH_LOG2 = 18;
+
+    __extension__ using Uint128 = unsigned __int128;
+
+    uint64_t multiplyHigh(uint64_t aLeft, uint64_t aRight)
+    {
+        return static_cast<uint64_t>((static_cast<Uint128>(aLeft) * aRight) >> 64);
+    }
+
+    uint8_t getFingerprint(uint64_t aHash)
+    {
+        return static_cast<uint8_t>(aHash ^ (aHash >> 32));
+    }
+
+    uint32_t mod3(uint32_t aValue)
+    {
+        return aValue > 2 ? aValue - 3 : aValue;
+    }
+}  // namespace
+
+BinaryFuseFilter::BinaryFuseFilter(std::span<const uint64_t> aIds, uint64_t aSeed)
+{
+    if (aIds.empty())
+    {
+        return;
+    }
+
+    // Segment length and the array's slack over the id count, as tuned in the paper for arity 3.
+    const double   sSize              = static_cast<double>(aIds.size());
+    const uint32_t sSegmentLengthLog2 = static_cast<uint32_t>(std::floor(std::log(sSize) / std::log(3.33) + 2.25));
+    segment_length                    = uint32_t{1} << std::min(sSegmentLengthLog2, MAX_SEGMENT_LENGTH_LOG2);
+    segment_length_mask               = segment_length - 1;
+
+    const double   sSizeFactor = std::max(1.125, 0.875 + 0.25 * std::log(1'000'000.0) / std::log(sSize));
+    const uint64_t sCapacity   = aIds.size() > 1 ? static_cast<uint64_t>(std::round(sSize * sSizeFactor)) : 0;
+
+    uint64_t sSegmentCount = (sCapacity + segment_length - 1) / segment_length;
+    sSegmentCount          = sSegmentCount <= ARITY - 1 ? 1 : sSegmentCount - (ARITY - 1);
+    segment_count_length   = static_cast<uint32_t>(sSegmentCount * segment_length);
+    fingerprints.resize((sSegmentCount + ARITY - 1) * segment_length);
+
+    for (uint32_t sAttempt = 0; sAttempt < MAX_ATTEMPTS; ++sAttempt)
+    {
+        seed = counterRandom(aSeed, sAttempt);
+        if (tryBuild(aIds))
+        {
+            return;
+        }
+    }
+
+    throw std::runtime_error("BinaryFuseFilter: could not find a seed that builds the filter");
+}
+
+bool BinaryFuseFilter::mayContain(uint64_t aId) const
+{
+    return probe(hash(aId));
+}
+
+void BinaryFuseFilter::mayContainBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    constexpr size_t GROUP_SIZE = 32;
+
+    if (fingerprints.empty())
+    {
+        std::fill_n(aResults.begin(), aIds.size(), 0);
+        return;
+    }
+
+    uint8_t sFingerprints[GROUP_SIZE];
+    Slots   sSlots[GROUP_SIZE];
+    for (size_t sOffset = 0; sOffset < aIds.size(); sOffset += GROUP_SIZE)
+    {
+        const size_t sCount = std::min(GROUP_SIZE, aIds.size() - sOffset);
+        for (size_t i = 0; i < sCount; ++i)
+        {
+            const uint64_t sHash = hash(aIds[sOffset + i]);
+            sFingerprints[i]     = getFingerprint(sHash);
+            sSlots[i]            = getSlots(sHash);
+            for (auto sPosition : sSlots[i].positions)
+            {
+                __builtin_prefetch(&fingerprints[sPosition]);
+            }
+        }
+
+        for (size_t i = 0; i < sCount; ++i)
+        {
+            aResults[sOffset + i] = (sFingerprints[i] ^ fingerprints[sSlots[i].positions[0]]
+                                     ^ fingerprints[sSlots[i].positions[1]] ^ fingerprints[sSlots[i].positions[2]])
+                                    == 0;
+        }
+    }
+}
+
+uint64_t BinaryFuseFilter::estimateMemoryUsage() const
+{
+    return fingerprints.size() * sizeof(uint8_t);
+}
+
+uint64_t BinaryFuseFilter::hash(uint64_t aId) const
+{
+    return splitMix64(aId + seed);
+}
+
+BinaryFuseFilter::Slots BinaryFuseFilter::getSlots(uint64_t aHash) const
+{
+    // The first slot is spread over all segments but the last two, the other two are in the following segments
+    // at offsets taken from independent bits of the hash.
+    const auto sFirst = static_cast<uint32_t>(multiplyHigh(aHash, segment_count_length));
+
+    return Slots{{sFirst,
+                  (sFirst + segment_length) ^ static_cast<uint32_t>((aHash >> 18) & segment_length_mask),
+                  (sFirst + 2 * segment_length) ^ static_cast<uint32_t>(aHash & segment_length_mask)}};
+}
+
+bool BinaryFuseFilter::probe(uint64_t aHash) const
+{
+    if (fingerprints.empty())
+    {
+        return false;
+    }
+
+    const auto sSlots = getSlots(aHash);
+    return (getFingerprint(aHash) ^ fingerprints[sSlots.positions[0]] ^ fingerprints[sSlots.positions[1]]
+            ^ fingerprints[sSlots.positions[2]])
+           == 0;
+}
+
+bool BinaryFuseFilter::tryBuild(std::span<const uint64_t> aIds)
+{
+    const size_t sSize        = aIds.size();
+    const size_t sArrayLength = fingerprints.size();
+
+    // Sort the hashes coarsely by their first segment, which makes the slot updates below cache friendly.
+    // A zero entry marks a free position, the sentinel stops the probing for a free one at the end.
+    const uint64_t sSegmentCount = segment_count_length / segment_length;
+    uint32_t       sBlockBits    = 1;
+    while ((uint64_t{1} << sBlockBits) < sSegmentCount)
+    {
+        ++sBlockBits;
+    }
+    const uint64_t sBlockCount = uint64_t{1} << sBlockBits;
+
+    std::vector<uint64_t> sOrder(sSize + 1);
+    sOrder[sSize] = 1;
+
+    std::vector<uint64_t> sStarts(sBlockCount);
+    for (uint64_t i = 0; i < sBlockCount; ++i)
+    {
+        sStarts[i] = (i * sSize) >> sBlockBits;
+    }
+
+    for (auto sId : aIds)
+    {
+        const uint64_t sHash  = hash(sId);
+        uint64_t       sBlock = sHash >> (64 - sBlockBits);
+        while (sOrder[sStarts[sBlock]] != 0)
+        {
+            sBlock = (sBlock + 1) & (sBlockCount - 1);
+        }
+        sOrder[sStarts[sBlock]++] = sHash;
+    }
+
+    // Per slot: the number of ids mapped to it times four, the xor of which of their three slots it is in the
+    // low two bits, and the xor of their hashes. A slot with a single id therefore names that id and its slot.
+    std::vector<uint8_t>  sCounts(sArrayLength);
+    std::vector<uint64_t> sHashXors(sArrayLength);
+
+    const auto sAddToSlot = [&](uint32_t aPosition, uint32_t aSlot, uint64_t aHash)
+    {
+        sCounts[aPosition] = static_cast<uint8_t>((sCounts[aPosition] + 4) ^ aSlot);
+        sHashXors[aPosition] ^= aHash;
+    };
+    const auto sRemoveFromSlot = [&](uint32_t aPosition, uint32_t aSlot, uint64_t aHash)
+    {
+        sCounts[aPosition] = static_cast<uint8_t>((sCounts[aPosition] - 4) ^ aSlot);
+        sHashXors[aPosition] ^= aHash;
+    };
+
+    for (size_t i = 0; i < sSize; ++i)
+    {
+        const uint64_t sHash  = sOrder[i];
+        const auto     sSlots = getSlots(sHash);
+        for (uint32_t sSlot = 0; sSlot < ARITY; ++sSlot)
+        {
+            sAddToSlot(sSlots.positions[sSlot], sSlot, sHash);
+        }
+
+        // The 8-bit count overflowed.
+        for (auto sPosition : sSlots.positions)
+        {
+            if (sCounts[sPosition] < 4)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Peel slots with a single id, recording the order and the slot each id was peeled from.
+    std::vector<uint32_t> sQueue;
+    sQueue.reserve(sArrayLength);
+    for (uint32_t i = 0; i < sArrayLength; ++i)
+    {
+        if ((sCounts[i] >> 2) == 1)
+        {
+            sQueue.push_back(i);
+        }
+    }
+
+    std::vector<uint8_t> sPeeledSlots(sSize);
+    size_t               sPeeledCount = 0;
+    while (!sQueue.empty())
+    {
+        const uint32_t sPosition = sQueue.back();
+        sQueue.pop_back();
+        if ((sCounts[sPosition] >> 2) != 1)
+        {
+            continue;
+        }
+
+        const uint64_t sHash  = sHashXors[sPosition];
+        const uint32_t sSlot  = sCounts[sPosition] & 3;
+        const auto     sSlots = getSlots(sHash);
+
+        sPeeledSlots[sPeeledCount] = static_cast<uint8_t>(sSlot);
+        sOrder[sPeeledCount]       = sHash;
+        ++sPeeledCount;
+
+        for (uint32_t sOtherSlot : {mod3(sSlot + 1), mod3(sSlot + 2)})
+        {
+            const uint32_t sOther = sSlots.positions[sOtherSlot];
+            if ((sCounts[sOther] >> 2) == 2)
+            {
+                sQueue.push_back(sOther);
+            }
+            sRemoveFromSlot(sOther, sOtherSlot, sHash);
+        }
+        sRemoveFromSlot(sPosition, sSlot, sHash);
+    }
+
+    if (sPeeledCount != sSize)
+    {
+        return false;
+    }
+
+    // In reverse peeling order every id still has its peeled slot to itself: set it so the three slots xor to
+    // the fingerprint.
+    std::fill(fingerprints.begin(), fingerprints.end(), 0);
+    for (size_t i = sPeeledCount; i-- > 0;)
+    {
+        const uint64_t sHash  = sOrder[i];
+        const uint32_t sSlot  = sPeeledSlots[i];
+        const auto     sSlots = getSlots(sHash);
+
+        fingerprints[sSlots.positions[sSlot]] = getFingerprint(sHash)
+                                                ^ fingerprints[sSlots.positions[mod3(sSlot + 1)]]
+                                                ^ fingerprints[sSlots.positions[mod3(sSlot + 2)]];
+    }
+
+    return true;
+}
@@ -0,0 +1,125 @@
+#include "bottom_k_sketch.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // 2^-64: maps a 64-bit hash onto [0, 1).
+    constexpr double HASH_NORMALIZATION = 1.0 / 18446744073709551616.0;
+}  // namespace
+
+CountingBottomKSketch::CountingBottomKSketch(uint32_t aSampleSize) : sample_size(std::max(aSampleSize, 2u))
+{
+    sample.reserve(sample_size);
+    pending.reserve(sample_size);
+}
+
+CountingBottomKSketch& CountingBottomKSketch::operator+=(const CountingBottomKSketch& aOther)
+{
+    pending.insert(pending.end(), aOther.sample.begin(), aOther.sample.end());
+    pending.insert(pending.end(), aOther.pending.begin(), aOther.pending.end());
+    compact();
+
+    return *this;
+}
+
+double CountingBottomKSketch::cardinality_estimate() const
+{
+    const auto sSample = getCompactedSample();
+    if (sSample.size() < sample_size)
+    {
+        return static_cast<double>(sSample.size());
+    }
+
+    // KMV estimator: the sample_size-th smallest of n uniform values is around sample_size / n.
+    return (sample_size - 1) / ((static_cast<double>(sSample.back().hash) + 1) * HASH_NORMALIZATION);
+}
+
+double CountingBottomKSketch::countAtLeastEstimate(uint32_t aMinCount) const
+{
+    const auto sSample = getCompactedSample();
+    if (sSample.empty())
+    {
+        return 0;
+    }
+
+    const auto sPassing = std::count_if(
+        sSample.begin(), sSample.end(), [aMinCount](const Entry& aEntry) { return aEntry.count >= aMinCount; });
+    if (sSample.size() < sample_size)
+    {
+        return static_cast<double>(sPassing);
+    }
+
+    // The sample is uniform over the distinct hashes, so it estimates the passing fraction of the union.
+    return static_cast<double>(sPassing) / sSample.size() * cardinality_estimate();
+}
+
+uint32_t CountingBottomKSketch::getSampleSize() const
+{
+    return sample_size;
+}
+
+uint64_t CountingBottomKSketch::estimateMemoryUsage() const
+{
+    return sizeof(Entry) * (sample.capacity() + pending.capacity());
+}
+
+void CountingBottomKSketch::compact()
+{
+    sample = mergeEntries(std::move(sample), std::move(pending), sample_size);
+    pending.clear();
+}
+
+std::vector<CountingBottomKSketch::Entry> CountingBottomKSketch::getCompactedSample() const
+{
+    return pending.empty() ? sample : mergeEntries(sample, pending, sample_size);
+}
+
+std::vector<CountingBottomKSketch::Entry>
+CountingBottomKSketch::mergeEntries(std::vector<Entry> aSample, std::vector<Entry> aPending, uint32_t aSampleSize)
+{
+    std::sort(aPending.begin(),
+              aPending.end(),
+              [](const Entry& aLeft, const Entry& aRight) { return aLeft.hash < aRight.hash; });
+
+    std::vector<Entry> sResult;
+    sResult.reserve(aSampleSize);
+
+    const auto sPush = [&sResult](const Entry& aEntry)
+    {
+        if (!sResult.empty() && sResult.back().hash == aEntry.hash)
+        {
+            sResult.back().count += aEntry.count;
+        }
+        else
+        {
+            sResult.push_back(aEntry);
+        }
+    };
+
+    // Both inputs are sorted: merge them and stop once the sample is full and the next hash is new.
+    auto sLeft  = aSample.begin();
+    auto sRight = aPending.begin();
+    while (sLeft != aSample.end() || sRight != aPending.end())
+    {
+        const bool sTakeLeft = sRight == aPending.end() || (sLeft != aSample.end() && sLeft->hash <= sRight->hash);
+        const auto& sNext    = sTakeLeft ? *sLeft : *sRight;
+
+        if (sResult.size() == aSampleSize && sNext.hash != sResult.back().hash)
+        {
+            break;
+        }
+
+        sPush(sNext);
+        if (sTakeLeft)
+        {
+            ++sLeft;
+        }
+        else
+        {
+            ++sRight;
+        }
+    }
+
+    return sResult;
+}
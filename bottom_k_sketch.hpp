@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Bottom-k sample of the hashes seen so far, where every sampled hash carries the number of times it
+// was added. The sample always holds the sample_size smallest distinct hashes of everything added or
+// merged in, and the counts of those hashes are exact: a hash that ends up in the sample is below every
+// intermediate threshold, so none of its occurrences is ever rejected. Merging adds the counts, which
+// makes the k-of-n query answerable from per-shard sketches built in parallel.
+class CountingBottomKSketch
+{
+public:
+    explicit CountingBottomKSketch(uint32_t aSampleSize);
+
+    // aHash must already be uniformly distributed over 64 bits.
+    void add(uint64_t aHash)
+    {
+        if (sample.size() == sample_size && aHash > sample.back().hash)
+        {
+            return;
+        }
+
+        pending.push_back({aHash, 1});
+        if (pending.size() >= sample_size)
+        {
+            compact();
+        }
+    }
+
+    CountingBottomKSketch& operator+=(const CountingBottomKSketch& aOther);
+
+    // Estimated number of distinct hashes added.
+    double cardinality_estimate() const;
+
+    // Estimated number of distinct hashes added at least aMinCount times.
+    double countAtLeastEstimate(uint32_t aMinCount) const;
+
+    uint32_t getSampleSize() const;
+    uint64_t estimateMemoryUsage() const;
+
+private:
+    struct Entry
+    {
+        uint64_t hash{0};
+        uint32_t count{0};
+    };
+
+    uint32_t sample_size{0};
+    // Sorted by hash, no duplicates, at most sample_size entries.
+    std::vector<Entry> sample;
+    // Unsorted additions not folded into the sample yet.
+    std::vector<Entry> pending;
+
+    void               compact();
+    std::vector<Entry> getCompactedSample() const;
+
+    static std::vector<Entry> mergeEntries(std::vector<Entry> aSample,
+                                           std::vector<Entry> aPending,
+                                           uint32_t           aSampleSize);
+};
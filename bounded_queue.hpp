@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+// Blocking FIFO between pipeline stages. push() waits while aCapacity values are queued, which bounds the
+// memory held between a fast producer and a slow consumer. After close() pushes are refused and pops drain
+// the queued values, then return std::nullopt.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t aCapacity) : capacity(aCapacity == 0 ? 1 : aCapacity) {}
+
+    BoundedQueue(const BoundedQueue&)            = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Returns false, dropping aValue, when the queue was closed before there was room for it.
+    bool push(T aValue)
+    {
+        {
+            std::unique_lock sLock(mutex);
+            not_full.wait(sLock, [this] { return closed || values.size() < capacity; });
+            if (closed)
+            {
+                return false;
+            }
+
+            values.push_back(std::move(aValue));
+        }
+        not_empty.notify_one();
+
+        return true;
+    }
+
+    std::optional<T> pop()
+    {
+        std::optional<T> sResult;
+        {
+            std::unique_lock sLock(mutex);
+            not_empty.wait(sLock, [this] { return closed || !values.empty(); });
+            if (values.empty())
+            {
+                return std::nullopt;
+            }
+
+            sResult.emplace(std::move(values.front()));
+            values.pop_front();
+        }
+        not_full.notify_one();
+
+        return sResult;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard sLock(mutex);
+            closed = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    std::mutex              mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T>           values;
+    size_t                  capacity{1};
+    bool                    closed{false};
+};
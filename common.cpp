@@ -1,14 +1,195 @@
 #include "common.hpp"
 
-Timer::Timer(std::string aOperation)
-: operation(std::move(aOperation)), begin(std::chrono::high_resolution_clock::now())
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    constexpr size_t COUNTER_COUNT = 4;
+
+    constexpr std::array<const char*, COUNTER_COUNT> COUNTER_NAMES{
+        "ids_ingested", "merges", "bytes_allocated", "bytes_shipped"};
+
+    struct SpanRecord
+    {
+        std::string name;
+        uint64_t    start_ns{0};
+        uint64_t    duration_ns{0};
+    };
+
+    struct ResultRecord
+    {
+        std::string                                 name;
+        uint64_t                                    time_ns{0};
+        std::vector<std::pair<std::string, double>> fields;
+    };
+
+    // Only the owning thread writes to its buffer, so recording takes no lock.
+    struct ThreadBuffer
+    {
+        uint32_t                                                thread_index{0};
+        std::vector<SpanRecord>                                 spans;
+        std::map<std::string, std::array<uint64_t, COUNTER_COUNT>> counters;
+        std::vector<ResultRecord>                               results;
+    };
+
+    struct Registry
+    {
+        std::mutex                                 mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        std::chrono::steady_clock::time_point      epoch = std::chrono::steady_clock::now();
+        std::string                                dump_path;
+    };
+
+    Registry& getRegistry()
+    {
+        static Registry sRegistry;
+        return sRegistry;
+    }
+
+    ThreadBuffer& getThreadBuffer()
+    {
+        // The registry co-owns the buffer, records survive the thread that made them.
+        thread_local std::shared_ptr<ThreadBuffer> sBuffer = []
+        {
+            auto& sRegistry = getRegistry();
+            auto  sResult   = std::make_shared<ThreadBuffer>();
+
+            std::lock_guard sLock(sRegistry.mutex);
+            sResult->thread_index = sRegistry.buffers.size();
+            sRegistry.buffers.push_back(sResult);
+
+            return sResult;
+        }();
+
+        return *sBuffer;
+    }
+
+    uint64_t sinceEpoch(std::chrono::steady_clock::time_point aTimePoint)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(aTimePoint - getRegistry().epoch).count();
+    }
+
+    void writeJsonString(std::ostream& aOutput, const std::string& aValue)
+    {
+        aOutput << '"';
+        for (char sChar : aValue)
+        {
+            if (sChar == '"' || sChar == '\\')
+            {
+                aOutput << '\\';
+            }
+            aOutput << sChar;
+        }
+        aOutput << '"';
+    }
+}  // namespace
+
+Timer::Timer(std::string aOperation, uint64_t* aTotalNanoseconds)
+: operation(std::move(aOperation)), total_nanoseconds(aTotalNanoseconds), begin(std::chrono::steady_clock::now())
 {}
 
 Timer::~Timer()
 {
-    std::cout << operation << " took "
-              << std::chrono::duration_cast<std::chrono::milliseconds>(
-                     std::chrono::high_resolution_clock::now() - begin)
-                     .count()
-              << "ms" << std::endl;
-}
\ No newline at end of file
+    const auto sEnd      = std::chrono::steady_clock::now();
+    const auto sDuration
+        = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sEnd - begin).count());
+
+    if (total_nanoseconds != nullptr)
+    {
+        *total_nanoseconds += sDuration;
+    }
+    getThreadBuffer().spans.push_back({std::move(operation), sinceEpoch(begin), sDuration});
+}
+
+void addToCounter(const std::string& aPhase, Counter aCounter, uint64_t aValue)
+{
+    getThreadBuffer().counters[aPhase][static_cast<size_t>(aCounter)] += aValue;
+}
+
+void recordResult(std::string aName, std::vector<std::pair<std::string, double>> aFields)
+{
+    getThreadBuffer().results.push_back(
+        {std::move(aName), sinceEpoch(std::chrono::steady_clock::now()), std::move(aFields)});
+}
+
+void dumpInstrumentation(std::ostream& aOutput)
+{
+    auto&           sRegistry = getRegistry();
+    std::lock_guard sLock(sRegistry.mutex);
+
+    std::map<std::string, std::array<uint64_t, COUNTER_COUNT>> sCounters;
+    for (const auto& sBuffer : sRegistry.buffers)
+    {
+        for (const auto& sSpan : sBuffer->spans)
+        {
+            aOutput << R"({"type":"span","name":)";
+            writeJsonString(aOutput, sSpan.name);
+            aOutput << R"(,"thread":)" << sBuffer->thread_index << R"(,"start_ns":)" << sSpan.start_ns
+                    << R"(,"duration_ns":)" << sSpan.duration_ns << "}\n";
+        }
+
+        for (const auto& sResult : sBuffer->results)
+        {
+            aOutput << R"({"type":"result","name":)";
+            writeJsonString(aOutput, sResult.name);
+            aOutput << R"(,"thread":)" << sBuffer->thread_index << R"(,"time_ns":)" << sResult.time_ns
+                    << R"(,"fields":{)";
+            for (size_t i = 0; i < sResult.fields.size(); ++i)
+            {
+                aOutput << (i ? "," : "");
+                writeJsonString(aOutput, sResult.fields[i].first);
+                aOutput << ':' << std::setprecision(std::numeric_limits<double>::max_digits10)
+                        << sResult.fields[i].second;
+            }
+            aOutput << "}}\n";
+        }
+
+        for (const auto& [sPhase, sValues] : sBuffer->counters)
+        {
+            for (size_t i = 0; i < COUNTER_COUNT; ++i)
+            {
+                sCounters[sPhase][i] += sValues[i];
+            }
+        }
+    }
+
+    for (const auto& [sPhase, sValues] : sCounters)
+    {
+        for (size_t i = 0; i < COUNTER_COUNT; ++i)
+        {
+            aOutput << R"({"type":"counter","phase":)";
+            writeJsonString(aOutput, sPhase);
+            aOutput << R"(,"name":")" << COUNTER_NAMES[i] << R"(","value":)" << sValues[i] << "}\n";
+        }
+    }
+}
+
+void dumpInstrumentationAtExit(std::string aPath)
+{
+    auto& sRegistry = getRegistry();
+    {
+        std::lock_guard sLock(sRegistry.mutex);
+        sRegistry.dump_path = std::move(aPath);
+    }
+
+    std::atexit(
+        []
+        {
+            std::ofstream sOutput(getRegistry().dump_path);
+            if (!sOutput)
+            {
+                std::cerr << "Failed to open instrumentation output " << getRegistry().dump_path << std::endl;
+                return;
+            }
+
+            dumpInstrumentation(sOutput);
+        });
+}
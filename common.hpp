@@ -1,15 +1,45 @@
 #pragma once
 
 #include <chrono>
-#include <iostream>
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <utility>
+#include <vector>
 
+// Scoped span: records its wall time in nanoseconds into a thread-local buffer on destruction.
+// Nothing is printed on the measured path, records are written out by dumpInstrumentation().
 struct Timer
 {
-    Timer(std::string aOperation);
+    // When aTotalNanoseconds is set, the wall time is added to it as well, for callers that report it themselves.
+    Timer(std::string aOperation, uint64_t* aTotalNanoseconds = nullptr);
     ~Timer();
 
 private:
-    std::string                                                 operation;
-    std::chrono::time_point<std::chrono::high_resolution_clock> begin;
-};
\ No newline at end of file
+    std::string                           operation;
+    uint64_t*                             total_nanoseconds{nullptr};
+    std::chrono::steady_clock::time_point begin;
+};
+
+enum class Counter
+{
+    IDS_INGESTED,
+    MERGES,
+    BYTES_ALLOCATED,
+    // Message bytes sent between (simulated) nodes.
+    BYTES_SHIPPED
+};
+
+// Adds aValue to the aCounter of phase aPhase. Aggregated per thread, summed on dump.
+void addToCounter(const std::string& aPhase, Counter aCounter, uint64_t aValue);
+
+// Experiment outcome (accuracy, memory usage, ...) stored alongside the spans so that timings can be
+// attributed to the experiment they belong to.
+void recordResult(std::string aName, std::vector<std::pair<std::string, double>> aFields);
+
+// Writes every span, counter and result recorded so far as JSON lines. Threads that recorded data must
+// not be running any more.
+void dumpInstrumentation(std::ostream& aOutput);
+
+// Dumps the instrumentation into aPath when the process exits normally.
+void dumpInstrumentationAtExit(std::string aPath);
@@ -0,0 +1,101 @@
+#include "counting_bloom_filter.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    uint32_t checkCounterCountLog2(uint32_t aCounterCountLog2)
+    {
+        if (aCounterCountLog2 < CountingBloomFilter::MIN_COUNTER_COUNT_LOG2
+            || aCounterCountLog2 > CountingBloomFilter::MAX_COUNTER_COUNT_LOG2)
+        {
+            throw std::invalid_argument("Counting Bloom filter counter count log2 must be in [6, 40]");
+        }
+
+        return aCounterCountLog2;
+    }
+
+    uint32_t checkHashFunctionCount(uint32_t aNumberOfHashFunctions)
+    {
+        if (aNumberOfHashFunctions == 0 || aNumberOfHashFunctions > CountingBloomFilter::MAX_HASH_FUNCTION_COUNT)
+        {
+            throw std::invalid_argument("Counting Bloom filter hash function count must be in [1, 16]");
+        }
+
+        return aNumberOfHashFunctions;
+    }
+}  // namespace
+
+CountingBloomFilter::DependencySet& CountingBloomFilter::DependencySet::operator|=(const DependencySet& aOther)
+{
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        words[i] |= aOther.words[i];
+    }
+
+    return *this;
+}
+
+CountingBloomFilter::CountingBloomFilter(uint32_t aCounterCountLog2, uint32_t aNumberOfHashFunctions, uint64_t aSeed)
+: counter_count_log2(checkCounterCountLog2(aCounterCountLog2))
+, number_of_hash_functions(checkHashFunctionCount(aNumberOfHashFunctions))
+, seed(aSeed)
+, counters(uint64_t{1} << counter_count_log2)
+{}
+
+CountingBloomFilter::DependencySet CountingBloomFilter::makeDependencySet() const
+{
+    return DependencySet{std::vector<uint64_t>(counters.size() / 64)};
+}
+
+void CountingBloomFilter::addIds(DependencySet& aSet, std::span<const uint64_t> aIds) const
+{
+    withHashFunctionCount(
+        [&](auto aHashFunctionCount)
+        {
+            for (auto sId : aIds)
+            {
+                forEachPosition<aHashFunctionCount>(sId,
+                                                    [&aSet](uint64_t aPosition)
+                                                    { aSet.words[aPosition / 64] |= uint64_t{1} << (aPosition % 64); });
+            }
+        });
+}
+
+void CountingBloomFilter::addDependency(const DependencySet& aSet)
+{
+    for (size_t sWord = 0; sWord < aSet.words.size(); ++sWord)
+    {
+        const uint64_t sBits = aSet.words[sWord];
+        if (sBits == 0)
+        {
+            continue;
+        }
+
+        // Branch-free saturating increment of the 64 counters the word covers.
+        uint8_t* sCounters = counters.data() + sWord * 64;
+        for (uint32_t sBit = 0; sBit < 64; ++sBit)
+        {
+            sCounters[sBit] += ((sBits >> sBit) & 1) & (sCounters[sBit] != MAX_COUNT);
+        }
+    }
+}
+
+uint32_t CountingBloomFilter::getCount(uint64_t aId) const
+{
+    return withHashFunctionCount(
+        [&](auto aHashFunctionCount)
+        {
+            uint32_t sResult = MAX_COUNT;
+            forEachPosition<aHashFunctionCount>(
+                aId, [&](uint64_t aPosition) { sResult = std::min<uint32_t>(sResult, counters[aPosition]); });
+
+            return sResult;
+        });
+}
+
+uint64_t CountingBloomFilter::estimateMemoryUsage() const
+{
+    return counters.size() * sizeof(uint8_t);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "hashing.hpp"
+#include "random.hpp"
+#include "static_dispatch.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Bloom filter with a saturating 8-bit counter per position instead of a bit. Every dependency is first
+// collected into its own bit set (DependencySet) and then added as a whole, so a counter holds the number
+// of dependencies that set the position. The minimum over an id's positions bounds the number of
+// dependencies containing the id from above: threshold queries have false positives but no false negatives.
+class CountingBloomFilter
+{
+public:
+    static constexpr uint32_t MAX_COUNT               = UINT8_MAX;
+    static constexpr uint32_t MAX_HASH_FUNCTION_COUNT = 16;
+    // A dependency set needs at least one word, positions are taken from 40 bits at most.
+    static constexpr uint32_t MIN_COUNTER_COUNT_LOG2 = 6;
+    static constexpr uint32_t MAX_COUNTER_COUNT_LOG2 = 40;
+
+    struct DependencySet
+    {
+        std::vector<uint64_t> words;
+
+        DependencySet& operator|=(const DependencySet& aOther);
+    };
+
+    // Throws std::invalid_argument if aCounterCountLog2 is outside [MIN_COUNTER_COUNT_LOG2, MAX_COUNTER_COUNT_LOG2]
+    // or aNumberOfHashFunctions outside [1, MAX_HASH_FUNCTION_COUNT].
+    CountingBloomFilter(uint32_t aCounterCountLog2, uint32_t aNumberOfHashFunctions, uint64_t aSeed);
+
+    DependencySet makeDependencySet() const;
+    void          addIds(DependencySet& aSet, std::span<const uint64_t> aIds) const;
+    void          addDependency(const DependencySet& aSet);
+
+    // Upper bound of the number of dependencies containing aId, saturated at MAX_COUNT.
+    uint32_t getCount(uint64_t aId) const;
+    uint64_t estimateMemoryUsage() const;
+
+private:
+    uint32_t             counter_count_log2{0};
+    uint32_t             number_of_hash_functions{0};
+    uint64_t             seed{0};
+    std::vector<uint8_t> counters;
+
+    // Kirsch-Mitzenmacher double hashing: position i is h1 + i * h2, taken from the top bits. The hash function
+    // count is a template parameter so that the loop unrolls, see withHashFunctionCount().
+    template <uint32_t HASH_FUNCTION_COUNT, typename Consumer>
+    void forEachPosition(uint64_t aId, Consumer&& aConsumer) const
+    {
+        const uint64_t sFirst  = wangHash(aId ^ seed);
+        const uint64_t sSecond = splitMix64(sFirst) | 1;
+
+        for (uint32_t i = 0; i < HASH_FUNCTION_COUNT; ++i)
+        {
+            aConsumer((sFirst + i * sSecond) >> (64 - counter_count_log2));
+        }
+    }
+
+    // Calls aFunction with number_of_hash_functions as an std::integral_constant.
+    template <typename Function>
+    decltype(auto) withHashFunctionCount(Function&& aFunction) const
+    {
+        return dispatchConstant<1, MAX_HASH_FUNCTION_COUNT>(number_of_hash_functions,
+                                                            std::forward<Function>(aFunction));
+    }
+};
@@ -0,0 +1,235 @@
+#include "cuckoo_filter.hpp"
+
+#include "hashing.hpp"
+#include "random.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint64_t LOW_BITS  = 0x0001000100010001u;
+    constexpr uint64_t HIGH_BITS = 0x8000800080008000u;
+
+    uint16_t getSlot(uint64_t aBucket, uint32_t aSlot)
+    {
+        return static_cast<uint16_t>(aBucket >> (16 * aSlot));
+    }
+
+    void setSlot(uint64_t& aBucket, uint32_t aSlot, uint16_t aFingerprint)
+    {
+        aBucket = (aBucket & ~(uint64_t{0xFFFF} << (16 * aSlot))) | (uint64_t{aFingerprint} << (16 * aSlot));
+    }
+
+    // Whether any 16-bit slot of aBucket holds aFingerprint. Borrows can only flag slots above a real match, so
+    // the answer is exact.
+    bool hasFingerprint(uint64_t aBucket, uint16_t aFingerprint)
+    {
+        const uint64_t sDifference = aBucket ^ (aFingerprint * LOW_BITS);
+        return ((sDifference - LOW_BITS) & ~sDifference & HIGH_BITS) != 0;
+    }
+}  // namespace
+
+CuckooFilter::CuckooFilter(uint32_t aBucketCountLog2, uint64_t aSeed)
+: bucket_count_log2(std::clamp(aBucketCountLog2, 1u, 40u))
+, seed(aSeed)
+, buckets(uint64_t{1} << bucket_count_log2)
+{}
+
+bool CuckooFilter::insert(uint64_t aId)
+{
+    const auto sEntry = getEntry(aId);
+    return insertEntry(sEntry.bucket, sEntry.fingerprint);
+}
+
+bool CuckooFilter::erase(uint64_t aId)
+{
+    const auto sEntry = getEntry(aId);
+    return eraseEntry(sEntry.bucket, sEntry.fingerprint);
+}
+
+bool CuckooFilter::mayContain(uint64_t aId) const
+{
+    const auto sEntry = getEntry(aId);
+    return containsEntry(sEntry.bucket, sEntry.fingerprint);
+}
+
+template <typename Consumer>
+void CuckooFilter::forEachEntry(Consumer&& aConsumer) const
+{
+    for (uint64_t sBucket = 0; sBucket < buckets.size(); ++sBucket)
+    {
+        for (uint32_t sSlot = 0; sSlot < SLOTS_PER_BUCKET; ++sSlot)
+        {
+            if (const uint16_t sFingerprint = getSlot(buckets[sBucket], sSlot); sFingerprint != 0)
+            {
+                aConsumer(sBucket, sFingerprint);
+            }
+        }
+    }
+
+    if (has_victim)
+    {
+        aConsumer(victim_bucket, victim_fingerprint);
+    }
+}
+
+bool CuckooFilter::merge(const CuckooFilter& aOther)
+{
+    bool sResult = true;
+    aOther.forEachEntry(
+        [&](uint64_t aBucket, uint16_t aFingerprint)
+        {
+            // Equal entries may stem from different ids, so they are kept apart as insert() does. Otherwise
+            // erasing one of the ids would remove the other as well.
+            if (sResult)
+            {
+                sResult = insertEntry(aBucket, aFingerprint);
+            }
+        });
+
+    return sResult;
+}
+
+void CuckooFilter::intersect(const CuckooFilter& aOther)
+{
+    for (uint64_t sBucket = 0; sBucket < buckets.size(); ++sBucket)
+    {
+        for (uint32_t sSlot = 0; sSlot < SLOTS_PER_BUCKET; ++sSlot)
+        {
+            const uint16_t sFingerprint = getSlot(buckets[sBucket], sSlot);
+            if (sFingerprint != 0 && !aOther.containsEntry(sBucket, sFingerprint))
+            {
+                setSlot(buckets[sBucket], sSlot, 0);
+                --entry_count;
+            }
+        }
+    }
+
+    if (has_victim && !aOther.containsEntry(victim_bucket, victim_fingerprint))
+    {
+        has_victim = false;
+        --entry_count;
+    }
+}
+
+uint64_t CuckooFilter::size() const
+{
+    return entry_count;
+}
+
+uint64_t CuckooFilter::estimateMemoryUsage() const
+{
+    return buckets.size() * sizeof(uint64_t);
+}
+
+CuckooFilter::Entry CuckooFilter::getEntry(uint64_t aId) const
+{
+    // The top bits pick the bucket, the low 16 bits are the fingerprint. Zero marks an empty slot.
+    const uint64_t sHash        = wangHash(aId ^ seed);
+    const auto     sFingerprint = static_cast<uint16_t>(sHash);
+
+    return Entry{sHash >> (64 - bucket_count_log2), static_cast<uint16_t>(sFingerprint == 0 ? 1 : sFingerprint)};
+}
+
+uint64_t CuckooFilter::getAlternateBucket(uint64_t aBucket, uint16_t aFingerprint) const
+{
+    // An involution: the alternate bucket of the alternate bucket is the original one.
+    return aBucket ^ (splitMix64(aFingerprint) >> (64 - bucket_count_log2));
+}
+
+bool CuckooFilter::containsEntry(uint64_t aBucket, uint16_t aFingerprint) const
+{
+    const uint64_t sAlternate = getAlternateBucket(aBucket, aFingerprint);
+
+    return hasFingerprint(buckets[aBucket], aFingerprint) || hasFingerprint(buckets[sAlternate], aFingerprint)
+           || (has_victim && victim_fingerprint == aFingerprint
+               && (victim_bucket == aBucket || victim_bucket == sAlternate));
+}
+
+bool CuckooFilter::insertEntry(uint64_t aBucket, uint16_t aFingerprint)
+{
+    if (has_victim)
+    {
+        return false;
+    }
+
+    ++entry_count;
+
+    const auto sTryPlace = [this](uint64_t aIndex, uint16_t aValue)
+    {
+        for (uint32_t sSlot = 0; sSlot < SLOTS_PER_BUCKET; ++sSlot)
+        {
+            if (getSlot(buckets[aIndex], sSlot) == 0)
+            {
+                setSlot(buckets[aIndex], sSlot, aValue);
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    if (sTryPlace(aBucket, aFingerprint) || sTryPlace(getAlternateBucket(aBucket, aFingerprint), aFingerprint))
+    {
+        return true;
+    }
+
+    // Both buckets are full: evict a random entry to its alternate bucket, and so on.
+    uint64_t sBucket      = aBucket;
+    uint16_t sFingerprint = aFingerprint;
+    for (uint32_t sKick = 0; sKick < MAX_KICKS; ++sKick)
+    {
+        const uint32_t sSlot    = counterRandom(seed, entry_count * MAX_KICKS + sKick) % SLOTS_PER_BUCKET;
+        const uint16_t sEvicted = getSlot(buckets[sBucket], sSlot);
+        setSlot(buckets[sBucket], sSlot, sFingerprint);
+
+        sFingerprint = sEvicted;
+        sBucket      = getAlternateBucket(sBucket, sFingerprint);
+        if (sTryPlace(sBucket, sFingerprint))
+        {
+            return true;
+        }
+    }
+
+    has_victim         = true;
+    victim_bucket      = sBucket;
+    victim_fingerprint = sFingerprint;
+
+    return false;
+}
+
+bool CuckooFilter::eraseEntry(uint64_t aBucket, uint16_t aFingerprint)
+{
+    const uint64_t sAlternate = getAlternateBucket(aBucket, aFingerprint);
+
+    if (has_victim && victim_fingerprint == aFingerprint && (victim_bucket == aBucket || victim_bucket == sAlternate))
+    {
+        has_victim = false;
+        --entry_count;
+        return true;
+    }
+
+    for (uint64_t sBucket : {aBucket, sAlternate})
+    {
+        for (uint32_t sSlot = 0; sSlot < SLOTS_PER_BUCKET; ++sSlot)
+        {
+            if (getSlot(buckets[sBucket], sSlot) == aFingerprint)
+            {
+                setSlot(buckets[sBucket], sSlot, 0);
+                --entry_count;
+
+                // The freed slot makes room for the victim again.
+                if (has_victim)
+                {
+                    has_victim = false;
+                    --entry_count;
+                    insertEntry(victim_bucket, victim_fingerprint);
+                }
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
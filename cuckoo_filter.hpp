@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Partial-key cuckoo filter (Fan et al., "Cuckoo Filter: Practically Better Than Bloom") with four 16-bit
+// fingerprints per bucket, one 64-bit word each. An id lives in one of two buckets, the second derived from the
+// first and the fingerprint alone, so entries can be moved, erased and merged without the original ids.
+// False positive rate about 8 / 2^16 at full load; holds up to 95% of 4 * 2^aBucketCountLog2 ids.
+class CuckooFilter
+{
+public:
+    CuckooFilter(uint32_t aBucketCountLog2, uint64_t aSeed);
+
+    // Returns false when the filter is full. The id is still stored then, but further inserts fail.
+    bool insert(uint64_t aId);
+    // Removes one copy of aId. Erasing an id that was never inserted may remove an id sharing its fingerprint.
+    bool erase(uint64_t aId);
+    bool mayContain(uint64_t aId) const;
+
+    // Both filters must have the same bucket count and seed. Union adds every entry of aOther, also those already
+    // present, and returns false when the filter became full. Intersection keeps the entries also in aOther.
+    bool merge(const CuckooFilter& aOther);
+    void intersect(const CuckooFilter& aOther);
+
+    uint64_t size() const;
+    uint64_t estimateMemoryUsage() const;
+
+private:
+    static constexpr uint32_t SLOTS_PER_BUCKET = 4;
+    static constexpr uint32_t MAX_KICKS        = 500;
+
+    uint32_t              bucket_count_log2{0};
+    uint64_t              seed{0};
+    uint64_t              entry_count{0};
+    std::vector<uint64_t> buckets;
+    // An entry evicted by the last failed insert, kept so that the filter has no false negatives.
+    bool                  has_victim{false};
+    uint64_t              victim_bucket{0};
+    uint16_t              victim_fingerprint{0};
+
+    struct Entry
+    {
+        uint64_t bucket;
+        uint16_t fingerprint;
+    };
+
+    Entry    getEntry(uint64_t aId) const;
+    uint64_t getAlternateBucket(uint64_t aBucket, uint16_t aFingerprint) const;
+    bool     containsEntry(uint64_t aBucket, uint16_t aFingerprint) const;
+    bool     insertEntry(uint64_t aBucket, uint16_t aFingerprint);
+    bool     eraseEntry(uint64_t aBucket, uint16_t aFingerprint);
+    // Calls aConsumer(bucket, fingerprint) for every stored entry, including the victim.
+    template <typename Consumer>
+    void forEachEntry(Consumer&& aConsumer) const;
+};
@@ -1,5 +1,8 @@
 #include "estimators.hpp"
 
+#include "hashing.hpp"
+#include "hll_folding.hpp"
+
 #include <chrono>
 #include <iostream>
 #include <numeric>
@@ -19,7 +22,17 @@ void BaselineEstimator::addShardData(const std::vector<ShardData>& aShardData, u
     estimator.addShardData(aShardData, aPassCondition);
 }
 
-const std::set<uint64_t>& BaselineEstimator::getIds() const
+void BaselineEstimator::addDependencyData(const ShardData& aData)
+{
+    estimator.addDependencyData(aData);
+}
+
+void BaselineEstimator::finishDependencies(uint32_t aPassCondition)
+{
+    estimator.finishDependencies(aPassCondition);
+}
+
+const std::vector<uint64_t>& BaselineEstimator::getIds() const
 {
     return estimator.getIds();
 }
@@ -48,6 +61,16 @@ uint64_t RangeMinHashEstimator::estimateMemoryUsageImpl() const
     return sketch_size * sizeof(uint64_t);
 }
 
+SketchParameters RangeMinHashEstimator::getSketchParameters() const
+{
+    return {.parameter = sketch_size};
+}
+
+void RangeMinHashEstimator::addBatchToState(InternalStateType& aState, std::span<const uint64_t> aIds)
+{
+    forEachWangHash(aIds, [&aState](uint64_t aHash) { aState.add(aHash); });
+}
+
 BBitMinHashEstimator::BBitMinHashEstimator(uint64_t aHashBitCount)
 : hash_bit_count(aHashBitCount), min_hash(hash_bit_count)
 {}
@@ -72,13 +95,38 @@ uint64_t BBitMinHashEstimator::estimateMemoryUsageImpl() const
     return min_hash.size() * sizeof(uint64_t);
 }
 
-HyperLogLogEstimator::HyperLogLogEstimator(uint64_t sBucketCountLog2)
-: bucket_count_log2(sBucketCountLog2), hyper_log_log(bucket_count_log2, sketch::hll::ORIGINAL)
+SketchParameters BBitMinHashEstimator::getSketchParameters() const
+{
+    return {.parameter = hash_bit_count};
+}
+
+void BBitMinHashEstimator::addBatchToState(InternalStateType& aState, std::span<const uint64_t> aIds)
+{
+    forEachWangHash(aIds, [&aState](uint64_t aHash) { aState.add(aHash); });
+}
+
+HyperLogLogEstimator::HyperLogLogEstimator(uint64_t sBucketCountLog2, sketch::hll::EstimationMethod aMethod)
+: bucket_count_log2(sBucketCountLog2)
+, estimation_method(aMethod)
+, hyper_log_log(constructDefault())
 {}
 
+HyperLogLogEstimator HyperLogLogEstimator::fold(uint64_t aBucketCountLog2) const
+{
+    Timer sTimer(Name + " register folding");
+
+    HyperLogLogEstimator sResult(aBucketCountLog2, estimation_method);
+    auto&                sFolded = sResult.hyper_log_log.densify();
+    details::foldHyperLogLogRegisters(
+        hyper_log_log.getRegisters(), bucket_count_log2, aBucketCountLog2, sFolded.core());
+    sFolded.sum();
+
+    return sResult;
+}
+
 HyperLogLogEstimator::InternalStateType HyperLogLogEstimator::constructDefault() const
 {
-    return sketch::hll_t(bucket_count_log2, sketch::hll::ORIGINAL);
+    return SparseHyperLogLog(static_cast<uint32_t>(bucket_count_log2), estimation_method);
 }
 
 HyperLogLogEstimator::InternalStateType& HyperLogLogEstimator::getInternalState()
@@ -92,6 +140,88 @@ const HyperLogLogEstimator::InternalStateType& HyperLogLogEstimator::getInternal
 
 uint64_t HyperLogLogEstimator::estimateMemoryUsageImpl() const
 {
-    auto sRes = hyper_log_log.est_memory_usage();
-    return sRes.first + sRes.second;
-}
\ No newline at end of file
+    return hyper_log_log.estimateMemoryUsage();
+}
+
+SketchParameters HyperLogLogEstimator::getSketchParameters() const
+{
+    return {.parameter = bucket_count_log2, .secondary_parameter = static_cast<uint64_t>(estimation_method)};
+}
+
+void HyperLogLogEstimator::addBatchToState(InternalStateType& aState, std::span<const uint64_t> aIds)
+{
+    forEachWangHash(aIds, [&aState](uint64_t aHash) { aState.add(aHash); });
+}
+
+KOfNCoverageEstimator::KOfNCoverageEstimator(uint32_t aSampleSize, uint32_t aPassCondition)
+: pass_condition(aPassCondition), sample(aSampleSize)
+{}
+
+uint64_t KOfNCoverageEstimator::estimateCoverage() const
+{
+    return static_cast<uint64_t>(sample.countAtLeastEstimate(pass_condition));
+}
+
+void KOfNCoverageEstimator::addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition)
+{
+    ThreadPool sPool(ingestion_options.worker_count);
+
+    Timer sTimer(Name + " coverage calculation", getCoverageCalculationTotal(ingestion_options));
+    pass_condition = aPassCondition;
+    for (const auto& sDep : aShardData)
+    {
+        addDependency(sDep, sPool);
+    }
+}
+
+void KOfNCoverageEstimator::addDependencyData(const ShardData& aData)
+{
+    ThreadPool sPool(ingestion_options.worker_count);
+
+    Timer sTimer(Name + " coverage calculation", getCoverageCalculationTotal(ingestion_options));
+    addDependency(aData, sPool);
+}
+
+void KOfNCoverageEstimator::addDependency(const ShardData& aData, ThreadPool& aPool)
+{
+    sample += buildDependencyState(
+        aData,
+        aPool,
+        ingestion_options,
+        {.parameter = sample.getSampleSize()},
+        Name + " merge shard data",
+        estimateMemoryUsage(),
+        [this] { return CountingBottomKSketch(sample.getSampleSize()); },
+        addBatchToState,
+        [](CountingBottomKSketch& aLeft, const CountingBottomKSketch& aRight) { aLeft += aRight; });
+}
+
+uint64_t KOfNCoverageEstimator::estimateMemoryUsage() const
+{
+    return sample.estimateMemoryUsage();
+}
+
+void KOfNCoverageEstimator::addBatch(std::span<const uint64_t> aIds)
+{
+    addBatchToState(sample, aIds);
+}
+
+void KOfNCoverageEstimator::setWorkerCount(uint32_t aWorkerCount)
+{
+    ingestion_options.worker_count = std::max(aWorkerCount, 1u);
+}
+
+void KOfNCoverageEstimator::setIngestionMode(IngestionMode aMode)
+{
+    ingestion_options.mode = aMode;
+}
+
+void KOfNCoverageEstimator::setIngestionTimes(IngestionTimes* aTimes)
+{
+    ingestion_options.times = aTimes;
+}
+
+void KOfNCoverageEstimator::addBatchToState(CountingBottomKSketch& aState, std::span<const uint64_t> aIds)
+{
+    forEachWangHash(aIds, [&aState](uint64_t aHash) { aState.add(aHash); });
+}
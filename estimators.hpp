@@ -1,11 +1,17 @@
 #pragma once
 
 #include "baseline_common.hpp"
+#include "bottom_k_sketch.hpp"
 #include "common.hpp"
+#include "ingestion.hpp"
 #include "shard_data.hpp"
+#include "sketch_serialization.hpp"
+#include "sketch_wire_format.hpp"
 
+#include <algorithm>
 #include <optional>
-#include <set>
+#include <variant>
+#include <vector>
 
 #include <sketch/bbmh.h>
 #include <sketch/hll.h>
@@ -19,13 +25,16 @@ public:
     virtual uint64_t estimateMemoryUsage() const                                                     = 0;
 };
 
-class BaselineEstimator : public CoverageEstimator
+class BaselineEstimator final : public CoverageEstimator
 {
 public:
     uint64_t estimateCoverage() const override;
     void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition) override;
     uint64_t estimateMemoryUsage() const override;
-    const std::set<uint64_t>& getIds() const;
+    // See BaselineCommon::addDependencyData.
+    void     addDependencyData(const ShardData& aData);
+    void     finishDependencies(uint32_t aPassCondition);
+    const std::vector<uint64_t>& getIds() const;
 
 private:
     BaselineCommon estimator;
@@ -47,41 +56,13 @@ public:
 
     void addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition) override
     {
-        const auto sConvertDependencyToInternalState = [this](const ShardData& aData)
-        {
-            const auto sConvertShardResponseToInternalState
-                = [&](const std::unordered_set<uint64_t>& aShardData)
-            {
-                typename CustomEstimatorType::InternalStateType sInternalState
-                    = getDerived()->constructDefault();
-
-                for (auto sId : aShardData)
-                {
-                    sInternalState.addh(sId);
-                }
+        ThreadPool sPool(ingestion_options.worker_count);
 
-                return sInternalState;
-            };
+        const auto sConvertDependencyToInternalState
+            = [this, &sPool](const ShardData& aData) { return buildInternalState(aData, sPool); };
 
-            std::vector<typename CustomEstimatorType::InternalStateType> sShardInternalStates;
-            std::transform(aData.data.begin(),
-                           aData.data.end(),
-                           std::back_inserter(sShardInternalStates),
-                           [&sConvertShardResponseToInternalState](const auto& aShardData)
-                           { return sConvertShardResponseToInternalState(aShardData); });
-
-            Timer sTimer(CustomEstimatorType::Name + " merge shard data");
-            typename CustomEstimatorType::InternalStateType sInternalState = sShardInternalStates[0];
-
-            for (size_t i = 1; i < sShardInternalStates.size(); ++i)
-            {
-                sInternalState += sShardInternalStates[i];
-            }
-
-            return sInternalState;
-        };
-
-        Timer sTimer(CustomEstimatorType::Name + " coverage calculation");
+        Timer sTimer(CustomEstimatorType::Name + " coverage calculation",
+                     getCoverageCalculationTotal(ingestion_options));
         if (aPassCondition == 2 && aShardData.size() == 2)
         {
             const auto sFirstConverted = sConvertDependencyToInternalState(aShardData[0]);
@@ -99,17 +80,103 @@ public:
         }
     }
 
+    // Adds the union of one dependency, for callers that get the dependencies one at a time, see
+    // streamShardDataFromDependencies. Equivalent to addShardData with pass condition 1 spread over the calls.
+    void addDependencyData(const ShardData& aData)
+    {
+        ThreadPool sPool(ingestion_options.worker_count);
+
+        Timer sTimer(CustomEstimatorType::Name + " coverage calculation",
+                     getCoverageCalculationTotal(ingestion_options));
+        getDerived()->getInternalState() += buildInternalState(aData, sPool);
+    }
+
     uint64_t estimateMemoryUsage() const { return getDerived()->estimateMemoryUsageImpl(); }
 
+    void addBatch(std::span<const uint64_t> aIds)
+    {
+        CustomEstimatorType::addBatchToState(getDerived()->getInternalState(), aIds);
+    }
+
+    void setWorkerCount(uint32_t aWorkerCount) { ingestion_options.worker_count = std::max(aWorkerCount, 1u); }
+
+    void setIngestionMode(IngestionMode aMode) { ingestion_options.mode = aMode; }
+
+    // Only pays off for callers that rebuild sketches of the same shards with the same parameters, such as
+    // BM_CachedDependencyBuild. The driver sweeps change the parameters every step. The shard data passed in
+    // afterwards needs its shard fingerprints, see fingerprintShards.
+    void setSketchCache(SketchCache* aCache) { ingestion_options.sketch_cache = aCache; }
+
+    void setIngestionTimes(IngestionTimes* aTimes) { ingestion_options.times = aTimes; }
+
+    // Builds one sketch per shard of aData and appends them to aWriter, in shard order.
+    void storeShardSketches(const ShardData& aData, SketchStoreWriter& aWriter) const
+    {
+        ThreadPool sPool(ingestion_options.worker_count);
+
+        const auto sFillShardState = [&](size_t aShardIndex)
+        {
+            auto sState = getDerived()->constructDefault();
+            CustomEstimatorType::addBatchToState(sState, aData.shard(aShardIndex));
+
+            return sState;
+        };
+
+        for (const auto& sState : parallelTransform(sPool, aData.shardCount(), sFillShardState))
+        {
+            appendSketch(aWriter, sState, getDerived()->getSketchParameters());
+        }
+    }
+
+    // Merges every sketch of aStore into the internal state without re-ingesting any ids.
+    void addStoredSketches(const MappedSketchStore& aStore)
+    {
+        Timer sTimer(CustomEstimatorType::Name + " merge stored sketches");
+        for (size_t i = 0; i < aStore.size(); ++i)
+        {
+            mergeStoredSketch(getDerived()->getInternalState(), aStore[i], getDerived()->getSketchParameters());
+        }
+    }
+
+    // Builds the sketch of a single shard and encodes it for shipping to an aggregating node.
+    std::vector<std::byte> encodeShardSketch(std::span<const uint64_t> aIds) const
+    {
+        auto sState = getDerived()->constructDefault();
+        CustomEstimatorType::addBatchToState(sState, aIds);
+
+        return encodeSketch(sState, getDerived()->getSketchParameters());
+    }
+
+    // Merges a sketch encoded by encodeShardSketch() of an estimator with the same parameters.
+    void addEncodedSketch(std::span<const std::byte> aMessage)
+    {
+        mergeEncodedSketch(getDerived()->getInternalState(), aMessage, getDerived()->getSketchParameters());
+    }
+
 private:
     CustomEstimatorType* getDerived() { return static_cast<CustomEstimatorType*>(this); }
 
     const CustomEstimatorType* getDerived() const { return static_cast<const CustomEstimatorType*>(this); }
 
+    auto buildInternalState(const ShardData& aData, ThreadPool& aPool) const
+    {
+        return buildDependencyState(
+            aData,
+            aPool,
+            ingestion_options,
+            getDerived()->getSketchParameters(),
+            CustomEstimatorType::Name + " merge shard data",
+            estimateMemoryUsage(),
+            [this] { return getDerived()->constructDefault(); },
+            [](auto& aState, std::span<const uint64_t> aIds) { CustomEstimatorType::addBatchToState(aState, aIds); },
+            [](auto& aLeft, const auto& aRight) { aLeft += aRight; });
+    }
+
     std::optional<uint64_t> intersection_size;
+    IngestionOptions        ingestion_options;
 };
 
-class RangeMinHashEstimator : public CustomEstimatorBase<RangeMinHashEstimator>
+class RangeMinHashEstimator final : public CustomEstimatorBase<RangeMinHashEstimator>
 {
 public:
     using InternalStateType              = sketch::RangeMinHash<uint64_t>;
@@ -121,13 +188,16 @@ public:
     InternalStateType&       getInternalState();
     const InternalStateType& getInternalState() const;
     uint64_t                 estimateMemoryUsageImpl() const;
+    SketchParameters         getSketchParameters() const;
+
+    static void addBatchToState(InternalStateType& aState, std::span<const uint64_t> aIds);
 
 private:
     uint64_t                       sketch_size{0};
     sketch::RangeMinHash<uint64_t> min_hash;
 };
 
-class BBitMinHashEstimator : public CustomEstimatorBase<BBitMinHashEstimator>
+class BBitMinHashEstimator final : public CustomEstimatorBase<BBitMinHashEstimator>
 {
 public:
     using InternalStateType              = sketch::BBitMinHasher<uint64_t>;
@@ -139,26 +209,133 @@ public:
     InternalStateType&       getInternalState();
     const InternalStateType& getInternalState() const;
     uint64_t                 estimateMemoryUsageImpl() const;
+    SketchParameters         getSketchParameters() const;
+
+    static void addBatchToState(InternalStateType& aState, std::span<const uint64_t> aIds);
 
 private:
     uint64_t                        hash_bit_count{0};
     sketch::BBitMinHasher<uint64_t> min_hash;
 };
 
-class HyperLogLogEstimator : public CustomEstimatorBase<HyperLogLogEstimator>
+class HyperLogLogEstimator final : public CustomEstimatorBase<HyperLogLogEstimator>
 {
 public:
-    using InternalStateType              = sketch::hll_t;
+    using InternalStateType              = SparseHyperLogLog;
     inline static const std::string Name = "HyperLogLogEstimator";
 
-    HyperLogLogEstimator(uint64_t sBucketCountLog2);
+    // Per-shard and merged states start sparse and turn dense as they fill, aMethod picks how the dense
+    // registers are turned into an estimate.
+    HyperLogLogEstimator(uint64_t                      sBucketCountLog2,
+                         sketch::hll::EstimationMethod aMethod = sketch::hll::ORIGINAL);
+
+    // Estimator over the same ids at a lower precision, derived from the registers without re-ingestion.
+    // Only the union state is folded, an intersection computed by addShardData is not carried over.
+    HyperLogLogEstimator fold(uint64_t aBucketCountLog2) const;
 
     InternalStateType        constructDefault() const;
     InternalStateType&       getInternalState();
     const InternalStateType& getInternalState() const;
     uint64_t                 estimateMemoryUsageImpl() const;
+    SketchParameters         getSketchParameters() const;
+
+    static void addBatchToState(InternalStateType& aState, std::span<const uint64_t> aIds);
+
+private:
+    uint64_t                      bucket_count_log2{0};
+    sketch::hll::EstimationMethod estimation_method;
+    SparseHyperLogLog             hyper_log_log;
+};
+
+// Estimates the number of ids present at least aPassCondition times across the dependencies for any pass
+// condition, where the other sketches only handle unions and the two-dependency intersection. All
+// dependencies share one counting bottom-k sample, so the estimate takes a single pass over the shards.
+class KOfNCoverageEstimator final : public CoverageEstimator
+{
+public:
+    inline static const std::string Name = "KOfNCoverageEstimator";
+
+    // aPassCondition is the k estimated for dependencies added by addDependencyData, addShardData replaces it.
+    KOfNCoverageEstimator(uint32_t aSampleSize, uint32_t aPassCondition = 1);
+
+    uint64_t estimateCoverage() const override;
+    void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition) override;
+    uint64_t estimateMemoryUsage() const override;
+
+    // Counts the ids of one dependency, for callers that get the dependencies one at a time. The sample keeps
+    // the counts, so any pass condition can be evaluated afterwards.
+    void addDependencyData(const ShardData& aData);
+
+    void addBatch(std::span<const uint64_t> aIds);
+    void setWorkerCount(uint32_t aWorkerCount);
+    void setIngestionMode(IngestionMode aMode);
+    void setIngestionTimes(IngestionTimes* aTimes);
+
+    static void addBatchToState(CountingBottomKSketch& aState, std::span<const uint64_t> aIds);
 
 private:
-    uint64_t      bucket_count_log2{0};
-    sketch::hll_t hyper_log_log;
-};
\ No newline at end of file
+    void addDependency(const ShardData& aData, ThreadPool& aPool);
+
+    uint32_t              pass_condition{1};
+    CountingBottomKSketch sample;
+    IngestionOptions      ingestion_options;
+};
+
+// Runtime choice between the estimators without virtual calls: std::visit switches on the index once per call,
+// and since every alternative is final the member call inside is direct and can be inlined.
+using AnyCoverageEstimator = std::variant<BaselineEstimator,
+                                          HyperLogLogEstimator,
+                                          BBitMinHashEstimator,
+                                          RangeMinHashEstimator,
+                                          KOfNCoverageEstimator>;
+
+inline uint64_t estimateCoverage(const AnyCoverageEstimator& aEstimator)
+{
+    return std::visit([](const auto& aAlternative) { return aAlternative.estimateCoverage(); }, aEstimator);
+}
+
+inline void addShardData(AnyCoverageEstimator&         aEstimator,
+                         const std::vector<ShardData>& aShardData,
+                         uint32_t                      aPassCondition)
+{
+    std::visit([&](auto& aAlternative) { aAlternative.addShardData(aShardData, aPassCondition); }, aEstimator);
+}
+
+inline uint64_t estimateMemoryUsage(const AnyCoverageEstimator& aEstimator)
+{
+    return std::visit([](const auto& aAlternative) { return aAlternative.estimateMemoryUsage(); }, aEstimator);
+}
+
+// One dispatch per dependency, the batches of its shards then go straight to the chosen alternative.
+inline void addDependencyData(AnyCoverageEstimator& aEstimator, const ShardData& aData)
+{
+    std::visit([&](auto& aAlternative) { aAlternative.addDependencyData(aData); }, aEstimator);
+}
+
+// The baseline keeps every id as is, the ingestion mode does not apply to it.
+inline void setIngestionMode(AnyCoverageEstimator& aEstimator, IngestionMode aMode)
+{
+    std::visit(
+        [aMode](auto& aAlternative)
+        {
+            if constexpr (requires { aAlternative.setIngestionMode(aMode); })
+            {
+                aAlternative.setIngestionMode(aMode);
+            }
+        },
+        aEstimator);
+}
+
+// Not owned, see IngestionOptions::times. The baseline reports its times through its spans only.
+inline void setIngestionTimes(AnyCoverageEstimator& aEstimator, IngestionTimes* aTimes)
+{
+    std::visit(
+        [aTimes](auto& aAlternative)
+        {
+            if constexpr (requires { aAlternative.setIngestionTimes(aTimes); })
+            {
+                aAlternative.setIngestionTimes(aTimes);
+            }
+        },
+        aEstimator);
+}
@@ -0,0 +1,14 @@
+#include "experiment_arena.hpp"
+
+ExperimentArena::ExperimentArena(size_t aInitialSize) : resource(aInitialSize) {}
+
+std::pmr::memory_resource* ExperimentArena::getResource()
+{
+    return &resource;
+}
+
+void ExperimentArena::reset()
+{
+    // Returns every block upstream, none is kept for reuse.
+    resource.release();
+}
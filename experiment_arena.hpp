@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Monotonic arena for the data of one experiment: allocation is a pointer bump, deallocation a no-op, and
+// reset() frees everything at once between experiments. The blocks go back to the upstream allocator, the next
+// experiment allocates fresh ones, growing again from the initial size. Everything allocated from the arena must
+// be destroyed before reset(). Not thread-safe: allocate from it on one thread only.
+class ExperimentArena
+{
+public:
+    explicit ExperimentArena(size_t aInitialSize = size_t{1} << 20);
+
+    ExperimentArena(const ExperimentArena&)            = delete;
+    ExperimentArena& operator=(const ExperimentArena&) = delete;
+
+    std::pmr::memory_resource* getResource();
+    void                       reset();
+
+private:
+    std::pmr::monotonic_buffer_resource resource;
+};
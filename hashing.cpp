@@ -0,0 +1,75 @@
+#include "hashing.hpp"
+
+#include <immintrin.h>
+
+namespace
+{
+#if defined(__AVX512F__)
+    constexpr size_t LANES = 8;
+
+    // Zero-masked shifts: the unmasked intrinsics read an undefined register that GCC 12 flags
+    // with -Wmaybe-uninitialized.
+    inline __m512i shiftLeft(__m512i aValue, unsigned aCount)
+    {
+        return _mm512_maskz_slli_epi64(0xFF, aValue, aCount);
+    }
+
+    inline __m512i shiftRight(__m512i aValue, unsigned aCount)
+    {
+        return _mm512_maskz_srli_epi64(0xFF, aValue, aCount);
+    }
+
+    void wangHashBlock(const uint64_t* aIds, uint64_t* aHashes)
+    {
+        __m512i sKey = _mm512_loadu_si512(aIds);
+
+        sKey = _mm512_add_epi64(_mm512_xor_si512(sKey, _mm512_set1_epi64(-1)), shiftLeft(sKey, 21));
+        sKey = _mm512_xor_si512(sKey, shiftRight(sKey, 24));
+        sKey = _mm512_add_epi64(_mm512_add_epi64(sKey, shiftLeft(sKey, 3)), shiftLeft(sKey, 8));
+        sKey = _mm512_xor_si512(sKey, shiftRight(sKey, 14));
+        sKey = _mm512_add_epi64(_mm512_add_epi64(sKey, shiftLeft(sKey, 2)), shiftLeft(sKey, 4));
+        sKey = _mm512_xor_si512(sKey, shiftRight(sKey, 28));
+        sKey = _mm512_add_epi64(sKey, shiftLeft(sKey, 31));
+
+        _mm512_storeu_si512(aHashes, sKey);
+    }
+#elif defined(__AVX2__)
+    constexpr size_t LANES = 4;
+
+    void wangHashBlock(const uint64_t* aIds, uint64_t* aHashes)
+    {
+        __m256i sKey = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aIds));
+
+        sKey = _mm256_add_epi64(_mm256_xor_si256(sKey, _mm256_set1_epi64x(-1)), _mm256_slli_epi64(sKey, 21));
+        sKey = _mm256_xor_si256(sKey, _mm256_srli_epi64(sKey, 24));
+        sKey = _mm256_add_epi64(_mm256_add_epi64(sKey, _mm256_slli_epi64(sKey, 3)), _mm256_slli_epi64(sKey, 8));
+        sKey = _mm256_xor_si256(sKey, _mm256_srli_epi64(sKey, 14));
+        sKey = _mm256_add_epi64(_mm256_add_epi64(sKey, _mm256_slli_epi64(sKey, 2)), _mm256_slli_epi64(sKey, 4));
+        sKey = _mm256_xor_si256(sKey, _mm256_srli_epi64(sKey, 28));
+        sKey = _mm256_add_epi64(sKey, _mm256_slli_epi64(sKey, 31));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(aHashes), sKey);
+    }
+#else
+    constexpr size_t LANES = 1;
+
+    void wangHashBlock(const uint64_t* aIds, uint64_t* aHashes)
+    {
+        *aHashes = wangHash(*aIds);
+    }
+#endif
+}  // namespace
+
+void wangHashBatch(std::span<const uint64_t> aIds, std::span<uint64_t> aHashes)
+{
+    size_t i = 0;
+    for (; i + LANES <= aIds.size(); i += LANES)
+    {
+        wangHashBlock(aIds.data() + i, aHashes.data() + i);
+    }
+
+    for (; i < aIds.size(); ++i)
+    {
+        aHashes[i] = wangHash(aIds[i]);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Thomas Wang's 64-bit integer mix, the default hash of the sketch library: sketches that accept
+// pre-hashed values via add() produce the same state as with addh() when fed with these hashes.
+inline uint64_t wangHash(uint64_t aKey)
+{
+    aKey = (~aKey) + (aKey << 21);
+    aKey = aKey ^ (aKey >> 24);
+    aKey = (aKey + (aKey << 3)) + (aKey << 8);
+    aKey = aKey ^ (aKey >> 14);
+    aKey = (aKey + (aKey << 2)) + (aKey << 4);
+    aKey = aKey ^ (aKey >> 28);
+    aKey = aKey + (aKey << 31);
+    return aKey;
+}
+
+// aHashes must be at least as long as aIds. Uses AVX-512 or AVX2 when the target supports them.
+void wangHashBatch(std::span<const uint64_t> aIds, std::span<uint64_t> aHashes);
+
+constexpr size_t HASH_BATCH_SIZE = 256;
+
+// Hashes aIds in blocks of HASH_BATCH_SIZE and hands every hash to aConsumer in input order.
+template <typename Consumer>
+void forEachWangHash(std::span<const uint64_t> aIds, Consumer&& aConsumer)
+{
+    alignas(64) uint64_t sHashes[HASH_BATCH_SIZE];
+
+    for (size_t sOffset = 0; sOffset < aIds.size(); sOffset += HASH_BATCH_SIZE)
+    {
+        const auto sBlock = aIds.subspan(sOffset, std::min(HASH_BATCH_SIZE, aIds.size() - sOffset));
+        wangHashBatch(sBlock, sHashes);
+
+        for (size_t i = 0; i < sBlock.size(); ++i)
+        {
+            aConsumer(sHashes[i]);
+        }
+    }
+}
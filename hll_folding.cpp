@@ -0,0 +1,40 @@
+#include "hll_folding.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace details
+{
+    void foldHyperLogLogRegisters(std::span<const uint8_t> aRegisters,
+                                  uint32_t                 aPrecision,
+                                  uint32_t                 aTargetPrecision,
+                                  std::span<uint8_t>       aResult)
+    {
+        if (aTargetPrecision > aPrecision || aRegisters.size() != (size_t{1} << aPrecision)
+            || aResult.size() != (size_t{1} << aTargetPrecision))
+        {
+            throw std::invalid_argument("HyperLogLog registers can only be folded to a lower precision");
+        }
+
+        const uint32_t sDroppedBits = aPrecision - aTargetPrecision;
+        const size_t   sGroupSize   = size_t{1} << sDroppedBits;
+
+        for (size_t sTarget = 0; sTarget < aResult.size(); ++sTarget)
+        {
+            const auto sGroup = aRegisters.subspan(sTarget * sGroupSize, sGroupSize);
+
+            // The first register of the group has no dropped bits set: its rank only grows by sDroppedBits.
+            uint8_t sRank = sGroup[0] ? sGroup[0] + sDroppedBits : 0;
+            for (size_t sDropped = 1; sDropped < sGroupSize; ++sDropped)
+            {
+                if (sGroup[sDropped])
+                {
+                    sRank = std::max<uint8_t>(sRank, sDroppedBits - std::bit_width(sDropped) + 1);
+                }
+            }
+
+            aResult[sTarget] = sRank;
+        }
+    }
+}  // namespace details
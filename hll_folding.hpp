@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace details
+{
+    // Folds the 2^aPrecision registers of an HLL down to the 2^aTargetPrecision registers aResult, giving exactly
+    // the registers an HLL of the lower precision would have after seeing the same hashes. Register i becomes
+    // i >> d with d = aPrecision - aTargetPrecision; the d dropped index bits are prepended to the rank word, so
+    // a non-zero dropped part fixes the new rank and a zero one adds d to the old rank.
+    void foldHyperLogLogRegisters(std::span<const uint8_t> aRegisters,
+                                  uint32_t                 aPrecision,
+                                  uint32_t                 aTargetPrecision,
+                                  std::span<uint8_t>       aResult);
+}  // namespace details
@@ -0,0 +1,95 @@
+#include "hll_sparse_registers.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // Keeps the first compactions from running after every few adds.
+    constexpr size_t MIN_PENDING_ENTRIES = 64;
+}  // namespace
+
+SparseHyperLogLogRegisters::SparseHyperLogLogRegisters(uint32_t aPrecision) : precision(aPrecision)
+{
+    if (precision == 0 || precision > MAX_PRECISION)
+    {
+        throw std::invalid_argument("Sparse HyperLogLog precision must be in [1, 24]");
+    }
+}
+
+void SparseHyperLogLogRegisters::add(uint64_t aHash)
+{
+    const auto sIndex = static_cast<uint32_t>(aHash >> (64 - precision));
+    const auto sRank  = static_cast<uint32_t>(__builtin_clzll(((aHash << 1) | 1) << (precision - 1)) + 1);
+
+    entries.push_back(sIndex << RANK_BITS | sRank);
+    compactIfNeeded();
+}
+
+void SparseHyperLogLogRegisters::addRegister(uint32_t aIndex, uint8_t aRank)
+{
+    entries.push_back(aIndex << RANK_BITS | aRank);
+    compactIfNeeded();
+}
+
+void SparseHyperLogLogRegisters::merge(const SparseHyperLogLogRegisters& aOther)
+{
+    entries.insert(entries.end(), aOther.entries.begin(), aOther.entries.end());
+    compactIfNeeded();
+}
+
+void SparseHyperLogLogRegisters::compact()
+{
+    const auto sMiddle = entries.begin() + static_cast<std::ptrdiff_t>(sorted_count);
+    std::sort(sMiddle, entries.end());
+    std::inplace_merge(entries.begin(), sMiddle, entries.end());
+
+    // Entries of one index are adjacent with ascending ranks, the last one wins.
+    size_t sOut = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (sOut > 0 && (entries[sOut - 1] >> RANK_BITS) == (entries[i] >> RANK_BITS))
+        {
+            entries[sOut - 1] = entries[i];
+        }
+        else
+        {
+            entries[sOut++] = entries[i];
+        }
+    }
+
+    entries.resize(sOut);
+    sorted_count = sOut;
+}
+
+size_t SparseHyperLogLogRegisters::size() const
+{
+    return entries.size();
+}
+
+void SparseHyperLogLogRegisters::fillRegisters(std::span<uint8_t> aRegisters) const
+{
+    for (auto sEntry : entries)
+    {
+        auto& sRegister = aRegisters[sEntry >> RANK_BITS];
+        sRegister       = std::max(sRegister, static_cast<uint8_t>(sEntry & RANK_MASK));
+    }
+}
+
+uint32_t SparseHyperLogLogRegisters::getPrecision() const
+{
+    return precision;
+}
+
+uint64_t SparseHyperLogLogRegisters::estimateMemoryUsage() const
+{
+    return sizeof(*this) + entries.capacity() * sizeof(uint32_t);
+}
+
+void SparseHyperLogLogRegisters::compactIfNeeded()
+{
+    if (entries.size() - sorted_count > std::max(sorted_count, MIN_PENDING_ENTRIES))
+    {
+        compact();
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Non-zero registers of a HyperLogLog as a sorted list of (index, rank) entries, four bytes each instead of the
+// 2^aPrecision bytes of the dense registers: the sparse representation of Heule et al., "HyperLogLog in
+// Practice". Entries keep the dense index, so fillRegisters() recovers exactly the registers of a dense sketch
+// that saw the same hashes. New entries are appended unsorted and folded into the sorted ones by compact().
+class SparseHyperLogLogRegisters
+{
+public:
+    // Larger precisions do not fit an entry.
+    static constexpr uint32_t MAX_PRECISION = 24;
+
+    // Throws std::invalid_argument for a precision outside [1, MAX_PRECISION].
+    explicit SparseHyperLogLogRegisters(uint32_t aPrecision);
+
+    // Same index and rank as sketch::hll_t::add(aHash).
+    void add(uint64_t aHash);
+    // Raises the register aIndex to aRank, which must be non-zero.
+    void addRegister(uint32_t aIndex, uint8_t aRank);
+    // Both lists must have the same precision.
+    void merge(const SparseHyperLogLogRegisters& aOther);
+    // Sorts the appended entries in and keeps the highest rank per index. add() and merge() compact once the
+    // appended entries outnumber the sorted ones, so the list stays within about twice the non-zero register count.
+    void compact();
+
+    // Entry count, entries of the same index that were not compacted yet are counted separately.
+    size_t size() const;
+    // Raises every register of aRegisters, 2^getPrecision() of them, to the rank of its entry.
+    void   fillRegisters(std::span<uint8_t> aRegisters) const;
+
+    // Calls aConsumer(index, rank) for every entry. After compact() that is every non-zero register once, in
+    // index order.
+    template <typename Consumer>
+    void forEachRegister(Consumer&& aConsumer) const
+    {
+        for (auto sEntry : entries)
+        {
+            aConsumer(sEntry >> RANK_BITS, static_cast<uint8_t>(sEntry & RANK_MASK));
+        }
+    }
+
+    uint32_t getPrecision() const;
+    uint64_t estimateMemoryUsage() const;
+
+private:
+    static constexpr uint32_t RANK_BITS = 8;
+    static constexpr uint32_t RANK_MASK = (uint32_t{1} << RANK_BITS) - 1;
+
+    uint32_t precision{0};
+    // index << 8 | rank, the first sorted_count are sorted with one entry per index.
+    std::vector<uint32_t> entries;
+    size_t                sorted_count{0};
+
+    void compactIfNeeded();
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "common.hpp"
+#include "estimators.hpp"
+#include "merge_tree.hpp"
+#include "sketch_cache.hpp"
+#include "thread_pool.hpp"
+
+#include <span>
+#include <vector>
+
+// Keeps a merge tree of per-shard states for every dependency of a CustomEstimatorBase estimator, so that a
+// changed or new shard response costs one shard ingestion plus O(log shards) merges for the affected
+// dependency, followed by a merge of the dependency roots, instead of a rebuild of everything.
+template <typename Estimator>
+class IncrementalEstimator final : public CoverageEstimator
+{
+public:
+    using StateType = typename Estimator::InternalStateType;
+
+    template <typename... Args>
+    explicit IncrementalEstimator(Args&&... aArgs) : estimator(std::forward<Args>(aArgs)...)
+    {}
+
+    uint64_t estimateCoverage() const override { return coverage; }
+
+    // Replaces every dependency, the per-shard states are built in parallel.
+    void addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition) override
+    {
+        ThreadPool sPool(worker_count);
+
+        Timer sTimer(Estimator::Name + " incremental build coverage calculation");
+        pass_condition = aPassCondition;
+        dependency_trees.clear();
+        for (const auto& sDep : aShardData)
+        {
+            auto sShardStates = parallelTransform(
+                sPool, sDep.shardCount(), [&](size_t aShardIndex) { return buildShardState(sDep.shard(aShardIndex)); });
+            dependency_trees.emplace_back(std::move(sShardStates), estimator.constructDefault());
+        }
+
+        updateCoverage();
+    }
+
+    // Sums the nodes one by one: states such as SparseHyperLogLog grow from sparse to dense as ids are added.
+    uint64_t estimateMemoryUsage() const override
+    {
+        const uint64_t sEmptyStateBytes = estimator.estimateMemoryUsage();
+
+        uint64_t sBytes = 0;
+        for (const auto& sTree : dependency_trees)
+        {
+            sTree.forEachNode([&](const StateType& aState) { sBytes += getStateBytes(aState, sEmptyStateBytes); });
+        }
+
+        return sBytes;
+    }
+
+    void replaceShard(size_t aDependency, size_t aShard, std::span<const uint64_t> aIds)
+    {
+        auto sState = buildShardState(aIds);
+
+        Timer sTimer(Estimator::Name + " shard update merge");
+        dependency_trees.at(aDependency).replace(aShard, std::move(sState));
+        updateCoverage();
+    }
+
+    void appendShard(size_t aDependency, std::span<const uint64_t> aIds)
+    {
+        auto sState = buildShardState(aIds);
+
+        Timer sTimer(Estimator::Name + " shard update merge");
+        dependency_trees.at(aDependency).append(std::move(sState));
+        updateCoverage();
+    }
+
+    void setWorkerCount(uint32_t aWorkerCount) { worker_count = std::max(aWorkerCount, 1u); }
+
+private:
+    struct AccumulateState
+    {
+        void operator()(StateType& aLeft, const StateType& aRight) const { aLeft += aRight; }
+    };
+
+    // Only used as the factory of empty per-shard states.
+    Estimator                                          estimator;
+    std::vector<MergeTree<StateType, AccumulateState>> dependency_trees;
+    uint32_t                                           pass_condition{1};
+    uint64_t                                           coverage{0};
+    uint32_t                                           worker_count{ThreadPool::defaultWorkerCount()};
+
+    StateType buildShardState(std::span<const uint64_t> aIds) const
+    {
+        auto sState = estimator.constructDefault();
+        Estimator::addBatchToState(sState, aIds);
+
+        return sState;
+    }
+
+    // Same semantics as CustomEstimatorBase::addShardData: the two-dependency intersection for pass condition 2,
+    // the union otherwise.
+    void updateCoverage()
+    {
+        if (pass_condition == 2 && dependency_trees.size() == 2)
+        {
+            const auto& sFirst  = dependency_trees[0].getRoot();
+            const auto& sSecond = dependency_trees[1].getRoot();
+            coverage            = sFirst.cardinality_estimate() + sSecond.cardinality_estimate()
+                       - (sFirst + sSecond).cardinality_estimate();
+            return;
+        }
+
+        auto sUnion = estimator.constructDefault();
+        for (const auto& sTree : dependency_trees)
+        {
+            sUnion += sTree.getRoot();
+        }
+        coverage = sUnion.cardinality_estimate();
+    }
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+#include "bounded_queue.hpp"
+#include "common.hpp"
+#include "shard_data.hpp"
+#include "sketch_cache.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+enum class IngestionMode
+{
+    // Every shard gets its own sketch, the sketches are merged with a tree reduction afterwards.
+    PER_SHARD,
+    // Every worker owns a single accumulator sketch and feeds whole shards straight into it, so only
+    // min(worker count, shard count) sketches are alive at once. Gives identical results for mergeable sketches.
+    STREAMING,
+    // Every shard gets its own sketch as with PER_SHARD, but the calling thread merges the finished sketches
+    // while the workers still build the others, so the merge overlaps ingestion instead of following it. About
+    // twice the worker count of sketches are alive at once. Gives identical results for mergeable sketches.
+    PIPELINED
+};
+
+// Wall times of the ingestion of one sketch, summed over its dependencies. Lets a driver that interleaves the
+// ingestion of several sketches report each one's times with its result.
+struct IngestionTimes
+{
+    uint64_t coverage_calculation_ns{0};
+    uint64_t merge_ns{0};
+    // PIPELINED merge loop, including the waits for the builders.
+    uint64_t pipelined_merge_ns{0};
+};
+
+struct IngestionOptions
+{
+    IngestionMode mode = IngestionMode::PER_SHARD;
+    uint32_t      worker_count{ThreadPool::defaultWorkerCount()};
+    // Not owned. When set, per-shard sketches are looked up in the cache first and ingestion is always per shard.
+    // The ShardData must have its shard fingerprints, see fingerprintShards.
+    SketchCache* sketch_cache{nullptr};
+    // Not owned. When set, the merge spans are added to it as well.
+    IngestionTimes* times{nullptr};
+};
+
+// Where a coverage calculation span of a sketch ingested with aOptions adds its time, if anywhere.
+inline uint64_t* getCoverageCalculationTotal(const IngestionOptions& aOptions)
+{
+    return aOptions.times != nullptr ? &aOptions.times->coverage_calculation_ns : nullptr;
+}
+
+// Builds the merged sketch of a single dependency. aMakeState() constructs an empty sketch,
+// aAddIds(aState, aIds) inserts a span of ids, aMerge(aLeft, aRight) accumulates aRight into aLeft.
+// The merge is timed and counted under aMergeTimerName, PIPELINED times its merge loop under
+// aMergeTimerName + " pipelined" instead as it also waits for the builders.
+// aStateBytes is the size of a single sketch unless the sketch reports its own, see getStateBytes.
+// aParameters identify the sketch configuration in the sketch cache.
+template <typename MakeState, typename AddIds, typename Merge>
+auto buildDependencyState(const ShardData&        aData,
+                          ThreadPool&             aPool,
+                          const IngestionOptions& aOptions,
+                          const SketchParameters& aParameters,
+                          const std::string&      aMergeTimerName,
+                          uint64_t                aStateBytes,
+                          MakeState&&             aMakeState,
+                          AddIds&&                aAddIds,
+                          Merge&&                 aMerge)
+{
+    if (aData.shardCount() == 0)
+    {
+        return aMakeState();
+    }
+
+    const auto sCountStates = [&](const auto& aStates)
+    {
+        uint64_t sBytes = 0;
+        for (const auto& sState : aStates)
+        {
+            sBytes += getStateBytes(sState, aStateBytes);
+        }
+
+        addToCounter(aMergeTimerName, Counter::IDS_INGESTED, aData.total_size);
+        addToCounter(aMergeTimerName, Counter::MERGES, aStates.size() - 1);
+        addToCounter(aMergeTimerName, Counter::BYTES_ALLOCATED, sBytes);
+    };
+
+    if (aOptions.mode == IngestionMode::STREAMING && aOptions.sketch_cache == nullptr)
+    {
+        const size_t        sAccumulatorCount = std::min(size_t{aPool.getWorkerCount()}, aData.shardCount());
+        std::atomic<size_t> sNextShard{0};
+
+        const auto sFillAccumulator = [&](size_t)
+        {
+            auto sAccumulator = aMakeState();
+
+            for (size_t i = sNextShard++; i < aData.shardCount(); i = sNextShard++)
+            {
+                aAddIds(sAccumulator, aData.shard(i));
+            }
+
+            return sAccumulator;
+        };
+
+        auto sAccumulators = parallelTransform(aPool, sAccumulatorCount, sFillAccumulator);
+        sCountStates(sAccumulators);
+
+        Timer sTimer(aMergeTimerName, aOptions.times != nullptr ? &aOptions.times->merge_ns : nullptr);
+        return treeReduce(aPool, std::move(sAccumulators), aMerge);
+    }
+
+    if (aOptions.mode == IngestionMode::PIPELINED && aOptions.sketch_cache == nullptr)
+    {
+        using State = decltype(aMakeState());
+
+        const size_t        sBuilderCount = std::min(size_t{aPool.getWorkerCount()}, aData.shardCount());
+        BoundedQueue<State> sBuiltStates(sBuilderCount);
+        std::atomic<size_t> sNextShard{0};
+        std::atomic<size_t> sRunningBuilders{sBuilderCount};
+        std::atomic<bool>   sMergeFailed{false};
+
+        const auto sBuildShards = [&]
+        {
+            // The last builder to finish, also by an exception, ends the merge loop below.
+            struct CloseWhenLast
+            {
+                std::atomic<size_t>& running;
+                BoundedQueue<State>& queue;
+
+                ~CloseWhenLast()
+                {
+                    if (--running == 0)
+                    {
+                        queue.close();
+                    }
+                }
+            } sCloser{sRunningBuilders, sBuiltStates};
+
+            for (size_t i = sNextShard++; i < aData.shardCount() && !sMergeFailed; i = sNextShard++)
+            {
+                auto sState = aMakeState();
+                aAddIds(sState, aData.shard(i));
+                if (!sBuiltStates.push(std::move(sState)))
+                {
+                    return;
+                }
+            }
+        };
+
+        std::vector<std::future<void>> sBuilders;
+        sBuilders.reserve(sBuilderCount);
+        for (size_t i = 0; i < sBuilderCount; ++i)
+        {
+            sBuilders.push_back(aPool.submit(sBuildShards));
+        }
+
+        std::optional<State> sResult;
+        uint64_t             sBytes      = 0;
+        uint64_t             sStateCount = 0;
+        std::exception_ptr   sError;
+        try
+        {
+            // Includes the waits for built sketches, the part of the build the merge does not hide, so it is
+            // recorded apart from the merge-only spans of the other modes.
+            Timer sTimer(aMergeTimerName + " pipelined",
+                         aOptions.times != nullptr ? &aOptions.times->pipelined_merge_ns : nullptr);
+            while (auto sState = sBuiltStates.pop())
+            {
+                sBytes += getStateBytes(*sState, aStateBytes);
+                ++sStateCount;
+                if (sResult.has_value())
+                {
+                    aMerge(*sResult, *sState);
+                }
+                else
+                {
+                    sResult.emplace(std::move(*sState));
+                }
+            }
+        }
+        catch (...)
+        {
+            sError       = std::current_exception();
+            sMergeFailed = true;
+            sBuiltStates.close();
+        }
+
+        for (auto& sBuilder : sBuilders)
+        {
+            try
+            {
+                sBuilder.get();
+            }
+            catch (...)
+            {
+                if (!sError)
+                {
+                    sError = std::current_exception();
+                }
+            }
+        }
+
+        if (sError)
+        {
+            std::rethrow_exception(sError);
+        }
+
+        addToCounter(aMergeTimerName, Counter::IDS_INGESTED, aData.total_size);
+        addToCounter(aMergeTimerName, Counter::MERGES, sStateCount - 1);
+        addToCounter(aMergeTimerName, Counter::BYTES_ALLOCATED, sBytes);
+
+        return std::move(*sResult);
+    }
+
+    const auto sFillShardState = [&](size_t aShardIndex)
+    {
+        const auto sShard      = aData.shard(aShardIndex);
+        const auto sBuildState = [&]
+        {
+            auto sState = aMakeState();
+            aAddIds(sState, sShard);
+
+            return sState;
+        };
+
+        if (aOptions.sketch_cache == nullptr)
+        {
+            return sBuildState();
+        }
+
+        // The merge accumulates into the states, so the cached sketch is copied.
+        using State = decltype(aMakeState());
+        return State(*aOptions.sketch_cache->getOrBuild<State>(
+            aData.shard_fingerprints[aShardIndex], sShard.size(), aParameters, aStateBytes, sBuildState));
+    };
+
+    if (aOptions.sketch_cache != nullptr && aData.shard_fingerprints.size() != aData.shardCount())
+    {
+        throw std::invalid_argument("Sketch cache lookups need the shard fingerprints, see fingerprintShards");
+    }
+
+    auto sShardStates = parallelTransform(aPool, aData.shardCount(), sFillShardState);
+    sCountStates(sShardStates);
+
+    Timer sTimer(aMergeTimerName, aOptions.times != nullptr ? &aOptions.times->merge_ns : nullptr);
+    return treeReduce(aPool, std::move(sShardStates), aMerge);
+}
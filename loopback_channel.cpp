@@ -0,0 +1,130 @@
+#include "loopback_channel.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <stdexcept>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace
+{
+    void writeAll(int aDescriptor, std::span<const std::byte> aBytes)
+    {
+        while (!aBytes.empty())
+        {
+            const ssize_t sWritten = ::write(aDescriptor, aBytes.data(), aBytes.size());
+            if (sWritten < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "LoopbackChannel: write failed");
+            }
+
+            aBytes = aBytes.subspan(static_cast<size_t>(sWritten));
+        }
+    }
+
+    // Returns the number of bytes read, less than requested only at the end of the stream.
+    size_t readAll(int aDescriptor, std::span<std::byte> aBytes)
+    {
+        size_t sRead = 0;
+        while (sRead < aBytes.size())
+        {
+            const ssize_t sCount = ::read(aDescriptor, aBytes.data() + sRead, aBytes.size() - sRead);
+            if (sCount < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "LoopbackChannel: read failed");
+            }
+            if (sCount == 0)
+            {
+                break;
+            }
+
+            sRead += static_cast<size_t>(sCount);
+        }
+
+        return sRead;
+    }
+}  // namespace
+
+LoopbackChannel::LoopbackChannel()
+{
+    // A write to a pipe without a reader raises SIGPIPE, which would end the process instead of failing the send.
+    [[maybe_unused]] static const bool sIgnoringSigpipe = std::signal(SIGPIPE, SIG_IGN) != SIG_ERR;
+
+    int sDescriptors[2];
+    if (::pipe(sDescriptors) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "LoopbackChannel: pipe failed");
+    }
+
+    read_descriptor  = sDescriptors[0];
+    write_descriptor = sDescriptors[1];
+}
+
+LoopbackChannel::~LoopbackChannel()
+{
+    closeSending();
+    closeReceiving();
+}
+
+void LoopbackChannel::send(std::span<const std::byte> aMessage)
+{
+    const uint64_t  sSize = aMessage.size();
+    std::lock_guard sLock(send_mutex);
+
+    writeAll(write_descriptor, std::as_bytes(std::span<const uint64_t>(&sSize, 1)));
+    writeAll(write_descriptor, aMessage);
+    bytes_sent += sizeof(sSize) + aMessage.size();
+}
+
+void LoopbackChannel::closeSending()
+{
+    std::lock_guard sLock(send_mutex);
+    if (write_descriptor >= 0)
+    {
+        ::close(write_descriptor);
+        write_descriptor = -1;
+    }
+}
+
+void LoopbackChannel::closeReceiving()
+{
+    if (read_descriptor >= 0)
+    {
+        ::close(read_descriptor);
+        read_descriptor = -1;
+    }
+}
+
+bool LoopbackChannel::receive(std::vector<std::byte>& aMessage)
+{
+    uint64_t   sSize      = 0;
+    const auto sSizeBytes = std::as_writable_bytes(std::span<uint64_t>(&sSize, 1));
+
+    const size_t sHeaderRead = readAll(read_descriptor, sSizeBytes);
+    if (sHeaderRead == 0)
+    {
+        return false;
+    }
+
+    aMessage.resize(sHeaderRead == sSizeBytes.size() ? sSize : 0);
+    if (sHeaderRead != sSizeBytes.size() || readAll(read_descriptor, aMessage) != sSize)
+    {
+        throw std::runtime_error("LoopbackChannel: stream ended within a message");
+    }
+
+    return true;
+}
+
+uint64_t LoopbackChannel::getBytesSent() const
+{
+    return bytes_sent;
+}
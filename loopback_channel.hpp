@@ -0,0 +1,129 @@
+#pragma once
+
+#include "common.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// One-way message stream over a pipe, the local stand-in for the links between shard nodes and an aggregator.
+// Messages are length-prefixed. send() blocks while the pipe is full, so a slow receiver throttles its senders as
+// a network connection would. Any number of threads may send, a single one receives.
+class LoopbackChannel
+{
+public:
+    // Throws std::system_error when the pipe cannot be created. Ignores SIGPIPE for the process, so that sends to
+    // a closed receiving end fail instead of killing it.
+    LoopbackChannel();
+    ~LoopbackChannel();
+
+    LoopbackChannel(const LoopbackChannel&)            = delete;
+    LoopbackChannel& operator=(const LoopbackChannel&) = delete;
+
+    // Throws std::system_error when the receiving end is gone.
+    void send(std::span<const std::byte> aMessage);
+    // Ends the stream: receive() returns false once every message sent before is read.
+    void closeSending();
+    // Gives up on the stream from the receiving side: pending and later sends throw instead of blocking on a full
+    // pipe. For the receiving thread, receive() must not be called afterwards.
+    void closeReceiving();
+    // Replaces aMessage with the next message. Returns false at the end of the stream, throws std::runtime_error
+    // when the stream ends within a message.
+    bool receive(std::vector<std::byte>& aMessage);
+
+    // Including the length prefixes.
+    uint64_t getBytesSent() const;
+
+private:
+    int                   read_descriptor{-1};
+    int                   write_descriptor{-1};
+    std::mutex            send_mutex;
+    std::atomic<uint64_t> bytes_sent{0};
+};
+
+// Runs aSendNode(aNodeIndex, aChannel) for every node on its own thread, the nodes encoding and sending their
+// shards, and hands every message to aReceive(std::span<const std::byte>) on the calling thread as soon as it has
+// arrived. Returns once every node is done and all messages are merged; rethrows the first exception of a node
+// or of aReceive. The receive loop is timed under aTimerName, the shipped bytes are counted under it and returned.
+template <typename SendNode, typename Receive>
+uint64_t aggregateOverLoopback(const std::string& aTimerName,
+                               uint32_t           aNodeCount,
+                               SendNode&&         aSendNode,
+                               Receive&&          aReceive)
+{
+    LoopbackChannel sChannel;
+    // One more worker closes the channel after the last node.
+    ThreadPool sPool(aNodeCount + 1);
+
+    std::vector<std::future<void>> sNodes;
+    for (uint32_t i = 0; i < aNodeCount; ++i)
+    {
+        sNodes.push_back(sPool.submit([&aSendNode, &sChannel, i] { aSendNode(i, sChannel); }));
+    }
+    auto sCloser = sPool.submit(
+        [&]
+        {
+            for (auto& sNode : sNodes)
+            {
+                sNode.wait();
+            }
+            sChannel.closeSending();
+        });
+
+    // After a failed merge the remaining messages are still drained, the nodes would block on a full pipe
+    // otherwise. A broken stream cannot be drained, so its reading end is closed, which fails the blocked sends.
+    // Either way the nodes are done before sPool is destroyed, its destructor would wait for them forever.
+    std::exception_ptr sReceiveError;
+    std::exception_ptr sChannelError;
+    {
+        Timer                  sTimer(aTimerName);
+        std::vector<std::byte> sMessage;
+        try
+        {
+            while (sChannel.receive(sMessage))
+            {
+                try
+                {
+                    if (!sReceiveError)
+                    {
+                        aReceive(std::span<const std::byte>(sMessage));
+                    }
+                }
+                catch (...)
+                {
+                    sReceiveError = std::current_exception();
+                }
+            }
+        }
+        catch (...)
+        {
+            sChannelError = std::current_exception();
+            sChannel.closeReceiving();
+        }
+    }
+
+    sCloser.wait();
+    if (sChannelError)
+    {
+        std::rethrow_exception(sChannelError);
+    }
+    sCloser.get();
+    for (auto& sNode : sNodes)
+    {
+        sNode.get();
+    }
+    if (sReceiveError)
+    {
+        std::rethrow_exception(sReceiveError);
+    }
+    addToCounter(aTimerName, Counter::BYTES_SHIPPED, sChannel.getBytesSent());
+
+    return sChannel.getBytesSent();
+}
@@ -1,50 +1,245 @@
+#include "common.hpp"
 #include "estimators.hpp"
+#include "experiment_arena.hpp"
 #include "segment.hpp"
 
+#include <cmath>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
 
-int main()
+namespace
 {
+    // Every segment is the union of the ids of this many dependencies.
+    constexpr uint32_t DEPENDENCY_COUNT = 3;
+
+    sketch::hll::EstimationMethod parseEstimationMethod(std::string_view aName)
+    {
+        if (aName == "original")
+        {
+            return sketch::hll::ORIGINAL;
+        }
+        if (aName == "ertl_improved")
+        {
+            return sketch::hll::ERTL_IMPROVED;
+        }
+        if (aName == "ertl_mle")
+        {
+            return sketch::hll::ERTL_MLE;
+        }
+
+        throw std::invalid_argument("Unknown HyperLogLog estimation method: " + std::string(aName));
+    }
+
+    // Estimator picked on the command line and the values of its size parameter the experiment sweeps over.
+    struct EstimatorSweep
+    {
+        std::string                                   name;
+        std::string                                   parameter_name;
+        std::vector<uint64_t>                         parameters;
+        std::function<AnyCoverageEstimator(uint64_t)> make;
+        // Recorded with every result, such as the HyperLogLog estimation method.
+        std::vector<std::pair<std::string, double>>   fields{};
+        // Only HyperLogLog registers can be folded to the lower parameters of the sweep.
+        bool                                          foldable{false};
+    };
+
+    std::vector<uint64_t> makePowersOfTwo(uint64_t aMinLog2, uint64_t aMaxLog2)
+    {
+        std::vector<uint64_t> sResult;
+        for (uint64_t sLog2 = aMinLog2; sLog2 <= aMaxLog2; ++sLog2)
+        {
+            sResult.push_back(uint64_t(1) << sLog2);
+        }
+
+        return sResult;
+    }
+
+    // aPassCondition is the number of dependencies an id has to be in to be counted. Only KOfNCoverageEstimator
+    // estimates more than the union.
+    EstimatorSweep parseEstimatorSweep(std::string_view aName, uint32_t aPassCondition)
+    {
+        if (aName == "k_of_n")
+        {
+            return {.name           = KOfNCoverageEstimator::Name,
+                    .parameter_name = "sample_size",
+                    .parameters     = makePowersOfTwo(8, 16),
+                    .make           = [aPassCondition](uint64_t aSampleSize)
+                    {
+                        return AnyCoverageEstimator(std::in_place_type<KOfNCoverageEstimator>,
+                                                    static_cast<uint32_t>(aSampleSize),
+                                                    aPassCondition);
+                    }};
+        }
+        if (aPassCondition != 1)
+        {
+            throw std::invalid_argument(std::string(aName)
+                                        + " only estimates the union of the dependencies, use k_of_n for a pass "
+                                          "condition above 1");
+        }
+
+        if (aName == "bbit_minhash")
+        {
+            return {.name           = BBitMinHashEstimator::Name,
+                    .parameter_name = "hash_bit_count",
+                    .parameters     = {10, 11, 12, 13, 14, 15, 16},
+                    .make           = [](uint64_t aHashBitCount)
+                    { return AnyCoverageEstimator(std::in_place_type<BBitMinHashEstimator>, aHashBitCount); }};
+        }
+        if (aName == "range_minhash")
+        {
+            return {.name           = RangeMinHashEstimator::Name,
+                    .parameter_name = "sketch_size",
+                    .parameters     = makePowersOfTwo(8, 16),
+                    .make           = [](uint64_t aSketchSize)
+                    { return AnyCoverageEstimator(std::in_place_type<RangeMinHashEstimator>, aSketchSize); }};
+        }
+
+        const auto sMethod = parseEstimationMethod(aName);
+
+        return {.name           = HyperLogLogEstimator::Name,
+                .parameter_name = "bucket_count_log2",
+                .parameters     = {10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20},
+                .make           = [sMethod](uint64_t aBucketCountLog2)
+                { return AnyCoverageEstimator(std::in_place_type<HyperLogLogEstimator>, aBucketCountLog2, sMethod); },
+                .fields         = {{"estimation_method", static_cast<uint64_t>(sMethod)}},
+                .foldable       = true};
+    }
+
+    IngestionMode parseIngestionMode(std::string_view aName)
+    {
+        if (aName == "per_shard")
+        {
+            return IngestionMode::PER_SHARD;
+        }
+        if (aName == "streaming")
+        {
+            return IngestionMode::STREAMING;
+        }
+        if (aName == "pipelined")
+        {
+            return IngestionMode::PIPELINED;
+        }
+
+        throw std::invalid_argument("Unknown ingestion mode: " + std::string(aName));
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const uint64_t sSeed = argc > 1 ? std::stoull(argv[1]) : DEFAULT_EXPERIMENT_SEED;
+    std::cout << "Experiment seed: " << sSeed << std::endl;
+
+    dumpInstrumentationAtExit(argc > 2 ? argv[2] : "sketch_trace.jsonl");
+
+    // "fold": ingest every segment once at the highest precision and fold the registers for the lower ones.
+    const bool sFoldingSweep = argc > 3 && std::string_view(argv[3]) == "fold";
+    // The number of dependencies an id has to be in to be counted, in [1, DEPENDENCY_COUNT].
+    const uint32_t sPassCondition = argc > 6 ? static_cast<uint32_t>(std::stoul(argv[6])) : 1;
+    if (sPassCondition == 0 || sPassCondition > DEPENDENCY_COUNT)
+    {
+        throw std::invalid_argument("Pass condition must be in [1, " + std::to_string(DEPENDENCY_COUNT) + "]");
+    }
+    // "original", "ertl_improved" or "ertl_mle" for HyperLogLog with that estimation method, "bbit_minhash",
+    // "range_minhash" or "k_of_n".
+    const auto sSweep = parseEstimatorSweep(argc > 4 ? argv[4] : "original", sPassCondition);
+    if (sFoldingSweep && !sSweep.foldable)
+    {
+        throw std::invalid_argument("Only HyperLogLog estimators can be folded");
+    }
+    // "per_shard", "streaming" or "pipelined".
+    const auto sIngestionMode = argc > 5 ? parseIngestionMode(argv[5]) : IngestionMode::PER_SHARD;
+
+    // Shard data of one segment size lives in the arena, released as a whole before the next size.
+    ExperimentArena sArena;
+
     for (uint32_t sSize :
          {1'000'000, 2'000'000, 3'000'000, 4'000'000, 5'000'000, 10'000'000, 20'000'000, 30'000'000, 60'000'000})
     {
-        constexpr uint32_t PASS_CONDITION = 1;
+        sArena.reset();
 
         Dependencies sDeps;
 
         sDeps.size               = sSize / 4;
         sDeps.shard_count        = 40;
         sDeps.shard_distribution = ShardDataDistribution::RANDOM;
+        sDeps.seed               = deriveSeed(sSeed, sSize);
+        sDeps.memory_resource    = sArena.getResource();
 
-        sDeps.prototypes = {ShardDataPrototype{.operation             = ShardDataPrototype::UNION,
-                                               .operation_result_size = sSize / 2,
-                                               .response_size         = sSize / 4},
-                            ShardDataPrototype{.operation             = ShardDataPrototype::UNION,
-                                               .operation_result_size = sSize / 2,
-                                               .response_size         = sSize / 4},
-                            ShardDataPrototype{.operation             = ShardDataPrototype::UNION,
-                                               .operation_result_size = sSize / 2,
-                                               .response_size         = sSize / 4}};
+        sDeps.prototypes.assign(DEPENDENCY_COUNT,
+                                ShardDataPrototype{.operation             = ShardDataPrototype::UNION,
+                                                   .operation_result_size = sSize / 2,
+                                                   .response_size         = sSize / 4});
 
-        const auto sShardData = getShardDataFromDependencies(sDeps);
+        // Every estimator of the sweep, or only the largest one when the others are folded from it.
+        std::vector<AnyCoverageEstimator> sEstimators;
+        for (size_t i = sFoldingSweep ? sSweep.parameters.size() - 1 : 0; i < sSweep.parameters.size(); ++i)
+        {
+            sEstimators.push_back(sSweep.make(sSweep.parameters[i]));
+            setIngestionMode(sEstimators.back(), sIngestionMode);
+        }
 
+        // Their spans interleave per dependency, so every estimator's times are recorded with its result instead.
+        std::vector<IngestionTimes> sTimes(sEstimators.size());
+        for (size_t i = 0; i < sEstimators.size(); ++i)
+        {
+            setIngestionTimes(sEstimators[i], &sTimes[i]);
+        }
+
+        // The next dependency is generated while the baseline and the estimators ingest the current one. The
+        // estimators are dispatched once per dependency, not per shard or id. The baseline applies the pass condition
+        // once it has every dependency, parseEstimatorSweep only admits estimators that can be fed this way.
         BaselineEstimator sBaseline;
-        sBaseline.addShardData(sShardData, PASS_CONDITION);
+        streamShardDataFromDependencies(sDeps,
+                                        1,
+                                        [&](size_t, const ShardData& aData)
+                                        {
+                                            sBaseline.addDependencyData(aData);
+                                            for (auto& sEstimator : sEstimators)
+                                            {
+                                                addDependencyData(sEstimator, aData);
+                                            }
+                                        });
+        sBaseline.finishDependencies(sPassCondition);
 
         std::cout << "Baseline memory usage: " << sBaseline.estimateMemoryUsage() << std::endl;
+        recordResult("baseline", {{"memory_usage", sBaseline.estimateMemoryUsage()}});
 
-        for (uint64_t sBucketCountLog2 = 10; sBucketCountLog2 <= 20; ++sBucketCountLog2)
+        for (size_t i = 0; i < sSweep.parameters.size(); ++i)
         {
-            HyperLogLogEstimator sEstimator(sBucketCountLog2);
-            sEstimator.addShardData(sShardData, PASS_CONDITION);
+            const auto sParameter = sSweep.parameters[i];
+            const auto sEstimator
+                = sFoldingSweep
+                      ? AnyCoverageEstimator(std::get<HyperLogLogEstimator>(sEstimators.front()).fold(sParameter))
+                      : std::move(sEstimators[i]);
+            // A folding sweep ingests once, at the last parameter.
+            const bool sIngested = !sFoldingSweep || i + 1 == sSweep.parameters.size();
+            const auto sIngestionTimes = sIngested ? sTimes[sFoldingSweep ? 0 : i] : IngestionTimes{};
+
+            const auto sActualSize    = static_cast<double>(sBaseline.estimateCoverage());
+            const auto sEstimatedSize = static_cast<double>(estimateCoverage(sEstimator));
+            const auto sErrorPercent  = std::fabs(sActualSize - sEstimatedSize) / sActualSize * 100;
 
-            std::cout << "Bucket count, actual size, estimated size, error in %, memory usage: "
-                      << sBucketCountLog2 << ' ' << sBaseline.estimateCoverage() << ' '
-                      << sEstimator.estimateCoverage() << ' '
-                      << std::fabs(static_cast<double>(sBaseline.estimateCoverage())
-                                   - static_cast<double>(sEstimator.estimateCoverage()))
-                             / sBaseline.estimateCoverage() * 100
-                      << ' ' << sEstimator.estimateMemoryUsage() << std::endl;
+            std::cout << sSweep.parameter_name << ", actual size, estimated size, error in %, memory usage: "
+                      << sParameter << ' ' << sBaseline.estimateCoverage() << ' ' << estimateCoverage(sEstimator)
+                      << ' ' << sErrorPercent << ' ' << estimateMemoryUsage(sEstimator) << std::endl;
+            auto sFields = sSweep.fields;
+            sFields.insert(sFields.end(),
+                           {{sSweep.parameter_name, sParameter},
+                            {"pass_condition", sPassCondition},
+                            {"ingestion_mode", static_cast<uint64_t>(sIngestionMode)},
+                            {"actual_size", sActualSize},
+                            {"estimated_size", sEstimatedSize},
+                            {"error_percent", sErrorPercent},
+                            {"memory_usage", estimateMemoryUsage(sEstimator)},
+                            {"coverage_calculation_ns", sIngestionTimes.coverage_calculation_ns},
+                            {"merge_ns", sIngestionTimes.merge_ns},
+                            {"pipelined_merge_ns", sIngestionTimes.pipelined_merge_ns}});
+            recordResult(sSweep.name, std::move(sFields));
         }
     }
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Segment tree over mergeable states: every inner node holds the merge of its two children, the root the
+// merge of all leaves. Replacing or appending a leaf recomputes only the path to the root, O(log n) merges.
+// aMerge(aLeft, aRight) accumulates aRight into aLeft. The leaf level is padded to a power of two with copies
+// of aEmpty, so up to 4n states are kept alive.
+template <typename State, typename Merge>
+class MergeTree
+{
+public:
+    MergeTree(std::vector<State> aLeaves, State aEmpty, Merge aMerge = Merge())
+    : empty(std::move(aEmpty)), merge(std::move(aMerge))
+    {
+        rebuild(std::move(aLeaves));
+    }
+
+    const State& getRoot() const { return nodes[1]; }
+
+    const State& getLeaf(size_t aLeaf) const { return nodes.at(capacity + aLeaf); }
+
+    size_t size() const { return leaf_count; }
+
+    // Calls aConsumer(state) for every node, the padding leaves included.
+    template <typename Consumer>
+    void forEachNode(Consumer&& aConsumer) const
+    {
+        for (size_t sNode = 1; sNode < nodes.size(); ++sNode)
+        {
+            aConsumer(nodes[sNode]);
+        }
+    }
+
+    void replace(size_t aLeaf, State aState)
+    {
+        if (aLeaf >= leaf_count)
+        {
+            throw std::out_of_range("MergeTree leaf index is out of range");
+        }
+
+        nodes[capacity + aLeaf] = std::move(aState);
+        updatePath(capacity + aLeaf);
+    }
+
+    void append(State aState)
+    {
+        if (leaf_count == capacity)
+        {
+            // Full: double the leaf level and rebuild, amortised O(1) merges per append.
+            std::vector<State> sLeaves;
+            sLeaves.reserve(leaf_count + 1);
+            for (size_t i = 0; i < leaf_count; ++i)
+            {
+                sLeaves.push_back(std::move(nodes[capacity + i]));
+            }
+            sLeaves.push_back(std::move(aState));
+
+            rebuild(std::move(sLeaves));
+            return;
+        }
+
+        nodes[capacity + leaf_count] = std::move(aState);
+        updatePath(capacity + leaf_count);
+        ++leaf_count;
+    }
+
+private:
+    State  empty;
+    Merge  merge;
+    size_t leaf_count{0};
+    size_t capacity{0};
+    // Implicit binary heap: node i has the children 2i and 2i + 1, the leaves are [capacity, 2 * capacity).
+    std::vector<State> nodes;
+
+    void rebuild(std::vector<State> aLeaves)
+    {
+        leaf_count = aLeaves.size();
+        capacity   = std::bit_ceil(std::max<size_t>(leaf_count, 1));
+
+        nodes.assign(2 * capacity, empty);
+        for (size_t i = 0; i < leaf_count; ++i)
+        {
+            nodes[capacity + i] = std::move(aLeaves[i]);
+        }
+
+        for (size_t sNode = capacity - 1; sNode >= 1; --sNode)
+        {
+            recompute(sNode);
+        }
+    }
+
+    void recompute(size_t aNode)
+    {
+        nodes[aNode] = nodes[2 * aNode];
+        merge(nodes[aNode], nodes[2 * aNode + 1]);
+    }
+
+    void updatePath(size_t aNode)
+    {
+        for (aNode /= 2; aNode >= 1; aNode /= 2)
+        {
+            recompute(aNode);
+        }
+    }
+};
@@ -1,9 +1,18 @@
 import argparse
 import glob
+import json
 import os
 
+# Results that carry these fields report their own timings, see IngestionTimes in ingestion.hpp.
+TIMING_FIELDS = {'merge_time': 'merge_ns',
+                 'pipelined_merge_time': 'pipelined_merge_ns',
+                 'coverage_calculation_time': 'coverage_calculation_ns'}
+
 def get_default_stat() -> dict:
-    return {'merge_time': 0, 'coverage_calculation_time': 0, 'err_percent': 0}
+    return {'merge_time': 0, 'pipelined_merge_time': 0, 'coverage_calculation_time': 0, 'err_percent': 0}
+
+def ns_to_ms(value: int) -> float:
+    return round(value / 1e6, 3)
 
 def create_err_table(stats: dict):
     for audience_size in stats.keys():
@@ -27,56 +36,99 @@ def create_timings_table(stats_for_default: dict, stats_for_estimator: dict, key
 
         i += 1
 
+def create_counters_table(counters: list):
+    for counter in counters:
+        print(f'|{counter["phase"]}|{counter["name"]}|{counter["value"]}|')
+
+def read_records(path: str) -> tuple:
+    events = []
+    counters = []
+
+    with open(path, 'r') as f:
+        for line in f:
+            if not line.strip():
+                continue
+
+            record = json.loads(line)
+            if record['type'] == 'span':
+                events.append((record['start_ns'] + record['duration_ns'], record))
+            elif record['type'] == 'result':
+                events.append((record['time_ns'], record))
+            elif record['type'] == 'counter':
+                counters.append(record)
+
+    # Records are grouped by thread in the dump, restore the order in which spans ended.
+    events.sort(key=lambda event: event[0])
+
+    return [record for _, record in events], counters
+
 def process_file(path: str) -> None:
-    if not os.path.exists(path):
+    if not os.path.exists(path) or not path.endswith('.jsonl'):
         return
-    
-    with open(path, 'r') as f:
-        lines = f.readlines()
-    
+
+    records, counters = read_records(path)
+
+    # Spans of self-timed results may interleave with the others, so they are not attributed by their order.
+    self_timed = {record['name'] for record in records
+                  if record['type'] == 'result' and TIMING_FIELDS['merge_time'] in record['fields']}
+
     stats_for_default = []
     stats_for_estimator = dict()
 
     curr_stat = get_default_stat()
 
-    for line in lines:
-        if line.find('merge') != -1:
-            curr_stat['merge_time'] += int(line.split()[-1][:-2])
-        elif line.find('coverage calculation') != -1:
-            curr_stat['coverage_calculation_time'] = line.split()[-1][:-2]
-        elif line.find('Baseline memory usage') != -1:
+    for record in records:
+        if record['type'] == 'span':
+            name = record['name']
+            if any(name.startswith(estimator + ' ') for estimator in self_timed):
+                continue
+
+            # The pipelined merge loop also waits for the builders, it is not comparable with the merge-only spans.
+            if name.endswith(' pipelined'):
+                curr_stat['pipelined_merge_time'] += ns_to_ms(record['duration_ns'])
+            elif name.find('merge') != -1:
+                curr_stat['merge_time'] += ns_to_ms(record['duration_ns'])
+            elif name.find('coverage calculation') != -1:
+                curr_stat['coverage_calculation_time'] += ns_to_ms(record['duration_ns'])
+        elif record['name'] == 'baseline':
             stats_for_default.append(curr_stat)
             curr_stat = get_default_stat()
-        elif line.find('error in %') != -1:
-            tmp = line.split(':')[1].strip().split()
-            curr_stat['err_percent'] = tmp[3]
-
-            if tmp[1] not in stats_for_estimator:
-                stats_for_estimator[tmp[1]] = []
-
-            stats_for_estimator[tmp[1]].append(curr_stat)
+        elif 'error_percent' in record['fields']:
+            fields = record['fields']
+            if record['name'] in self_timed:
+                for stat, field in TIMING_FIELDS.items():
+                    curr_stat[stat] = ns_to_ms(fields[field])
+            curr_stat['err_percent'] = fields['error_percent']
+
+            actual_size = int(fields['actual_size'])
+            if actual_size not in stats_for_estimator:
+                stats_for_estimator[actual_size] = []
+
+            stats_for_estimator[actual_size].append(curr_stat)
             curr_stat = get_default_stat()
-    
+
     create_err_table(stats_for_estimator)
     create_timings_table(stats_for_default, stats_for_estimator, 'merge_time')
+    create_timings_table(stats_for_default, stats_for_estimator, 'pipelined_merge_time')
     create_timings_table(stats_for_default, stats_for_estimator, 'coverage_calculation_time')
+    create_counters_table(counters)
 
 
 def process_directory(path: str) -> None:
     if not os.path.exists(path):
         return
-    
-    for file_path in glob.glob(os.path.join(path, '*')):
+
+    for file_path in glob.glob(os.path.join(path, '*.jsonl')):
         print(file_path)
         process_file(file_path)
         print('---------------')
-    
+
 
 
 
 parser = argparse.ArgumentParser()
-parser.add_argument('--dir', help='Path to directory with files to process', nargs='*')
+parser.add_argument('--dir', help='Path to directory with trace files (*.jsonl) to process', nargs='*')
 args = parser.parse_args()
 
 for path in args.dir:
-    process_directory(path)
\ No newline at end of file
+    process_directory(path)
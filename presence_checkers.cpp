@@ -1,6 +1,150 @@
 #include "presence_checkers.hpp"
 
 #include "common.hpp"
+#include "hashing.hpp"
+#include "sketch_access.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace
+{
+    // bf_t and hlf_t derive several hashes per id internally and have no entry point for
+    // pre-hashed values, so their batches go through addh().
+    template <typename Filter>
+    void addIdsToFilter(Filter& aFilter, std::span<const uint64_t> aIds)
+    {
+        for (auto sId : aIds)
+        {
+            aFilter.addh(sId);
+        }
+    }
+
+    constexpr size_t PREFETCH_GROUP_SIZE = 32;
+
+    // Probes the ids in groups: aPrefetch(aId) prefetches the words an id's probes read for the whole group before
+    // the first of its ids is queried, so that the cache misses of a group overlap. The answers still come from
+    // may_contain(), the positions only steer the prefetches: a change of the library's probe scheme would cost
+    // speed, not correctness.
+    template <typename Filter, typename Prefetch>
+    void mayContainBatch(const Filter&             aFilter,
+                         std::span<const uint64_t> aIds,
+                         std::span<uint8_t>        aResults,
+                         Prefetch&&                aPrefetch)
+    {
+        for (size_t sOffset = 0; sOffset < aIds.size(); sOffset += PREFETCH_GROUP_SIZE)
+        {
+            const size_t sCount = std::min(PREFETCH_GROUP_SIZE, aIds.size() - sOffset);
+            for (size_t i = 0; i < sCount; ++i)
+            {
+                aPrefetch(aIds[sOffset + i]);
+            }
+
+            for (size_t i = 0; i < sCount; ++i)
+            {
+                aResults[sOffset + i] = aFilter.may_contain(aIds[sOffset + i]);
+            }
+        }
+    }
+
+    // bf_t hashes the id xor-ed with each of its seeds and cuts every hash into positions of log2(bit count) bits
+    // until it has aNumberOfHashFunctions of them.
+    void prefetchBloomFilterProbes(const sketch::bf_t& aFilter, uint32_t aNumberOfHashFunctions, uint64_t aId)
+    {
+        const auto&    sWords        = aFilter.core();
+        const uint64_t sBitCount     = sWords.size() * 64;
+        const auto     sPositionBits = static_cast<uint32_t>(std::countr_zero(sBitCount));
+
+        uint32_t sPrefetched = 0;
+        for (uint64_t sSeed : BloomFilterAccess::getSeeds(aFilter))
+        {
+            uint64_t sHash = wangHash(aId ^ sSeed);
+            for (uint32_t k = 0; k < 64 / sPositionBits && sPrefetched < aNumberOfHashFunctions; ++k, ++sPrefetched)
+            {
+                __builtin_prefetch(&sWords[(sHash & (sBitCount - 1)) / 64]);
+                sHash >>= sPositionBits;
+            }
+
+            if (sPrefetched == aNumberOfHashFunctions)
+            {
+                break;
+            }
+        }
+    }
+
+    // Every HLL of hlf_t hashes the id xor-ed with its seed and reads the register the top bits of the hash select.
+    void prefetchHyperLogLogFilterProbes(const sketch::hlf_t& aFilter, uint64_t aId)
+    {
+        const auto& sHlls  = HyperLogLogFilterAccess::getHlls(aFilter);
+        const auto& sSeeds = HyperLogLogFilterAccess::getSeeds(aFilter);
+        for (size_t i = 0; i < sHlls.size(); ++i)
+        {
+            const auto& sRegisters = sHlls[i].core();
+            const auto  sIndexBits = std::countr_zero(sRegisters.size());
+            __builtin_prefetch(&sRegisters[wangHash(aId ^ sSeeds[i]) >> (64 - sIndexBits)]);
+        }
+    }
+
+    void insertIntoCuckooFilter(CuckooFilter& aFilter, std::span<const uint64_t> aIds)
+    {
+        for (auto sId : aIds)
+        {
+            if (!aFilter.insert(sId))
+            {
+                throw std::runtime_error("CuckooFilterPresenceChecker: the filter is full");
+            }
+        }
+    }
+
+    void mergeCuckooFilters(CuckooFilter& aLeft, const CuckooFilter& aRight)
+    {
+        if (!aLeft.merge(aRight))
+        {
+            throw std::runtime_error("CuckooFilterPresenceChecker: the filter is full");
+        }
+    }
+
+    template <typename Filter, typename MakeFilter>
+    void storeShardFilters(const ShardData&        aData,
+                           uint32_t                aWorkerCount,
+                           const SketchParameters& aParameters,
+                           SketchStoreWriter&      aWriter,
+                           MakeFilter&&            aMakeFilter)
+    {
+        ThreadPool sPool(aWorkerCount);
+
+        const auto sFillShardFilter = [&](size_t aShardIndex)
+        {
+            Filter sFilter = aMakeFilter();
+            addIdsToFilter(sFilter, aData.shard(aShardIndex));
+
+            return sFilter;
+        };
+
+        for (const auto& sFilter : parallelTransform(sPool, aData.shardCount(), sFillShardFilter))
+        {
+            appendSketch(aWriter, sFilter, aParameters);
+        }
+    }
+
+    template <typename Filter>
+    void mergeStoredFilters(Filter& aFilter, const MappedSketchStore& aStore, const SketchParameters& aParameters)
+    {
+        for (size_t i = 0; i < aStore.size(); ++i)
+        {
+            mergeStoredSketch(aFilter, aStore[i], aParameters);
+        }
+    }
+}  // namespace
+
+void PresenceChecker::isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    for (size_t i = 0; i < aIds.size(); ++i)
+    {
+        aResults[i] = isPresent(aIds[i]);
+    }
+}
 
 void BaselinePresenceChecker::addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition)
 {
@@ -14,54 +158,55 @@ uint64_t BaselinePresenceChecker::estimateMemoryUsage() const
 
 bool BaselinePresenceChecker::isPresent(uint64_t aId) const
 {
-    return getIds().contains(aId);
+    return presence_checker.contains(aId);
 }
 
-const std::set<uint64_t>& BaselinePresenceChecker::getIds() const
+void BaselinePresenceChecker::isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    presence_checker.containsBatch(aIds, aResults);
+}
+
+void BaselinePresenceChecker::addDependencyData(const ShardData& aData)
+{
+    presence_checker.addDependencyData(aData);
+}
+
+void BaselinePresenceChecker::finishDependencies(uint32_t aPassCondition)
+{
+    presence_checker.finishDependencies(aPassCondition);
+}
+
+const std::vector<uint64_t>& BaselinePresenceChecker::getIds() const
 {
     return presence_checker.getIds();
 }
 
 BloomFilterPresenceChecker::BloomFilterPresenceChecker(uint64_t aSecondLevelSize,
-                                                       uint32_t aNumberOfHashFunctions)
+                                                       uint32_t aNumberOfHashFunctions,
+                                                       uint64_t aSeed)
 : second_level_size(aSecondLevelSize)
 , number_of_hash_functions(aNumberOfHashFunctions)
-, bloom_filter(second_level_size, number_of_hash_functions)
+, seed(aSeed)
+, bloom_filter(second_level_size, number_of_hash_functions, seed)
 {}
 
 void BloomFilterPresenceChecker::addShardData(const std::vector<ShardData>& aShardData,
                                               uint32_t                      aPassCondition)
 {
-    const auto sConvertDependencyToBloomFilter = [this](const ShardData& aData)
-    {
-        const auto sConvertShardResponseToBloomFilter = [&](const std::unordered_set<uint64_t>& aShardData)
-        {
-            sketch::bf_t sFilter(second_level_size, number_of_hash_functions);
-
-            for (auto sId : aShardData)
-            {
-                sFilter.addh(sId);
-            }
-
-            return sFilter;
-        };
-
-        std::vector<sketch::bf_t> sShardBloomFilters;
-        std::transform(aData.data.begin(),
-                       aData.data.end(),
-                       std::back_inserter(sShardBloomFilters),
-                       [&sConvertShardResponseToBloomFilter](const auto& aShardData)
-                       { return sConvertShardResponseToBloomFilter(aShardData); });
-
-        Timer        sTimer("BloomFilterPresenceChecker merge shard data");
-        sketch::bf_t sFilter(second_level_size, number_of_hash_functions);
+    ThreadPool sPool(ingestion_options.worker_count);
 
-        for (const auto& sShard : sShardBloomFilters)
-        {
-            sFilter |= sShard;
-        }
-
-        return sFilter;
+    const auto sConvertDependencyToBloomFilter = [this, &sPool](const ShardData& aData)
+    {
+        return buildDependencyState(
+            aData,
+            sPool,
+            ingestion_options,
+            getSketchParameters(),
+            "BloomFilterPresenceChecker merge shard data",
+            estimateMemoryUsage(),
+            [this] { return sketch::bf_t(second_level_size, number_of_hash_functions, seed); },
+            addIdsToFilter<sketch::bf_t>,
+            [](sketch::bf_t& aLeft, const sketch::bf_t& aRight) { aLeft |= aRight; });
     };
 
     Timer sTimer("BloomFilterPresenceChecker coverage calculation");
@@ -84,6 +229,14 @@ bool BloomFilterPresenceChecker::isPresent(uint64_t aId) const
     return bloom_filter.may_contain(aId);
 }
 
+void BloomFilterPresenceChecker::isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    mayContainBatch(bloom_filter,
+                    aIds,
+                    aResults,
+                    [this](uint64_t aId) { prefetchBloomFilterProbes(bloom_filter, number_of_hash_functions, aId); });
+}
+
 uint64_t BloomFilterPresenceChecker::estimateMemoryUsage() const
 {
     auto sRes = bloom_filter.est_memory_usage();
@@ -95,43 +248,78 @@ uint64_t BloomFilterPresenceChecker::estimateCardinality() const
     return static_cast<uint64_t>(bloom_filter.cardinality_estimate());
 }
 
-HyperLogLogPresenceChecker::HyperLogLogPresenceChecker(uint64_t aHllCount, uint32_t aHllBucketCountLog2)
-: hll_count(aHllCount)
-, hll_bucket_count_log2(aHllBucketCountLog2)
-, filter(hll_count, 1337, hll_bucket_count_log2)
-{}
-void HyperLogLogPresenceChecker::addShardData(const std::vector<ShardData>& aShardData, uint32_t)
+void BloomFilterPresenceChecker::addBatch(std::span<const uint64_t> aIds)
 {
-    const auto sConvertDependencyToBloomFilter = [this](const ShardData& aData)
-    {
-        const auto sConvertShardResponseToBloomFilter = [&](const std::unordered_set<uint64_t>& aShardData)
-        {
-            sketch::hlf_t sFilter(hll_count, 1337, hll_bucket_count_log2);
+    addIdsToFilter(bloom_filter, aIds);
+}
 
-            for (auto sId : aShardData)
-            {
-                sFilter.addh(sId);
-            }
+void BloomFilterPresenceChecker::setWorkerCount(uint32_t aWorkerCount)
+{
+    ingestion_options.worker_count = std::max(aWorkerCount, 1u);
+}
 
-            return sFilter;
-        };
+void BloomFilterPresenceChecker::setIngestionMode(IngestionMode aMode)
+{
+    ingestion_options.mode = aMode;
+}
 
-        std::vector<sketch::hlf_t> sShardBloomFilters;
-        std::transform(aData.data.begin(),
-                       aData.data.end(),
-                       std::back_inserter(sShardBloomFilters),
-                       [&sConvertShardResponseToBloomFilter](const auto& aShardData)
-                       { return sConvertShardResponseToBloomFilter(aShardData); });
+void BloomFilterPresenceChecker::storeShardSketches(const ShardData& aData, SketchStoreWriter& aWriter) const
+{
+    storeShardFilters<sketch::bf_t>(aData,
+                                    ingestion_options.worker_count,
+                                    getSketchParameters(),
+                                    aWriter,
+                                    [this] { return sketch::bf_t(second_level_size, number_of_hash_functions, seed); });
+}
 
-        Timer         sTimer("HyperLogLogChecker merge shard data");
-        sketch::hlf_t sFilter(hll_count, 1337, hll_bucket_count_log2);
+void BloomFilterPresenceChecker::addStoredSketches(const MappedSketchStore& aStore)
+{
+    Timer sTimer("BloomFilterPresenceChecker merge stored sketches");
+    mergeStoredFilters(bloom_filter, aStore, getSketchParameters());
+}
 
-        for (const auto& sShard : sShardBloomFilters)
-        {
-            sFilter += sShard;
-        }
+std::vector<std::byte> BloomFilterPresenceChecker::encodeShardSketch(std::span<const uint64_t> aIds) const
+{
+    sketch::bf_t sFilter(second_level_size, number_of_hash_functions, seed);
+    addIdsToFilter(sFilter, aIds);
+
+    return encodeSketch(sFilter, getSketchParameters());
+}
+
+void BloomFilterPresenceChecker::addEncodedSketch(std::span<const std::byte> aMessage)
+{
+    mergeEncodedSketch(bloom_filter, aMessage, getSketchParameters());
+}
 
-        return sFilter;
+SketchParameters BloomFilterPresenceChecker::getSketchParameters() const
+{
+    return {second_level_size, number_of_hash_functions, seed};
+}
+
+HyperLogLogPresenceChecker::HyperLogLogPresenceChecker(uint64_t aHllCount,
+                                                       uint32_t aHllBucketCountLog2,
+                                                       uint64_t aSeed)
+: hll_count(aHllCount)
+, hll_bucket_count_log2(aHllBucketCountLog2)
+, seed(aSeed)
+, filter(hll_count, seed, hll_bucket_count_log2)
+{}
+void HyperLogLogPresenceChecker::addShardData(const std::vector<ShardData>& aShardData, uint32_t)
+{
+    ThreadPool sPool(ingestion_options.worker_count);
+
+    const auto sConvertDependencyToBloomFilter = [this, &sPool](const ShardData& aData)
+    {
+        return buildDependencyState(
+            aData,
+            sPool,
+            ingestion_options,
+            getSketchParameters(),
+            "HyperLogLogChecker merge shard data",
+            estimateMemoryUsage(),
+            [this] { return sketch::hlf_t(hll_count, seed, hll_bucket_count_log2); },
+            addIdsToFilter<sketch::hlf_t>,
+            [](sketch::hlf_t& aLeft, const sketch::hlf_t& aRight) { aLeft += aRight; });
     };
 
     Timer sTimer("HyperLogLogPresenceChecker coverage calculation");
@@ -144,6 +332,11 @@ bool HyperLogLogPresenceChecker::isPresent(uint64_t aId) const
 {
     return filter.may_contain(aId);
 }
+void HyperLogLogPresenceChecker::isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    mayContainBatch(
+        filter, aIds, aResults, [this](uint64_t aId) { prefetchHyperLogLogFilterProbes(filter, aId); });
+}
 uint64_t HyperLogLogPresenceChecker::estimateMemoryUsage() const
 {
     return filter.est_memory_usage();
@@ -152,4 +345,285 @@ uint64_t HyperLogLogPresenceChecker::estimateMemoryUsage() const
 uint64_t HyperLogLogPresenceChecker::estimateCardinality() const
 {
     return 0;
-}
\ No newline at end of file
+}
+
+void HyperLogLogPresenceChecker::addBatch(std::span<const uint64_t> aIds)
+{
+    addIdsToFilter(filter, aIds);
+}
+
+void HyperLogLogPresenceChecker::setWorkerCount(uint32_t aWorkerCount)
+{
+    ingestion_options.worker_count = std::max(aWorkerCount, 1u);
+}
+
+void HyperLogLogPresenceChecker::setIngestionMode(IngestionMode aMode)
+{
+    ingestion_options.mode = aMode;
+}
+
+void HyperLogLogPresenceChecker::storeShardSketches(const ShardData& aData, SketchStoreWriter& aWriter) const
+{
+    storeShardFilters<sketch::hlf_t>(aData,
+                                     ingestion_options.worker_count,
+                                     getSketchParameters(),
+                                     aWriter,
+                                     [this] { return sketch::hlf_t(hll_count, seed, hll_bucket_count_log2); });
+}
+
+void HyperLogLogPresenceChecker::addStoredSketches(const MappedSketchStore& aStore)
+{
+    Timer sTimer("HyperLogLogChecker merge stored sketches");
+    mergeStoredFilters(filter, aStore, getSketchParameters());
+}
+
+SketchParameters HyperLogLogPresenceChecker::getSketchParameters() const
+{
+    return {hll_count, hll_bucket_count_log2, seed};
+}
+
+CountingBloomFilterPresenceChecker::CountingBloomFilterPresenceChecker(uint32_t aCounterCountLog2,
+                                                                       uint32_t aNumberOfHashFunctions,
+                                                                       uint64_t aSeed)
+: sketch_parameters{aCounterCountLog2, aNumberOfHashFunctions, aSeed}
+, filter(aCounterCountLog2, aNumberOfHashFunctions, aSeed)
+{}
+
+void CountingBloomFilterPresenceChecker::addShardData(const std::vector<ShardData>& aShardData,
+                                                      uint32_t                      aPassCondition)
+{
+    ThreadPool sPool(ingestion_options.worker_count);
+
+    Timer sTimer("CountingBloomFilterPresenceChecker coverage calculation");
+    pass_condition = std::clamp(aPassCondition, 1u, CountingBloomFilter::MAX_COUNT);
+    for (const auto& sDep : aShardData)
+    {
+        filter.addDependency(buildDependencyState(
+            sDep,
+            sPool,
+            ingestion_options,
+            sketch_parameters,
+            "CountingBloomFilterPresenceChecker merge shard data",
+            estimateMemoryUsage() / 8,
+            [this] { return filter.makeDependencySet(); },
+            [this](CountingBloomFilter::DependencySet& aSet, std::span<const uint64_t> aIds)
+            { filter.addIds(aSet, aIds); },
+            [](CountingBloomFilter::DependencySet& aLeft, const CountingBloomFilter::DependencySet& aRight)
+            { aLeft |= aRight; }));
+    }
+}
+
+bool CountingBloomFilterPresenceChecker::isPresent(uint64_t aId) const
+{
+    return filter.getCount(aId) >= pass_condition;
+}
+
+void CountingBloomFilterPresenceChecker::isPresentBatch(std::span<const uint64_t> aIds,
+                                                        std::span<uint8_t>        aResults) const
+{
+    for (size_t i = 0; i < aIds.size(); ++i)
+    {
+        aResults[i] = filter.getCount(aIds[i]) >= pass_condition;
+    }
+}
+
+uint64_t CountingBloomFilterPresenceChecker::estimateMemoryUsage() const
+{
+    return filter.estimateMemoryUsage();
+}
+
+void CountingBloomFilterPresenceChecker::addBatch(std::span<const uint64_t> aIds)
+{
+    auto sSet = filter.makeDependencySet();
+    filter.addIds(sSet, aIds);
+    filter.addDependency(sSet);
+}
+
+void CountingBloomFilterPresenceChecker::setWorkerCount(uint32_t aWorkerCount)
+{
+    ingestion_options.worker_count = std::max(aWorkerCount, 1u);
+}
+
+void CountingBloomFilterPresenceChecker::setIngestionMode(IngestionMode aMode)
+{
+    ingestion_options.mode = aMode;
+}
+
+SplitBlockBloomFilterPresenceChecker::SplitBlockBloomFilterPresenceChecker(uint32_t aBlockCountLog2, uint64_t aSeed)
+: sketch_parameters{aBlockCountLog2, 0, aSeed}
+, filter(aBlockCountLog2, aSeed)
+{}
+
+void SplitBlockBloomFilterPresenceChecker::addShardData(const std::vector<ShardData>& aShardData,
+                                                        uint32_t                      aPassCondition)
+{
+    ThreadPool sPool(ingestion_options.worker_count);
+
+    const auto sConvertDependencyToFilter = [this, &sPool](const ShardData& aData)
+    {
+        return buildDependencyState(
+            aData,
+            sPool,
+            ingestion_options,
+            sketch_parameters,
+            "SplitBlockBloomFilterPresenceChecker merge shard data",
+            estimateMemoryUsage(),
+            [this] { return SplitBlockBloomFilter(sketch_parameters.parameter, sketch_parameters.seed); },
+            [](SplitBlockBloomFilter& aFilter, std::span<const uint64_t> aIds) { aFilter.addIds(aIds); },
+            [](SplitBlockBloomFilter& aLeft, const SplitBlockBloomFilter& aRight) { aLeft |= aRight; });
+    };
+
+    Timer sTimer("SplitBlockBloomFilterPresenceChecker coverage calculation");
+    if (aPassCondition == 2 && aShardData.size() == 2)
+    {
+        filter = sConvertDependencyToFilter(aShardData[0]);
+        filter &= sConvertDependencyToFilter(aShardData[1]);
+    }
+    else
+    {
+        for (const auto& sDep : aShardData)
+        {
+            filter |= sConvertDependencyToFilter(sDep);
+        }
+    }
+}
+
+bool SplitBlockBloomFilterPresenceChecker::isPresent(uint64_t aId) const
+{
+    return filter.mayContain(aId);
+}
+
+void SplitBlockBloomFilterPresenceChecker::isPresentBatch(std::span<const uint64_t> aIds,
+                                                          std::span<uint8_t>        aResults) const
+{
+    filter.mayContainBatch(aIds, aResults);
+}
+
+uint64_t SplitBlockBloomFilterPresenceChecker::estimateMemoryUsage() const
+{
+    return filter.estimateMemoryUsage();
+}
+
+void SplitBlockBloomFilterPresenceChecker::addBatch(std::span<const uint64_t> aIds)
+{
+    filter.addIds(aIds);
+}
+
+void SplitBlockBloomFilterPresenceChecker::setWorkerCount(uint32_t aWorkerCount)
+{
+    ingestion_options.worker_count = std::max(aWorkerCount, 1u);
+}
+
+void SplitBlockBloomFilterPresenceChecker::setIngestionMode(IngestionMode aMode)
+{
+    ingestion_options.mode = aMode;
+}
+
+BinaryFuseFilterPresenceChecker::BinaryFuseFilterPresenceChecker(uint64_t aSeed) : seed(aSeed) {}
+
+void BinaryFuseFilterPresenceChecker::addShardData(const std::vector<ShardData>& aShardData,
+                                                   uint32_t                      aPassCondition)
+{
+    Timer sTimer("BinaryFuseFilterPresenceChecker coverage calculation");
+
+    // The exact set only lives until the filter is built.
+    BaselineCommon sIds;
+    sIds.addShardData(aShardData, aPassCondition);
+    filter = BinaryFuseFilter(sIds.getIds(), seed);
+}
+
+bool BinaryFuseFilterPresenceChecker::isPresent(uint64_t aId) const
+{
+    return filter.mayContain(aId);
+}
+
+void BinaryFuseFilterPresenceChecker::isPresentBatch(std::span<const uint64_t> aIds,
+                                                     std::span<uint8_t>        aResults) const
+{
+    filter.mayContainBatch(aIds, aResults);
+}
+
+uint64_t BinaryFuseFilterPresenceChecker::estimateMemoryUsage() const
+{
+    return filter.estimateMemoryUsage();
+}
+
+CuckooFilterPresenceChecker::CuckooFilterPresenceChecker(uint32_t aBucketCountLog2, uint64_t aSeed)
+: sketch_parameters{aBucketCountLog2, 0, aSeed}
+, filter(aBucketCountLog2, aSeed)
+{}
+
+void CuckooFilterPresenceChecker::addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition)
+{
+    ThreadPool sPool(ingestion_options.worker_count);
+
+    const auto sConvertDependencyToFilter = [this, &sPool](const ShardData& aData)
+    {
+        return buildDependencyState(
+            aData,
+            sPool,
+            ingestion_options,
+            sketch_parameters,
+            "CuckooFilterPresenceChecker merge shard data",
+            estimateMemoryUsage(),
+            [this] { return CuckooFilter(sketch_parameters.parameter, sketch_parameters.seed); },
+            insertIntoCuckooFilter,
+            mergeCuckooFilters);
+    };
+
+    Timer sTimer("CuckooFilterPresenceChecker coverage calculation");
+    if (aPassCondition == 2 && aShardData.size() == 2)
+    {
+        filter = sConvertDependencyToFilter(aShardData[0]);
+        filter.intersect(sConvertDependencyToFilter(aShardData[1]));
+    }
+    else
+    {
+        for (const auto& sDep : aShardData)
+        {
+            mergeCuckooFilters(filter, sConvertDependencyToFilter(sDep));
+        }
+    }
+}
+
+bool CuckooFilterPresenceChecker::isPresent(uint64_t aId) const
+{
+    return filter.mayContain(aId);
+}
+
+void CuckooFilterPresenceChecker::isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    for (size_t i = 0; i < aIds.size(); ++i)
+    {
+        aResults[i] = filter.mayContain(aIds[i]);
+    }
+}
+
+uint64_t CuckooFilterPresenceChecker::estimateMemoryUsage() const
+{
+    return filter.estimateMemoryUsage();
+}
+
+void CuckooFilterPresenceChecker::addBatch(std::span<const uint64_t> aIds)
+{
+    insertIntoCuckooFilter(filter, aIds);
+}
+
+void CuckooFilterPresenceChecker::eraseBatch(std::span<const uint64_t> aIds)
+{
+    Timer sTimer("CuckooFilterPresenceChecker erase");
+    for (auto sId : aIds)
+    {
+        filter.erase(sId);
+    }
+}
+
+void CuckooFilterPresenceChecker::setWorkerCount(uint32_t aWorkerCount)
+{
+    ingestion_options.worker_count = std::max(aWorkerCount, 1u);
+}
+
+void CuckooFilterPresenceChecker::setIngestionMode(IngestionMode aMode)
+{
+    ingestion_options.mode = aMode;
+}
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "baseline_common.hpp"
+#include "binary_fuse_filter.hpp"
+#include "counting_bloom_filter.hpp"
+#include "cuckoo_filter.hpp"
+#include "ingestion.hpp"
 #include "shard_data.hpp"
+#include "sketch_serialization.hpp"
+#include "sketch_wire_format.hpp"
+#include "split_block_bloom_filter.hpp"
 
-#include <set>
+#include <variant>
 
 #include <sketch/bf.h>
 #include <sketch/hll.h>
@@ -14,46 +21,200 @@ public:
     virtual void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition) = 0;
     virtual bool     isPresent(uint64_t aId) const                                                   = 0;
     virtual uint64_t estimateMemoryUsage() const                                                     = 0;
+    // aResults[i] is set to isPresent(aIds[i]). aResults must be at least as long as aIds. Costs one virtual call
+    // per batch; the default implementation probes the ids one by one.
+    virtual void isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
 };
 
-class BaselinePresenceChecker : public PresenceChecker
+class BaselinePresenceChecker final : public PresenceChecker
 {
 public:
     void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition) override;
     uint64_t estimateMemoryUsage() const override;
     bool     isPresent(uint64_t aId) const override;
-    const std::set<uint64_t>& getIds() const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const override;
+    // See BaselineCommon::addDependencyData.
+    void     addDependencyData(const ShardData& aData);
+    void     finishDependencies(uint32_t aPassCondition);
+    const std::vector<uint64_t>& getIds() const;
 
 private:
     BaselineCommon presence_checker;
 };
 
-class BloomFilterPresenceChecker : public PresenceChecker
+class BloomFilterPresenceChecker final : public PresenceChecker
 {
 public:
-    BloomFilterPresenceChecker(uint64_t aSecondLevelSize, uint32_t aNumberOfHashFunctions);
+    BloomFilterPresenceChecker(uint64_t aSecondLevelSize, uint32_t aNumberOfHashFunctions, uint64_t aSeed = 137);
     void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
     bool     isPresent(uint64_t aId) const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
     uint64_t estimateMemoryUsage() const;
     uint64_t estimateCardinality() const;
+    void     addBatch(std::span<const uint64_t> aIds);
+    void     setWorkerCount(uint32_t aWorkerCount);
+    void     setIngestionMode(IngestionMode aMode);
+    // Builds one filter per shard of aData and appends them to aWriter, in shard order.
+    void storeShardSketches(const ShardData& aData, SketchStoreWriter& aWriter) const;
+    // Merges every filter of aStore without re-ingesting any ids.
+    void addStoredSketches(const MappedSketchStore& aStore);
+    // Builds the filter of a single shard and encodes it for shipping to an aggregating node.
+    std::vector<std::byte> encodeShardSketch(std::span<const uint64_t> aIds) const;
+    // Merges a filter encoded by encodeShardSketch() of a checker with the same parameters.
+    void                   addEncodedSketch(std::span<const std::byte> aMessage);
 
 private:
-    uint64_t     second_level_size{0};
-    uint32_t     number_of_hash_functions{0};
-    sketch::bf_t bloom_filter;
+    SketchParameters getSketchParameters() const;
+
+    uint64_t         second_level_size{0};
+    uint32_t         number_of_hash_functions{0};
+    uint64_t         seed{0};
+    sketch::bf_t     bloom_filter;
+    IngestionOptions ingestion_options;
 };
 
-class HyperLogLogPresenceChecker : public PresenceChecker
+class HyperLogLogPresenceChecker final : public PresenceChecker
 {
 public:
-    HyperLogLogPresenceChecker(uint64_t aHllCount, uint32_t aHllBucketCountLog2);
+    HyperLogLogPresenceChecker(uint64_t aHllCount, uint32_t aHllBucketCountLog2, uint64_t aSeed = 1337);
     void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
     bool     isPresent(uint64_t aId) const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
     uint64_t estimateMemoryUsage() const;
     uint64_t estimateCardinality() const;
+    void     addBatch(std::span<const uint64_t> aIds);
+    void     setWorkerCount(uint32_t aWorkerCount);
+    void     setIngestionMode(IngestionMode aMode);
+    // Builds one filter per shard of aData and appends them to aWriter, in shard order.
+    void storeShardSketches(const ShardData& aData, SketchStoreWriter& aWriter) const;
+    // Merges every filter of aStore without re-ingesting any ids.
+    void addStoredSketches(const MappedSketchStore& aStore);
+
+private:
+    SketchParameters getSketchParameters() const;
+
+    uint64_t         hll_count{0};
+    uint32_t         hll_bucket_count_log2{0};
+    uint64_t         seed{0};
+    sketch::hlf_t    filter;
+    IngestionOptions ingestion_options;
+};
+
+// Answers isPresent against the pass condition: an id is reported present when the counting Bloom filter
+// has seen it in at least aPassCondition dependencies. Needs one byte per counter instead of eight per id.
+class CountingBloomFilterPresenceChecker final : public PresenceChecker
+{
+public:
+    CountingBloomFilterPresenceChecker(uint32_t aCounterCountLog2,
+                                       uint32_t aNumberOfHashFunctions,
+                                       uint64_t aSeed = 137);
+    void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
+    bool     isPresent(uint64_t aId) const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
+    uint64_t estimateMemoryUsage() const;
+    // Adds aIds as one more dependency.
+    void     addBatch(std::span<const uint64_t> aIds);
+    void     setWorkerCount(uint32_t aWorkerCount);
+    void     setIngestionMode(IngestionMode aMode);
+
+private:
+    SketchParameters    sketch_parameters;
+    uint32_t            pass_condition{1};
+    CountingBloomFilter filter;
+    IngestionOptions    ingestion_options;
+};
+
+// Drop-in alternative to BloomFilterPresenceChecker whose lookups touch one cache line instead of one per hash
+// function. A filter of 2^aBlockCountLog2 blocks has the memory of a bf_t with aBlockCountLog2 + 8 as its size.
+class SplitBlockBloomFilterPresenceChecker final : public PresenceChecker
+{
+public:
+    SplitBlockBloomFilterPresenceChecker(uint32_t aBlockCountLog2, uint64_t aSeed = 137);
+    void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
+    bool     isPresent(uint64_t aId) const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
+    uint64_t estimateMemoryUsage() const;
+    void     addBatch(std::span<const uint64_t> aIds);
+    void     setWorkerCount(uint32_t aWorkerCount);
+    void     setIngestionMode(IngestionMode aMode);
+
+private:
+    SketchParameters      sketch_parameters;
+    SplitBlockBloomFilter filter;
+    IngestionOptions      ingestion_options;
+};
+
+// Static checker for immutable segments: the ids passing the pass condition are computed exactly, then
+// compressed into a binary fuse filter of about 9 bits per id. Lookups read three bytes.
+class BinaryFuseFilterPresenceChecker final : public PresenceChecker
+{
+public:
+    explicit BinaryFuseFilterPresenceChecker(uint64_t aSeed = 137);
+    void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
+    bool     isPresent(uint64_t aId) const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
+    uint64_t estimateMemoryUsage() const;
+
+private:
+    uint64_t         seed{0};
+    BinaryFuseFilter filter;
+};
+
+// Presence checker that supports removing ids: when a shard drops ids they are erased from the filter instead of
+// rebuilding it. Shard filters are merged by their fingerprints, without re-hashing any ids. addShardData throws
+// std::runtime_error when the ids of all dependencies, counted once per shard, do not fit into 4 * 2^aBucketCountLog2
+// entries.
+class CuckooFilterPresenceChecker final : public PresenceChecker
+{
+public:
+    CuckooFilterPresenceChecker(uint32_t aBucketCountLog2, uint64_t aSeed = 137);
+    void     addShardData(const std::vector<ShardData>& aShardData, uint32_t aPassCondition);
+    bool     isPresent(uint64_t aId) const;
+    void     isPresentBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const;
+    uint64_t estimateMemoryUsage() const;
+    void     addBatch(std::span<const uint64_t> aIds);
+    // Removes one copy of each of aIds, e.g. ids a shard dropped. Union keeps a copy of an id per shard holding
+    // it, so the id stays present while other shards still contain it. Ids that are not present are skipped.
+    void     eraseBatch(std::span<const uint64_t> aIds);
+    void     setWorkerCount(uint32_t aWorkerCount);
+    void     setIngestionMode(IngestionMode aMode);
 
 private:
-    uint64_t      hll_count{0};
-    uint32_t      hll_bucket_count_log2{0};
-    sketch::hlf_t filter;
-};
\ No newline at end of file
+    SketchParameters sketch_parameters;
+    CuckooFilter     filter;
+    IngestionOptions ingestion_options;
+};
+
+// Runtime choice between the checkers without a virtual call per id: std::visit switches on the index once per
+// call, and since every alternative is final the member call inside is direct and can be inlined.
+using AnyPresenceChecker = std::variant<BaselinePresenceChecker,
+                                        BloomFilterPresenceChecker,
+                                        HyperLogLogPresenceChecker,
+                                        CountingBloomFilterPresenceChecker,
+                                        SplitBlockBloomFilterPresenceChecker,
+                                        BinaryFuseFilterPresenceChecker,
+                                        CuckooFilterPresenceChecker>;
+
+inline void addShardData(AnyPresenceChecker&           aChecker,
+                         const std::vector<ShardData>& aShardData,
+                         uint32_t                      aPassCondition)
+{
+    std::visit([&](auto& aAlternative) { aAlternative.addShardData(aShardData, aPassCondition); }, aChecker);
+}
+
+inline bool isPresent(const AnyPresenceChecker& aChecker, uint64_t aId)
+{
+    return std::visit([aId](const auto& aAlternative) { return aAlternative.isPresent(aId); }, aChecker);
+}
+
+inline void isPresentBatch(const AnyPresenceChecker& aChecker,
+                           std::span<const uint64_t> aIds,
+                           std::span<uint8_t>        aResults)
+{
+    std::visit([&](const auto& aAlternative) { aAlternative.isPresentBatch(aIds, aResults); }, aChecker);
+}
+
+inline uint64_t estimateMemoryUsage(const AnyPresenceChecker& aChecker)
+{
+    return std::visit([](const auto& aAlternative) { return aAlternative.estimateMemoryUsage(); }, aChecker);
+}
@@ -1,44 +1,133 @@
+#include "common.hpp"
+#include "experiment_arena.hpp"
 #include "presence_checkers.hpp"
 #include "segment.hpp"
 
+#include <bit>
+#include <chrono>
 #include <iostream>
+#include <string>
 
-int main()
+namespace
 {
+    struct LookupResult
+    {
+        uint32_t false_positive{0};
+        double   lookups_per_second{0};
+        double   batch_lookups_per_second{0};
+    };
+
+    template <typename Function>
+    double measureSeconds(Function&& aFunction)
+    {
+        const auto sBegin = std::chrono::steady_clock::now();
+        aFunction();
+        const std::chrono::duration<double> sElapsed = std::chrono::steady_clock::now() - sBegin;
+
+        return sElapsed.count();
+    }
+
+    // Probes aChecker with ids that are known not to be present, one virtual call per id and then in one batch.
+    LookupResult measureLookups(const PresenceChecker& aChecker, const std::vector<uint64_t>& aNotPresentIds)
+    {
+        LookupResult sResult;
+
+        sResult.lookups_per_second = aNotPresentIds.size() / measureSeconds(
+                                         [&]
+                                         {
+                                             for (auto sId : aNotPresentIds)
+                                             {
+                                                 sResult.false_positive += aChecker.isPresent(sId);
+                                             }
+                                         });
+
+        std::vector<uint8_t> sResults(aNotPresentIds.size());
+        sResult.batch_lookups_per_second
+            = aNotPresentIds.size() / measureSeconds([&] { aChecker.isPresentBatch(aNotPresentIds, sResults); });
+
+        return sResult;
+    }
+
+    // aBuildSeconds is the time addShardData took.
+    void reportBloomFilter(const std::string&           aName,
+                           uint32_t                     aSize,
+                           uint32_t                     aBitCountLog2,
+                           double                       aBuildSeconds,
+                           const PresenceChecker&       aChecker,
+                           const std::vector<uint64_t>& aNotPresentIds)
+    {
+        const auto sResult = measureLookups(aChecker, aNotPresentIds);
+
+        std::cout << aName
+                  << " deps size, bit count log2, build sec, false positive, memory usage, lookups/sec, batch "
+                     "lookups/sec: "
+                  << aSize << ' ' << aBitCountLog2 << ' ' << aBuildSeconds << ' ' << sResult.false_positive << ' '
+                  << aChecker.estimateMemoryUsage() << ' ' << static_cast<uint64_t>(sResult.lookups_per_second) << ' '
+                  << static_cast<uint64_t>(sResult.batch_lookups_per_second) << std::endl;
+        recordResult(aName,
+                     {{"deps_size", aSize},
+                      {"bit_count_log2", aBitCountLog2},
+                      {"build_seconds", aBuildSeconds},
+                      {"false_positive", sResult.false_positive},
+                      {"memory_usage", aChecker.estimateMemoryUsage()},
+                      {"lookups_per_second", sResult.lookups_per_second},
+                      {"batch_lookups_per_second", sResult.batch_lookups_per_second}});
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    const uint64_t sSeed = argc > 1 ? std::stoull(argv[1]) : DEFAULT_EXPERIMENT_SEED;
+    std::cout << "Experiment seed: " << sSeed << std::endl;
+
+    dumpInstrumentationAtExit(argc > 2 ? argv[2] : "presence_checkers_trace.jsonl");
+
+    // Shard data of one segment size lives in the arena, released as a whole before the next size.
+    ExperimentArena sArena;
+
     for (uint32_t sSize :
          {1'000'000, 2'000'000, 3'000'000, 4'000'000, 5'000'000, 10'000'000, 20'000'000, 30'000'000, 60'000'000})
     {
         constexpr uint32_t PASS_CONDITION = 1;
 
+        sArena.reset();
+
         Dependencies sDeps;
 
         sDeps.size               = sSize * 8 / 10;
         sDeps.shard_count        = 40;
         sDeps.shard_distribution = ShardDataDistribution::RANDOM;
+        sDeps.seed               = deriveSeed(sSeed, sSize);
+        sDeps.memory_resource    = sArena.getResource();
 
         sDeps.prototypes = {ShardDataPrototype{.operation             = ShardDataPrototype::UNION,
                                                .operation_result_size = sSize,
                                                .response_size         = sSize * 6 / 10}};
 
-        const auto sShardData = getShardDataFromDependencies(sDeps);
-
+        // The baseline collects the ids of a dependency while the next one is generated. The checkers below are
+        // timed one by one, so they are built from the kept shard data afterwards.
         BaselinePresenceChecker sBaseline;
-        sBaseline.addShardData(sShardData, PASS_CONDITION);
+        const auto              sShardData = streamAndKeepShardDataFromDependencies(
+            sDeps, 1, [&](size_t, const ShardData& aData) { sBaseline.addDependencyData(aData); });
+        sBaseline.finishDependencies(PASS_CONDITION);
 
         std::cout << "Baseline memory usage: " << sBaseline.estimateMemoryUsage() << std::endl;
+        recordResult("baseline", {{"memory_usage", sBaseline.estimateMemoryUsage()}});
+
+        // Streams 0..prototypes.size() are taken by the generated dependencies.
+        const auto sNotPresentIds
+            = generateIds(1'000'000, sBaseline.getIds(), deriveSeed(sDeps.seed, sDeps.prototypes.size() + 1));
 
         for (uint32_t sHllCount = 1; sHllCount <= 20; ++sHllCount)
         {
             constexpr uint32_t BUCKET_COUNT = 20;
 
-            HyperLogLogPresenceChecker sBloomFilter(sHllCount, BUCKET_COUNT);
+            HyperLogLogPresenceChecker sBloomFilter(sHllCount, BUCKET_COUNT, deriveSeed(sSeed, sHllCount));
             sBloomFilter.addShardData(sShardData, PASS_CONDITION);
 
             uint32_t sFalseNegative  = 0;
             uint32_t sFalsePostitive = 0;
 
-            const auto sNotPresentIds = generateIds(1'000'000, sBaseline.getIds());
-
             for (auto sId : sNotPresentIds)
             {
                 if (sBloomFilter.isPresent(sId))
@@ -51,6 +140,111 @@ int main()
                          "positive, memory usage: "
                       << sSize << ' ' << sHllCount << ' ' << sFalseNegative << ' ' << sFalsePostitive << ' '
                       << sBloomFilter.estimateMemoryUsage() << std::endl;
+            recordResult("HyperLogLogPresenceChecker",
+                         {{"deps_size", sSize},
+                          {"hll_count", sHllCount},
+                          {"false_negative", sFalseNegative},
+                          {"false_positive", sFalsePostitive},
+                          {"memory_usage", sBloomFilter.estimateMemoryUsage()}});
+        }
+
+        // bf_t against the split block filter and the counting Bloom filter of the same size. All of them set eight
+        // positions per id, the counting filter has a byte per position and so an eighth of the positions. Streaming
+        // ingestion keeps one filter per worker alive instead of one per shard.
+        for (uint32_t sBitCountLog2 : {24, 26, 28})
+        {
+            constexpr uint32_t NUMBER_OF_HASH_FUNCTIONS = 8;
+            constexpr uint32_t BLOCK_BITS_LOG2          = 8;
+
+            BloomFilterPresenceChecker sBloomFilter(
+                sBitCountLog2, NUMBER_OF_HASH_FUNCTIONS, deriveSeed(sSeed, sBitCountLog2));
+            sBloomFilter.setIngestionMode(IngestionMode::STREAMING);
+            const double sBloomBuildSeconds
+                = measureSeconds([&] { sBloomFilter.addShardData(sShardData, PASS_CONDITION); });
+            reportBloomFilter(
+                "BloomFilterPresenceChecker", sSize, sBitCountLog2, sBloomBuildSeconds, sBloomFilter, sNotPresentIds);
+
+            SplitBlockBloomFilterPresenceChecker sSplitBlockFilter(sBitCountLog2 - BLOCK_BITS_LOG2,
+                                                                   deriveSeed(sSeed, sBitCountLog2));
+            sSplitBlockFilter.setIngestionMode(IngestionMode::STREAMING);
+            const double sSplitBlockBuildSeconds
+                = measureSeconds([&] { sSplitBlockFilter.addShardData(sShardData, PASS_CONDITION); });
+            reportBloomFilter("SplitBlockBloomFilterPresenceChecker",
+                              sSize,
+                              sBitCountLog2,
+                              sSplitBlockBuildSeconds,
+                              sSplitBlockFilter,
+                              sNotPresentIds);
+
+            CountingBloomFilterPresenceChecker sCountingFilter(
+                sBitCountLog2 - 3, NUMBER_OF_HASH_FUNCTIONS, deriveSeed(sSeed, sBitCountLog2));
+            sCountingFilter.setIngestionMode(IngestionMode::STREAMING);
+            const double sCountingBuildSeconds
+                = measureSeconds([&] { sCountingFilter.addShardData(sShardData, PASS_CONDITION); });
+            reportBloomFilter("CountingBloomFilterPresenceChecker",
+                              sSize,
+                              sBitCountLog2,
+                              sCountingBuildSeconds,
+                              sCountingFilter,
+                              sNotPresentIds);
+        }
+
+        // The static binary fuse filter against the smallest bf_t that is at least as large.
+        {
+            constexpr uint32_t NUMBER_OF_HASH_FUNCTIONS = 7;
+
+            BinaryFuseFilterPresenceChecker sFuseFilter(deriveSeed(sSeed, sSize));
+            const double sFuseBuildSeconds
+                = measureSeconds([&] { sFuseFilter.addShardData(sShardData, PASS_CONDITION); });
+            const auto sBitCountLog2
+                = static_cast<uint32_t>(std::bit_width(sFuseFilter.estimateMemoryUsage() * 8 - 1));
+            reportBloomFilter("BinaryFuseFilterPresenceChecker",
+                              sSize,
+                              sBitCountLog2,
+                              sFuseBuildSeconds,
+                              sFuseFilter,
+                              sNotPresentIds);
+
+            BloomFilterPresenceChecker sBloomFilter(sBitCountLog2, NUMBER_OF_HASH_FUNCTIONS, deriveSeed(sSeed, sSize));
+            sBloomFilter.setIngestionMode(IngestionMode::STREAMING);
+            const double sBloomBuildSeconds
+                = measureSeconds([&] { sBloomFilter.addShardData(sShardData, PASS_CONDITION); });
+            reportBloomFilter(
+                "BloomFilterPresenceChecker", sSize, sBitCountLog2, sBloomBuildSeconds, sBloomFilter, sNotPresentIds);
+        }
+
+        // The cuckoo filter at most 90% full, and the cost of erasing the ids of one shard.
+        {
+            constexpr uint32_t SLOTS_PER_BUCKET_LOG2 = 2;
+            constexpr uint32_t FINGERPRINT_BITS_LOG2 = 4;
+
+            // Every dependency holding an id stores its own copy.
+            uint64_t sEntryCount = 0;
+            for (const auto& sDep : sShardData)
+            {
+                sEntryCount += sDep.total_size;
+            }
+
+            const uint64_t sBucketCount     = sEntryCount * 10 / 9 / 4 + 1;
+            const auto     sBucketCountLog2 = static_cast<uint32_t>(std::bit_width(sBucketCount - 1));
+
+            CuckooFilterPresenceChecker sCuckooFilter(sBucketCountLog2, deriveSeed(sSeed, sSize));
+            sCuckooFilter.setIngestionMode(IngestionMode::STREAMING);
+            const double sCuckooBuildSeconds
+                = measureSeconds([&] { sCuckooFilter.addShardData(sShardData, PASS_CONDITION); });
+            reportBloomFilter("CuckooFilterPresenceChecker",
+                              sSize,
+                              sBucketCountLog2 + SLOTS_PER_BUCKET_LOG2 + FINGERPRINT_BITS_LOG2,
+                              sCuckooBuildSeconds,
+                              sCuckooFilter,
+                              sNotPresentIds);
+
+            const auto   sDroppedIds   = sShardData.front().shard(0);
+            const double sEraseSeconds = measureSeconds([&] { sCuckooFilter.eraseBatch(sDroppedIds); });
+            std::cout << "CuckooFilterPresenceChecker erased ids, erase sec: " << sDroppedIds.size() << ' '
+                      << sEraseSeconds << std::endl;
+            recordResult("CuckooFilterPresenceChecker erase",
+                         {{"deps_size", sSize}, {"erased_ids", sDroppedIds.size()}, {"erase_seconds", sEraseSeconds}});
         }
     }
 
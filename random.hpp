@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+// SplitMix64 finalizer: a bijective mix that turns consecutive counters into independent-looking
+// 64-bit values, so the i-th random value of a stream can be computed without generating the previous ones.
+inline uint64_t splitMix64(uint64_t aValue)
+{
+    aValue = (aValue ^ (aValue >> 30)) * 0xbf58476d1ce4e5b9u;
+    aValue = (aValue ^ (aValue >> 27)) * 0x94d049bb133111ebu;
+    return aValue ^ (aValue >> 31);
+}
+
+// Value number aCounter of the stream identified by aSeed.
+inline uint64_t counterRandom(uint64_t aSeed, uint64_t aCounter)
+{
+    return splitMix64(aSeed + (aCounter + 1) * 0x9e3779b97f4a7c15u);
+}
+
+// Independent seed for the sub-experiment aStream of the experiment seeded with aSeed.
+inline uint64_t deriveSeed(uint64_t aSeed, uint64_t aStream)
+{
+    return counterRandom(aSeed, aStream);
+}
+
+inline uint64_t randomSeed()
+{
+    std::random_device sDevice;
+    return (static_cast<uint64_t>(sDevice()) << 32) | sDevice();
+}
@@ -1,19 +1,133 @@
 #include "segment.hpp"
 
+#include "bounded_queue.hpp"
+
+#include <exception>
+#include <thread>
+
 std::vector<ShardData> getShardDataFromDependencies(const Dependencies& aDependencies)
 {
     std::vector<ShardData> sShardData;
     sShardData.reserve(aDependencies.prototypes.size() + 1);
 
-    const auto sMain
-        = generateShardData(aDependencies.size, aDependencies.shard_count, aDependencies.shard_distribution);
-    sShardData.push_back(sMain);
+    // Moved, not copied: a copy of the ids would leave aDependencies.memory_resource.
+    sShardData.push_back(generateShardData(aDependencies.size,
+                                           aDependencies.shard_count,
+                                           aDependencies.shard_distribution,
+                                           deriveSeed(aDependencies.seed, 0),
+                                           aDependencies.memory_resource));
+
+    for (size_t i = 0; i < aDependencies.prototypes.size(); ++i)
+    {
+        sShardData.push_back(generateShardDataUsingExisting(sShardData.front(),
+                                                            aDependencies.prototypes[i],
+                                                            aDependencies.shard_distribution,
+                                                            deriveSeed(aDependencies.seed, i + 1),
+                                                            aDependencies.memory_resource));
+    }
+
+    return sShardData;
+}
+
+namespace
+{
+    // Both streaming variants: when aKept is set, every consumed dependency is appended to it instead of being
+    // released.
+    void streamShardData(const Dependencies&                                  aDependencies,
+                         size_t                                               aQueueCapacity,
+                         const std::function<void(size_t, const ShardData&)>& aConsumer,
+                         std::vector<std::shared_ptr<ShardData>>*             aKept)
+    {
+        BoundedQueue<std::shared_ptr<ShardData>> sGenerated(aQueueCapacity);
+        std::exception_ptr                       sGeneratorError;
+
+        std::jthread sGenerator(
+            [&]
+            {
+                try
+                {
+                    const auto sFirst
+                        = std::make_shared<ShardData>(generateShardData(aDependencies.size,
+                                                                        aDependencies.shard_count,
+                                                                        aDependencies.shard_distribution,
+                                                                        deriveSeed(aDependencies.seed, 0),
+                                                                        aDependencies.memory_resource));
+                    if (!sGenerated.push(sFirst))
+                    {
+                        return;
+                    }
 
-    for (const auto& sPrototype : aDependencies.prototypes)
+                    for (size_t i = 0; i < aDependencies.prototypes.size(); ++i)
+                    {
+                        auto sNext = std::make_shared<ShardData>(
+                            generateShardDataUsingExisting(*sFirst,
+                                                           aDependencies.prototypes[i],
+                                                           aDependencies.shard_distribution,
+                                                           deriveSeed(aDependencies.seed, i + 1),
+                                                           aDependencies.memory_resource));
+                        if (!sGenerated.push(std::move(sNext)))
+                        {
+                            return;
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    sGeneratorError = std::current_exception();
+                }
+
+                sGenerated.close();
+            });
+
+        try
+        {
+            size_t sIndex = 0;
+            while (auto sData = sGenerated.pop())
+            {
+                aConsumer(sIndex++, **sData);
+                if (aKept != nullptr)
+                {
+                    aKept->push_back(std::move(*sData));
+                }
+            }
+        }
+        catch (...)
+        {
+            sGenerated.close();
+            throw;
+        }
+
+        sGenerator.join();
+        if (sGeneratorError)
+        {
+            std::rethrow_exception(sGeneratorError);
+        }
+    }
+}  // namespace
+
+void streamShardDataFromDependencies(const Dependencies&                                  aDependencies,
+                                     size_t                                               aQueueCapacity,
+                                     const std::function<void(size_t, const ShardData&)>& aConsumer)
+{
+    streamShardData(aDependencies, aQueueCapacity, aConsumer, nullptr);
+}
+
+std::vector<ShardData> streamAndKeepShardDataFromDependencies(
+    const Dependencies&                                  aDependencies,
+    size_t                                               aQueueCapacity,
+    const std::function<void(size_t, const ShardData&)>& aConsumer)
+{
+    std::vector<std::shared_ptr<ShardData>> sKept;
+    streamShardData(aDependencies, aQueueCapacity, aConsumer, &sKept);
+
+    // The generator has finished, nothing reads the dependencies any more. Moved, not copied, as in
+    // getShardDataFromDependencies.
+    std::vector<ShardData> sShardData;
+    sShardData.reserve(sKept.size());
+    for (auto& sData : sKept)
     {
-        sShardData.push_back(
-            generateShardDataUsingExisting(sShardData.front(), sPrototype, aDependencies.shard_distribution));
+        sShardData.push_back(std::move(*sData));
     }
 
     return sShardData;
-}
\ No newline at end of file
+}
@@ -3,7 +3,11 @@
 #include "estimators.hpp"
 #include "shard_data.hpp"
 
+#include <functional>
 #include <memory>
+#include <memory_resource>
+
+constexpr uint64_t DEFAULT_EXPERIMENT_SEED = 1337;
 
 struct Dependencies
 {
@@ -11,6 +15,28 @@ struct Dependencies
     ShardDataDistribution           shard_distribution = ShardDataDistribution::EVEN;
     std::vector<ShardDataPrototype> prototypes;
     uint32_t                        shard_count{40};
+    // Every random choice of the experiment (ids, shard response sizes) is derived from this seed.
+    uint64_t                        seed{DEFAULT_EXPERIMENT_SEED};
+    // Backs the ids and offsets of the generated shard data.
+    std::pmr::memory_resource*      memory_resource{std::pmr::get_default_resource()};
 };
 
-std::vector<ShardData> getShardDataFromDependencies(const Dependencies& aDependencies);
\ No newline at end of file
+std::vector<ShardData> getShardDataFromDependencies(const Dependencies& aDependencies);
+
+// Same shard data as getShardDataFromDependencies, handed to aConsumer(aIndex, aData) one dependency at a time
+// as soon as it is generated. A background thread generates up to aQueueCapacity dependencies ahead of the
+// consumer, so generation of the next dependency overlaps the ingestion of the current one. aData is released
+// after aConsumer returns, except for the first dependency, which is kept until the others are derived from it.
+// An exception of either side stops both and is rethrown. Only the generating thread allocates from
+// aDependencies.memory_resource.
+void streamShardDataFromDependencies(const Dependencies&                                  aDependencies,
+                                     size_t                                               aQueueCapacity,
+                                     const std::function<void(size_t, const ShardData&)>& aConsumer);
+
+// Same as streamShardDataFromDependencies, but no dependency is released: once the last one was consumed, the
+// whole shard data is returned as getShardDataFromDependencies would, for drivers that ingest some sketches while
+// the data is generated and reuse the data for others afterwards.
+std::vector<ShardData> streamAndKeepShardDataFromDependencies(
+    const Dependencies&                                  aDependencies,
+    size_t                                               aQueueCapacity,
+    const std::function<void(size_t, const ShardData&)>& aConsumer);
@@ -1,34 +1,89 @@
 #include "shard_data.hpp"
 
 #include <algorithm>
-#include <random>
 #include <stdexcept>
 
+#include "random.hpp"
+#include "thread_pool.hpp"
+
 namespace
 {
-    ShardData createShardDataUsingExistingIds(const std::vector<uint64_t> &aIds,
-                                              uint32_t                     aShardCount,
-                                              ShardDataDistribution        aDistributionType)
+    constexpr uint64_t IDS_STREAM            = 0;
+    constexpr uint64_t RESPONSE_SIZES_STREAM = 1;
+
+    constexpr uint64_t MIN_ID     = 35033762171394u;
+    constexpr uint64_t MAX_ID     = 18446735718737694272u;
+    constexpr size_t   CHUNK_SIZE = 1 << 20;
+
+    // Fills aIds with the ids number [0, aIds.size()) of the stream aSeed, redrawing the excluded ones.
+    void fillIds(std::span<uint64_t> aIds, const std::vector<uint64_t>& aExcludedIds, uint64_t aSeed)
     {
-        auto sResponseSizes
-            = details::generateShardResponseSizes(aIds.size(), aShardCount, aDistributionType);
-        for (size_t i = 1; i < sResponseSizes.size(); ++i)
+        // Id number i is a pure function of (aSeed, i), so chunks can be filled in any order on any thread.
+        const auto sDrawId = [aSeed](uint64_t aCounter)
+        { return MIN_ID + counterRandom(aSeed, aCounter) % (MAX_ID - MIN_ID + 1); };
+        const auto sIsExcluded = [&aExcludedIds](uint64_t aId)
+        { return std::binary_search(aExcludedIds.begin(), aExcludedIds.end(), aId); };
+
+        std::vector<uint8_t> sRejected(aExcludedIds.empty() ? 0 : aIds.size());
+
+        ThreadPool sPool;
+        parallelFor(sPool,
+                    (aIds.size() + CHUNK_SIZE - 1) / CHUNK_SIZE,
+                    [&](size_t aChunk)
+                    {
+                        const size_t sEnd = std::min(aIds.size(), (aChunk + 1) * CHUNK_SIZE);
+                        for (size_t i = aChunk * CHUNK_SIZE; i < sEnd; ++i)
+                        {
+                            aIds[i] = sDrawId(i);
+                        }
+
+                        if (!sRejected.empty())
+                        {
+                            for (size_t i = aChunk * CHUNK_SIZE; i < sEnd; ++i)
+                            {
+                                sRejected[i] = sIsExcluded(aIds[i]);
+                            }
+                        }
+                    });
+
+        // Rejections are rare, redraw them sequentially from the counters past the count to stay deterministic.
+        uint64_t sCounter = aIds.size();
+        for (size_t i = 0; i < sRejected.size(); ++i)
         {
-            sResponseSizes[i] += sResponseSizes[i - 1];
+            while (sRejected[i])
+            {
+                aIds[i]      = sDrawId(sCounter++);
+                sRejected[i] = sIsExcluded(aIds[i]);
+            }
         }
+    }
 
-        std::vector<std::unordered_set<uint64_t>> sResult(aShardCount);
+    ShardData createShardDataUsingExistingIds(std::pmr::vector<uint64_t> aIds,
+                                              uint32_t                   aShardCount,
+                                              ShardDataDistribution      aDistributionType,
+                                              uint64_t                   aSeed)
+    {
+        const auto sResponseSizes
+            = details::generateShardResponseSizes(aIds.size(), aShardCount, aDistributionType, aSeed);
 
-        for (size_t i = 0; i < sResponseSizes.size(); ++i)
+        ShardData sResult(aIds.get_allocator().resource());
+        if (sResponseSizes.empty())
         {
-            const auto sBegin = !i ? aIds.begin() : std::next(aIds.begin(), sResponseSizes[i - 1]);
-            const auto sEnd
-                = i == sResponseSizes.size() - 1 ? aIds.end() : std::next(aIds.begin(), sResponseSizes[i]);
+            // No shard to hold the ids, the leading offset must stay zero.
+            return sResult;
+        }
 
-            sResult[i].insert(sBegin, sEnd);
+        sResult.offsets.reserve(sResponseSizes.size() + 1);
+        for (auto sResponseSize : sResponseSizes)
+        {
+            sResult.offsets.push_back(sResult.offsets.back() + sResponseSize);
         }
+        sResult.offsets.back() = aIds.size();
 
-        return {std::move(sResult), aIds.size()};
+        sResult.total_size = aIds.size();
+        sResult.ids        = std::move(aIds);
+
+        return sResult;
     }
 }  // namespace
 
@@ -36,7 +91,8 @@ namespace details
 {
     std::vector<uint32_t> generateShardResponseSizes(uint32_t              aResponseSize,
                                                      uint32_t              aShardCount,
-                                                     ShardDataDistribution aDistributionType)
+                                                     ShardDataDistribution aDistributionType,
+                                                     uint64_t              aSeed)
     {
         if (aShardCount == 0)
         {
@@ -72,9 +128,6 @@ namespace details
         }
         else if (aDistributionType == ShardDataDistribution::RANDOM)
         {
-            std::random_device         sDevice;
-            std::default_random_engine sEngine(sDevice());
-
             uint32_t sTotal = 0;
             for (uint32_t i = 0; i < aShardCount; ++i)
             {
@@ -84,8 +137,7 @@ namespace details
                     continue;
                 }
 
-                std::uniform_int_distribution<uint32_t> sRng(0, aResponseSize - sTotal);
-                sResult.push_back(sRng(sEngine));
+                sResult.push_back(counterRandom(aSeed, i) % (aResponseSize - sTotal + 1));
                 sTotal += sResult.back();
             }
         }
@@ -94,23 +146,60 @@ namespace details
     }
 }  // namespace details
 
-ShardData generateShardData(uint32_t              aResponseSize,
-                            uint32_t              aShardCount,
-                            ShardDataDistribution aDistributionType)
+ShardData::ShardData(std::pmr::memory_resource* aResource)
+: ids(aResource), offsets(1, 0, aResource), shard_fingerprints(aResource)
+{}
+
+size_t ShardData::shardCount() const
+{
+    return offsets.size() - 1;
+}
+
+std::span<const uint64_t> ShardData::shard(size_t aIndex) const
+{
+    return std::span<const uint64_t>(ids).subspan(offsets[aIndex], offsets[aIndex + 1] - offsets[aIndex]);
+}
+
+std::vector<std::span<const uint64_t>> ShardData::shards() const
+{
+    std::vector<std::span<const uint64_t>> sResult;
+    sResult.reserve(shardCount());
+
+    for (size_t i = 0; i < shardCount(); ++i)
+    {
+        sResult.push_back(shard(i));
+    }
+
+    return sResult;
+}
+
+ShardData generateShardData(uint32_t                   aResponseSize,
+                            uint32_t                   aShardCount,
+                            ShardDataDistribution      aDistributionType,
+                            uint64_t                   aSeed,
+                            std::pmr::memory_resource* aResource)
 {
     if (aShardCount == 0)
     {
-        return {};
+        return ShardData(aResource);
     }
 
-    return createShardDataUsingExistingIds(generateIds(aResponseSize), aShardCount, aDistributionType);
+    std::pmr::vector<uint64_t> sIds(aResponseSize, aResource);
+    fillIds(sIds, {}, deriveSeed(aSeed, IDS_STREAM));
+
+    return createShardDataUsingExistingIds(std::move(sIds),
+                                           aShardCount,
+                                           aDistributionType,
+                                           deriveSeed(aSeed, RESPONSE_SIZES_STREAM));
 }
 
-ShardData generateShardDataUsingExisting(const ShardData      &aExisting,
-                                         ShardDataPrototype    aPrototype,
-                                         ShardDataDistribution aDistributionType)
+ShardData generateShardDataUsingExisting(const ShardData           &aExisting,
+                                         ShardDataPrototype         aPrototype,
+                                         ShardDataDistribution      aDistributionType,
+                                         uint64_t                   aSeed,
+                                         std::pmr::memory_resource *aResource)
 {
-    std::vector<uint64_t> sIds;
+    std::pmr::vector<uint64_t> sIds(aResource);
     sIds.reserve(aPrototype.response_size);
 
     if (aPrototype.operation == ShardDataPrototype::INTERSECTION)
@@ -121,21 +210,7 @@ ShardData generateShardDataUsingExisting(const ShardData      &aExisting,
             throw std::invalid_argument("Invalid operation result size for intersection");
         }
 
-        uint32_t sCounter = 0;
-        for (const auto &sShard : aExisting.data)
-        {
-            for (auto sId : sShard)
-            {
-                if (sCounter++ < aPrototype.operation_result_size)
-                {
-                    sIds.push_back(sId);
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
+        sIds.insert(sIds.end(), aExisting.ids.begin(), aExisting.ids.begin() + aPrototype.operation_result_size);
     }
     else if (aPrototype.operation == ShardDataPrototype::UNION)
     {
@@ -145,53 +220,23 @@ ShardData generateShardDataUsingExisting(const ShardData      &aExisting,
             throw std::invalid_argument("Invalid operation result size for union");
         }
 
-        uint32_t sCounter = 0;
-        for (const auto &sShard : aExisting.data)
-        {
-            for (auto sId : sShard)
-            {
-                if (sCounter++
-                    < aPrototype.response_size - (aPrototype.operation_result_size - aExisting.total_size))
-                {
-                    sIds.push_back(sId);
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
+        const auto sReusedCount
+            = aPrototype.response_size - (aPrototype.operation_result_size - aExisting.total_size);
+        sIds.insert(sIds.end(), aExisting.ids.begin(), aExisting.ids.begin() + sReusedCount);
     }
 
-    const auto sGeneratedIds = generateIds(aPrototype.response_size - sIds.size());
-    sIds.insert(sIds.end(), sGeneratedIds.begin(), sGeneratedIds.end());
+    const size_t sCopiedCount = sIds.size();
+    sIds.resize(aPrototype.response_size);
+    fillIds(std::span<uint64_t>(sIds).subspan(sCopiedCount), {}, deriveSeed(aSeed, IDS_STREAM));
 
-    return createShardDataUsingExistingIds(sIds, aExisting.data.size(), aDistributionType);
+    return createShardDataUsingExistingIds(
+        std::move(sIds), aExisting.shardCount(), aDistributionType, deriveSeed(aSeed, RESPONSE_SIZES_STREAM));
 }
 
-std::vector<uint64_t> generateIds(uint32_t aCount, const std::set<uint64_t> &sExcludedIds)
+std::vector<uint64_t> generateIds(uint32_t aCount, const std::vector<uint64_t> &aExcludedIds, uint64_t aSeed)
 {
-    std::vector<uint64_t> sIds;
-    sIds.reserve(aCount);
-
-    constexpr uint64_t MIN_ID = 35033762171394u;
-    constexpr uint64_t MAX_ID = 18446735718737694272u;
-
-    std::random_device                      sDevice;
-    std::default_random_engine              sEngine(sDevice());
-    std::uniform_int_distribution<uint64_t> sRng(MIN_ID, MAX_ID);
-
-    for (uint32_t i = 0; i < aCount; ++i)
-    {
-        while (true)
-        {
-            if (auto sId = sRng(sEngine); !sExcludedIds.contains(sId))
-            {
-                sIds.push_back(sRng(sEngine));
-                break;
-            }
-        }
-    }
+    std::vector<uint64_t> sIds(aCount);
+    fillIds(sIds, aExcludedIds, aSeed);
 
     return sIds;
 }
@@ -1,8 +1,10 @@
 #pragma once
 
+#include "random.hpp"
+
 #include <cstdint>
-#include <set>
-#include <unordered_set>
+#include <memory_resource>
+#include <span>
 #include <vector>
 
 enum class ShardDataDistribution
@@ -15,18 +17,36 @@ namespace details
 {
     std::vector<uint32_t> generateShardResponseSizes(uint32_t              aResponseSize,
                                                      uint32_t              aShardCount,
-                                                     ShardDataDistribution aDistributionType);
+                                                     ShardDataDistribution aDistributionType,
+                                                     uint64_t              aSeed = randomSeed());
 }
 
+// Shard responses of a single dependency stored back to back (CSR layout):
+// shard i occupies ids[offsets[i], offsets[i + 1]).
+// The arrays come from the memory resource given at construction, e.g. an ExperimentArena. As with any pmr
+// container, a copy uses the default resource.
 struct ShardData
 {
-    std::vector<std::unordered_set<uint64_t>> data;
-    uint64_t                                  total_size{0};
+    ShardData() = default;
+    explicit ShardData(std::pmr::memory_resource* aResource);
+
+    std::pmr::vector<uint64_t> ids;
+    std::pmr::vector<uint64_t> offsets{0};
+    uint64_t                   total_size{0};
+    // Fingerprint of every shard, kept so that sketch cache lookups do not rehash the ids. Empty until
+    // fingerprintShards() fills it, and stale once the ids change.
+    std::pmr::vector<uint64_t> shard_fingerprints;
+
+    size_t                                 shardCount() const;
+    std::span<const uint64_t>              shard(size_t aIndex) const;
+    std::vector<std::span<const uint64_t>> shards() const;
 };
 
-ShardData generateShardData(uint32_t              aResponseSize,
-                            uint32_t              aShardCount,
-                            ShardDataDistribution aDistributionType);
+ShardData generateShardData(uint32_t                   aResponseSize,
+                            uint32_t                   aShardCount,
+                            ShardDataDistribution      aDistributionType,
+                            uint64_t                   aSeed     = randomSeed(),
+                            std::pmr::memory_resource* aResource = std::pmr::get_default_resource());
 
 struct ShardDataPrototype
 {
@@ -41,8 +61,13 @@ struct ShardDataPrototype
     uint32_t  response_size{0};
 };
 
-ShardData generateShardDataUsingExisting(const ShardData&      aExisting,
-                                         ShardDataPrototype    aPrototype,
-                                         ShardDataDistribution aDistributionType);
+ShardData generateShardDataUsingExisting(const ShardData&           aExisting,
+                                         ShardDataPrototype         aPrototype,
+                                         ShardDataDistribution      aDistributionType,
+                                         uint64_t                   aSeed     = randomSeed(),
+                                         std::pmr::memory_resource* aResource = std::pmr::get_default_resource());
 
-std::vector<uint64_t> generateIds(uint32_t aCount, const std::set<uint64_t>& sExcludedIds = {});
+// aExcludedIds must be sorted. The same seed always yields the same ids, regardless of the worker count.
+std::vector<uint64_t> generateIds(uint32_t                     aCount,
+                                  const std::vector<uint64_t>& aExcludedIds = {},
+                                  uint64_t                     aSeed        = randomSeed());
@@ -0,0 +1,109 @@
+#include "common.hpp"
+#include "estimators.hpp"
+#include "segment.hpp"
+#include "shard_fetch_simulation.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const char* getDistributionName(LatencyDistribution aDistribution)
+    {
+        switch (aDistribution)
+        {
+            case LatencyDistribution::CONSTANT:
+                return "constant";
+            case LatencyDistribution::UNIFORM:
+                return "uniform";
+            case LatencyDistribution::EXPONENTIAL:
+                return "exponential";
+            case LatencyDistribution::LOG_NORMAL:
+                return "log_normal";
+            case LatencyDistribution::PARETO:
+                return "pareto";
+        }
+
+        return "unknown";
+    }
+
+    double toMilliseconds(std::chrono::nanoseconds aDuration)
+    {
+        return std::chrono::duration<double, std::milli>(aDuration).count();
+    }
+
+    // Compares answering after the first shard, at a 90% quorum, at the median shard latency and after the last
+    // shard, by time and by error against the exact coverage.
+    template <typename Estimator>
+    void reportShardFetch(Estimator aEstimator, const ShardData& aData, const ShardFetchOptions& aOptions)
+    {
+        const auto sReport = simulateShardFetch(aEstimator, aData, aOptions);
+
+        const auto sActualSize   = static_cast<double>(aData.total_size);
+        const auto sErrorPercent = [sActualSize](const EstimateSnapshot& aSnapshot)
+        { return std::fabs(sActualSize - static_cast<double>(aSnapshot.estimate)) / sActualSize * 100; };
+
+        const auto& sFirst  = sReport.snapshots.front();
+        const auto& sQuorum = answerAtQuorum(sReport, aData.shardCount(), 0.9);
+        const auto& sFinal  = sReport.snapshots.back();
+        // Nothing may have been merged by the median latency when the aggregator lags behind.
+        const auto* sAtMedian    = answerAtDeadline(sReport, sReport.latency_p50);
+        const auto  sMedianError = sAtMedian != nullptr ? sErrorPercent(*sAtMedian) : 100.0;
+
+        std::cout << "Estimator, latency, first ms, 90% quorum ms, final ms, latency p50/p99/max ms, "
+                     "error in % at first/median latency/90% quorum/final: "
+                  << Estimator::Name << ' ' << getDistributionName(aOptions.latency.distribution) << ' '
+                  << toMilliseconds(sReport.time_to_first_estimate) << ' ' << toMilliseconds(sQuorum.elapsed) << ' '
+                  << toMilliseconds(sReport.time_to_final_estimate) << ' ' << toMilliseconds(sReport.latency_p50)
+                  << ' ' << toMilliseconds(sReport.latency_p99) << ' ' << toMilliseconds(sReport.latency_max) << ' '
+                  << sErrorPercent(sFirst) << ' ' << sMedianError << ' ' << sErrorPercent(sQuorum) << ' '
+                  << sErrorPercent(sFinal) << std::endl;
+        recordResult(Estimator::Name + " shard fetch",
+                     {{"latency_distribution", static_cast<uint64_t>(aOptions.latency.distribution)},
+                      {"time_to_first_estimate_ms", toMilliseconds(sReport.time_to_first_estimate)},
+                      {"time_to_quorum_estimate_ms", toMilliseconds(sQuorum.elapsed)},
+                      {"time_to_final_estimate_ms", toMilliseconds(sReport.time_to_final_estimate)},
+                      {"latency_p50_ms", toMilliseconds(sReport.latency_p50)},
+                      {"latency_p99_ms", toMilliseconds(sReport.latency_p99)},
+                      {"latency_max_ms", toMilliseconds(sReport.latency_max)},
+                      {"first_error_percent", sErrorPercent(sFirst)},
+                      {"median_latency_error_percent", sMedianError},
+                      {"quorum_error_percent", sErrorPercent(sQuorum)},
+                      {"final_error_percent", sErrorPercent(sFinal)}});
+    }
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace std::chrono_literals;
+
+    const uint64_t sSeed = argc > 1 ? std::stoull(argv[1]) : DEFAULT_EXPERIMENT_SEED;
+    std::cout << "Experiment seed: " << sSeed << std::endl;
+
+    dumpInstrumentationAtExit(argc > 2 ? argv[2] : "shard_fetch_trace.jsonl");
+
+    for (uint32_t sShardCount : {40, 400})
+    {
+        const auto sData
+            = generateShardData(4'000'000, sShardCount, ShardDataDistribution::RANDOM, deriveSeed(sSeed, sShardCount));
+        std::cout << "Shard count: " << sShardCount << std::endl;
+
+        for (const LatencyModel& sLatency : {LatencyModel{LatencyDistribution::CONSTANT, 5ms, 0},
+                                             LatencyModel{LatencyDistribution::UNIFORM, 5ms, 0.5},
+                                             LatencyModel{LatencyDistribution::EXPONENTIAL, 5ms, 0},
+                                             LatencyModel{LatencyDistribution::LOG_NORMAL, 5ms, 1},
+                                             LatencyModel{LatencyDistribution::PARETO, 5ms, 1.5}})
+        {
+            const ShardFetchOptions sOptions{.latency = sLatency, .seed = deriveSeed(sSeed, sShardCount + 1)};
+
+            reportShardFetch(HyperLogLogEstimator(14), sData, sOptions);
+            reportShardFetch(BBitMinHashEstimator(16), sData, sOptions);
+            reportShardFetch(RangeMinHashEstimator(4096), sData, sOptions);
+            reportShardFetch(KOfNCoverageEstimator(4096), sData, sOptions);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include "shard_fetch_simulation.hpp"
+
+#include "random.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    // Keeps heavy-tailed samples finite, and the simulations short.
+    constexpr double MAX_LATENCY_TO_MEDIAN = 1'000;
+
+    // Uniform in (0, 1].
+    double uniformOpen(uint64_t aSeed, uint64_t aCounter)
+    {
+        return static_cast<double>((counterRandom(aSeed, aCounter) >> 11) + 1) * 0x1p-53;
+    }
+
+    std::chrono::nanoseconds getPercentile(const std::vector<std::chrono::microseconds>& aSorted, double aPercent)
+    {
+        if (aSorted.empty())
+        {
+            return std::chrono::nanoseconds{0};
+        }
+
+        // Nearest rank.
+        const auto sRank = static_cast<size_t>(std::ceil(aPercent / 100 * static_cast<double>(aSorted.size())));
+        return aSorted[std::clamp<size_t>(sRank, 1, aSorted.size()) - 1];
+    }
+
+    SimulationTask fetchShard(SimulationExecutor&                   aExecutor,
+                              SimulationExecutor::Clock::time_point aArrival,
+                              size_t                                aShard,
+                              const std::function<void(size_t)>&    aOnArrival)
+    {
+        co_await aExecutor.sleepUntil(aArrival);
+        aOnArrival(aShard);
+    }
+}  // namespace
+
+std::chrono::microseconds sampleLatency(const LatencyModel& aModel, uint64_t aSeed, uint64_t aShard)
+{
+    const double sMedian = static_cast<double>(aModel.median.count());
+    const double sU      = uniformOpen(aSeed, 2 * aShard);
+
+    double sLatency = sMedian;
+    switch (aModel.distribution)
+    {
+        case LatencyDistribution::CONSTANT:
+            break;
+        case LatencyDistribution::UNIFORM:
+        {
+            const double sSpread = std::clamp(aModel.spread, 0.0, 1.0);
+            sLatency             = sMedian * (1 - sSpread + 2 * sSpread * (1 - sU));
+            break;
+        }
+        case LatencyDistribution::EXPONENTIAL:
+            sLatency = sMedian * -std::log(sU) / std::numbers::ln2;
+            break;
+        case LatencyDistribution::LOG_NORMAL:
+        {
+            // Box-Muller with a second independent uniform.
+            const double sNormal = std::sqrt(-2 * std::log(sU))
+                                   * std::cos(2 * std::numbers::pi * uniformOpen(aSeed, 2 * aShard + 1));
+            sLatency = sMedian * std::exp(aModel.spread * sNormal);
+            break;
+        }
+        case LatencyDistribution::PARETO:
+        {
+            // Scale chosen so that the median is sMedian: x_m * 2^(1 / shape).
+            const double sShape = std::max(aModel.spread, 0.01);
+            sLatency            = sMedian * std::pow(2 * sU, -1 / sShape);
+            break;
+        }
+    }
+
+    return std::chrono::microseconds(std::llround(std::clamp(sLatency, 0.0, sMedian * MAX_LATENCY_TO_MEDIAN)));
+}
+
+SimulationTask SimulationTask::promise_type::get_return_object()
+{
+    return SimulationTask(Handle::from_promise(*this));
+}
+
+SimulationTask::SimulationTask(Handle aHandle) : handle(aHandle) {}
+
+SimulationTask::SimulationTask(SimulationTask&& aOther) noexcept : handle(std::exchange(aOther.handle, {})) {}
+
+SimulationTask& SimulationTask::operator=(SimulationTask&& aOther) noexcept
+{
+    if (this != &aOther)
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+        handle = std::exchange(aOther.handle, {});
+    }
+
+    return *this;
+}
+
+SimulationTask::~SimulationTask()
+{
+    if (handle)
+    {
+        handle.destroy();
+    }
+}
+
+void SimulationExecutor::spawn(SimulationTask aTask)
+{
+    schedule(Clock::time_point{}, aTask.handle);
+    tasks.push_back(std::move(aTask));
+}
+
+void SimulationExecutor::run()
+{
+    while (!timers.empty())
+    {
+        const PendingWake sWake = timers.top();
+        timers.pop();
+
+        if (sWake.wake_time > Clock::now())
+        {
+            std::this_thread::sleep_until(sWake.wake_time);
+        }
+        sWake.handle.resume();
+
+        if (const auto sError = sWake.handle.promise().error)
+        {
+            // The remaining tasks are abandoned, destroying their frames.
+            timers = {};
+            tasks.clear();
+            std::rethrow_exception(sError);
+        }
+    }
+
+    tasks.clear();
+}
+
+void SimulationExecutor::schedule(Clock::time_point aWakeTime, SimulationTask::Handle aHandle)
+{
+    timers.push(PendingWake{aWakeTime, next_sequence++, aHandle});
+}
+
+const EstimateSnapshot& answerAtQuorum(const ShardFetchReport& aReport, size_t aShardCount, double aFraction)
+{
+    const auto sQuorum = static_cast<size_t>(std::ceil(std::clamp(aFraction, 0.0, 1.0) * aShardCount));
+    const auto sIt     = std::find_if(aReport.snapshots.begin(),
+                                      aReport.snapshots.end(),
+                                      [sQuorum](const EstimateSnapshot& aSnapshot)
+                                      { return aSnapshot.merged_shard_count >= sQuorum; });
+
+    return sIt != aReport.snapshots.end() ? *sIt : aReport.snapshots.back();
+}
+
+const EstimateSnapshot* answerAtDeadline(const ShardFetchReport& aReport, std::chrono::nanoseconds aDeadline)
+{
+    const EstimateSnapshot* sResult = nullptr;
+    for (const auto& sSnapshot : aReport.snapshots)
+    {
+        if (sSnapshot.elapsed > aDeadline)
+        {
+            break;
+        }
+        sResult = &sSnapshot;
+    }
+
+    return sResult;
+}
+
+namespace details
+{
+    ShardFetchReport runShardFetches(size_t                             aShardCount,
+                                     const ShardFetchOptions&           aOptions,
+                                     const std::function<void(size_t)>& aMergeShard,
+                                     const std::function<uint64_t()>&   aEstimate)
+    {
+        using Clock = SimulationExecutor::Clock;
+
+        ShardFetchReport sReport;
+        if (aShardCount == 0)
+        {
+            sReport.snapshots.push_back(EstimateSnapshot{.estimate = aEstimate()});
+            return sReport;
+        }
+
+        std::vector<std::chrono::microseconds> sLatencies(aShardCount);
+        for (size_t i = 0; i < aShardCount; ++i)
+        {
+            sLatencies[i] = sampleLatency(aOptions.latency, aOptions.seed, i);
+        }
+
+        const size_t      sInterval = std::max<size_t>(aOptions.snapshot_interval, 1);
+        size_t            sMerged   = 0;
+        Clock::time_point sStart;
+
+        // The fetches only hold a reference, it must outlive the executor's run.
+        const std::function<void(size_t)> sOnArrival = [&](size_t aShard)
+        {
+            aMergeShard(aShard);
+            ++sMerged;
+            if (sMerged == 1 || sMerged == aShardCount || sMerged % sInterval == 0)
+            {
+                const uint64_t sEstimate = aEstimate();
+                sReport.snapshots.push_back(EstimateSnapshot{Clock::now() - sStart, sMerged, sEstimate});
+            }
+        };
+
+        SimulationExecutor sExecutor;
+        sStart = Clock::now();
+        for (size_t i = 0; i < aShardCount; ++i)
+        {
+            sExecutor.spawn(fetchShard(sExecutor, sStart + sLatencies[i], i, sOnArrival));
+        }
+        sExecutor.run();
+
+        sReport.time_to_first_estimate = sReport.snapshots.front().elapsed;
+        sReport.time_to_final_estimate = sReport.snapshots.back().elapsed;
+
+        std::sort(sLatencies.begin(), sLatencies.end());
+        sReport.latency_p50 = getPercentile(sLatencies, 50);
+        sReport.latency_p99 = getPercentile(sLatencies, 99);
+        sReport.latency_max = sLatencies.back();
+
+        return sReport;
+    }
+}  // namespace details
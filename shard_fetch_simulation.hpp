@@ -0,0 +1,180 @@
+#pragma once
+
+#include "shard_data.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <vector>
+
+enum class LatencyDistribution
+{
+    CONSTANT,
+    // Uniform in [median * (1 - spread), median * (1 + spread)], spread clamped to [0, 1].
+    UNIFORM,
+    EXPONENTIAL,
+    // exp of a normal with sigma = spread around log(median).
+    LOG_NORMAL,
+    // Heavy tail with shape = spread: the smaller the shape, the slower the stragglers.
+    PARETO
+};
+
+// Response latency of a single shard. Every distribution is parameterised by its median.
+struct LatencyModel
+{
+    LatencyDistribution       distribution = LatencyDistribution::CONSTANT;
+    std::chrono::microseconds median{1'000};
+    double                    spread{0.5};
+};
+
+// Latency of shard aShard, a pure function of (aModel, aSeed, aShard).
+std::chrono::microseconds sampleLatency(const LatencyModel& aModel, uint64_t aSeed, uint64_t aShard);
+
+// Coroutine of a simulated task, started and owned by a SimulationExecutor.
+class SimulationTask
+{
+public:
+    struct promise_type
+    {
+        std::exception_ptr error;
+
+        SimulationTask      get_return_object();
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void                return_void() {}
+        void                unhandled_exception() { error = std::current_exception(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    SimulationTask(SimulationTask&& aOther) noexcept;
+    SimulationTask& operator=(SimulationTask&& aOther) noexcept;
+    ~SimulationTask();
+
+private:
+    friend class SimulationExecutor;
+
+    explicit SimulationTask(Handle aHandle);
+
+    Handle handle;
+};
+
+// Single-threaded event loop over wall-clock timers: tasks co_await sleepUntil() and are resumed on the thread
+// calling run() in deadline order. Work a task does after resuming runs on that thread too, so a slow task
+// delays the tasks due after it, as a busy aggregator would.
+class SimulationExecutor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct SleepAwaiter
+    {
+        SimulationExecutor& executor;
+        Clock::time_point   wake_time;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(SimulationTask::Handle aHandle) { executor.schedule(wake_time, aHandle); }
+        void await_resume() const noexcept {}
+    };
+
+    SleepAwaiter sleepUntil(Clock::time_point aWakeTime) { return SleepAwaiter{*this, aWakeTime}; }
+
+    // The task starts on the next run(), before any sleeping task resumes.
+    void spawn(SimulationTask aTask);
+    // Returns when every task has finished. Rethrows the first exception a task threw.
+    void run();
+
+private:
+    struct PendingWake
+    {
+        Clock::time_point      wake_time;
+        uint64_t               sequence;
+        SimulationTask::Handle handle;
+
+        // Min-heap on the wake time, ties resumed in scheduling order.
+        bool operator>(const PendingWake& aOther) const
+        {
+            return wake_time != aOther.wake_time ? wake_time > aOther.wake_time : sequence > aOther.sequence;
+        }
+    };
+
+    void schedule(Clock::time_point aWakeTime, SimulationTask::Handle aHandle);
+
+    std::priority_queue<PendingWake, std::vector<PendingWake>, std::greater<>> timers;
+    uint64_t                                                                   next_sequence{0};
+    std::vector<SimulationTask>                                                tasks;
+};
+
+struct EstimateSnapshot
+{
+    std::chrono::nanoseconds elapsed{0};
+    size_t                   merged_shard_count{0};
+    uint64_t                 estimate{0};
+};
+
+struct ShardFetchOptions
+{
+    LatencyModel latency;
+    uint64_t     seed{0};
+    // An estimate is taken after every snapshot_interval-th merged shard, and always after the first and the last.
+    size_t       snapshot_interval{1};
+};
+
+struct ShardFetchReport
+{
+    // In time order. Never empty: without shards it holds the estimate at time zero.
+    std::vector<EstimateSnapshot> snapshots;
+    std::chrono::nanoseconds      time_to_first_estimate{0};
+    std::chrono::nanoseconds      time_to_final_estimate{0};
+    // Of the sampled shard latencies: the tail the aggregator waits on.
+    std::chrono::nanoseconds      latency_p50{0};
+    std::chrono::nanoseconds      latency_p99{0};
+    std::chrono::nanoseconds      latency_max{0};
+};
+
+// Early-answer strategies evaluated on a finished simulation.
+// The first snapshot with at least aFraction of aShardCount shards merged.
+const EstimateSnapshot& answerAtQuorum(const ShardFetchReport& aReport, size_t aShardCount, double aFraction);
+// The last snapshot taken by aDeadline, nullptr when there is none.
+const EstimateSnapshot* answerAtDeadline(const ShardFetchReport& aReport, std::chrono::nanoseconds aDeadline);
+
+namespace details
+{
+    // Fetches aShardCount shards concurrently with latencies from aOptions, calls aMergeShard(i) as shard i
+    // arrives and aEstimate() for the snapshots.
+    ShardFetchReport runShardFetches(size_t                             aShardCount,
+                                     const ShardFetchOptions&           aOptions,
+                                     const std::function<void(size_t)>& aMergeShard,
+                                     const std::function<uint64_t()>&   aEstimate);
+}  // namespace details
+
+// Replays the shards of aData into aEstimator as if every shard answered after its own simulated latency, and
+// records how the estimate evolves. Estimators that ship sketches get every shard's sketch encoded up front,
+// as the shards would, and merge the messages on arrival; the others ingest the shard's ids.
+template <typename Estimator>
+ShardFetchReport simulateShardFetch(Estimator& aEstimator, const ShardData& aData, const ShardFetchOptions& aOptions)
+{
+    const auto sEstimate = [&aEstimator] { return aEstimator.estimateCoverage(); };
+
+    if constexpr (requires { aEstimator.addEncodedSketch(aEstimator.encodeShardSketch(aData.shard(0))); })
+    {
+        std::vector<std::vector<std::byte>> sMessages;
+        sMessages.reserve(aData.shardCount());
+        for (size_t i = 0; i < aData.shardCount(); ++i)
+        {
+            sMessages.push_back(aEstimator.encodeShardSketch(aData.shard(i)));
+        }
+
+        return details::runShardFetches(
+            aData.shardCount(), aOptions, [&](size_t i) { aEstimator.addEncodedSketch(sMessages[i]); }, sEstimate);
+    }
+    else
+    {
+        return details::runShardFetches(
+            aData.shardCount(), aOptions, [&](size_t i) { aEstimator.addBatch(aData.shard(i)); }, sEstimate);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <sketch/bf.h>
+#include <sketch/hll.h>
+
+// bf_t and hlf_t keep their seeds and HLLs protected and have no accessors for them.
+struct BloomFilterAccess : sketch::bf_t
+{
+    static const auto& getSeeds(const sketch::bf_t& aFilter) { return aFilter.*(&BloomFilterAccess::seeds_); }
+};
+
+struct HyperLogLogFilterAccess : sketch::hlf_t
+{
+    static auto& getHlls(sketch::hlf_t& aFilter) { return aFilter.*(&HyperLogLogFilterAccess::hlls_); }
+
+    static const auto& getHlls(const sketch::hlf_t& aFilter) { return aFilter.*(&HyperLogLogFilterAccess::hlls_); }
+
+    static const auto& getSeeds(const sketch::hlf_t& aFilter)
+    {
+        return aFilter.*(&HyperLogLogFilterAccess::seeds_);
+    }
+};
@@ -0,0 +1,104 @@
+#include "sketch_cache.hpp"
+
+#include "hashing.hpp"
+#include "random.hpp"
+
+uint64_t fingerprintIds(std::span<const uint64_t> aIds)
+{
+    uint64_t sSum = 0;
+    uint64_t sXor = 0;
+    forEachWangHash(aIds,
+                    [&](uint64_t aHash)
+                    {
+                        sSum += aHash;
+                        sXor ^= aHash;
+                    });
+
+    return splitMix64(sSum ^ splitMix64(sXor ^ aIds.size()));
+}
+
+void fingerprintShards(ShardData& aData)
+{
+    const std::span<const uint64_t> sIds(aData.ids);
+
+    aData.shard_fingerprints.resize(aData.offsets.size() - 1);
+    for (size_t i = 0; i < aData.shard_fingerprints.size(); ++i)
+    {
+        const auto sShardSize       = aData.offsets[i + 1] - aData.offsets[i];
+        aData.shard_fingerprints[i] = fingerprintIds(sIds.subspan(aData.offsets[i], sShardSize));
+    }
+}
+
+SketchCache::SketchCache(uint64_t aCapacityBytes) : capacity_bytes(aCapacityBytes) {}
+
+SketchCacheStatistics SketchCache::getStatistics() const
+{
+    std::lock_guard sLock(mutex);
+    return statistics;
+}
+
+void SketchCache::clear()
+{
+    std::lock_guard sLock(mutex);
+    entries.clear();
+    index.clear();
+    statistics.bytes = 0;
+}
+
+size_t SketchCache::KeyHash::operator()(const Key& aKey) const
+{
+    uint64_t sResult = aKey.fingerprint;
+    for (uint64_t sPart : {aKey.id_count,
+                           uint64_t{aKey.type.hash_code()},
+                           aKey.parameters.parameter,
+                           aKey.parameters.secondary_parameter,
+                           aKey.parameters.seed})
+    {
+        sResult = splitMix64(sResult ^ sPart);
+    }
+
+    return sResult;
+}
+
+std::shared_ptr<const void> SketchCache::find(const Key& aKey)
+{
+    std::lock_guard sLock(mutex);
+
+    const auto sIt = index.find(aKey);
+    if (sIt == index.end())
+    {
+        ++statistics.misses;
+        return nullptr;
+    }
+
+    ++statistics.hits;
+    entries.splice(entries.begin(), entries, sIt->second);
+
+    return sIt->second->state;
+}
+
+void SketchCache::insert(const Key& aKey, std::shared_ptr<const void> aState, uint64_t aBytes)
+{
+    if (aBytes > capacity_bytes)
+    {
+        return;
+    }
+
+    std::lock_guard sLock(mutex);
+    if (index.contains(aKey))
+    {
+        return;
+    }
+
+    while (statistics.bytes + aBytes > capacity_bytes)
+    {
+        statistics.bytes -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+        ++statistics.evictions;
+    }
+
+    entries.push_front({aKey, std::move(aState), aBytes});
+    index.emplace(aKey, entries.begin());
+    statistics.bytes += aBytes;
+}
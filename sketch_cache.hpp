@@ -0,0 +1,111 @@
+#pragma once
+
+#include "shard_data.hpp"
+#include "sketch_store.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <typeindex>
+#include <unordered_map>
+
+// Order-independent fingerprint of a shard's ids: sketches do not depend on the insertion order either.
+uint64_t fingerprintIds(std::span<const uint64_t> aIds);
+
+// Fills aData.shard_fingerprints, once per ShardData, so that every later cache lookup of its shards is O(1).
+void fingerprintShards(ShardData& aData);
+
+// Sketches whose size depends on what they hold report it themselves, the others are aStateBytes large.
+template <typename State>
+uint64_t getStateBytes(const State& aState, uint64_t aStateBytes)
+{
+    if constexpr (requires { aState.estimateMemoryUsage(); })
+    {
+        return aState.estimateMemoryUsage();
+    }
+    else
+    {
+        return aStateBytes;
+    }
+}
+
+struct SketchCacheStatistics
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t evictions{0};
+    uint64_t bytes{0};
+};
+
+// LRU cache of per-shard sketches keyed by (shard fingerprint, sketch type, parameters). Lets parameter
+// sweeps and repeated experiments over the same shards pay for ingestion once per shard. Holds at most
+// aCapacityBytes of sketches, as reported by getStateBytes; the least recently used entries are evicted first.
+class SketchCache
+{
+public:
+    explicit SketchCache(uint64_t aCapacityBytes);
+
+    SketchCache(const SketchCache&)            = delete;
+    SketchCache& operator=(const SketchCache&) = delete;
+
+    // Returns the cached sketch of the aIdCount ids with fingerprint aFingerprint, see fingerprintIds, or stores
+    // the result of aBuild(). Thread-safe, concurrent misses on the same key may both build the sketch.
+    template <typename State, typename Build>
+    std::shared_ptr<const State> getOrBuild(uint64_t                aFingerprint,
+                                            uint64_t                aIdCount,
+                                            const SketchParameters& aParameters,
+                                            uint64_t                aStateBytes,
+                                            Build&&                 aBuild)
+    {
+        const Key sKey{aFingerprint, aIdCount, typeid(State), aParameters};
+        if (auto sCached = find(sKey))
+        {
+            return std::static_pointer_cast<const State>(sCached);
+        }
+
+        auto sState = std::make_shared<const State>(aBuild());
+        insert(sKey, sState, getStateBytes(*sState, aStateBytes));
+
+        return sState;
+    }
+
+    SketchCacheStatistics getStatistics() const;
+    void                  clear();
+
+private:
+    struct Key
+    {
+        uint64_t         fingerprint{0};
+        uint64_t         id_count{0};
+        std::type_index  type;
+        SketchParameters parameters;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& aKey) const;
+    };
+
+    struct Entry
+    {
+        Key                         key;
+        std::shared_ptr<const void> state;
+        uint64_t                    bytes{0};
+    };
+
+    using EntryList = std::list<Entry>;
+
+    uint64_t           capacity_bytes{0};
+    mutable std::mutex mutex;
+    // Most recently used first.
+    EntryList                                             entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    SketchCacheStatistics                                 statistics;
+
+    std::shared_ptr<const void> find(const Key& aKey);
+    void                        insert(const Key& aKey, std::shared_ptr<const void> aState, uint64_t aBytes);
+};
@@ -0,0 +1,161 @@
+#include "sketch_serialization.hpp"
+
+#include "sketch_access.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    void checkCompatible(const StoredSketch& aStored, SketchType aType, const SketchParameters& aParameters)
+    {
+        if (aStored.type != aType)
+        {
+            throw std::invalid_argument("Stored sketch has a different type");
+        }
+        if (aStored.parameters != aParameters)
+        {
+            throw std::invalid_argument("Stored sketch was built with different parameters");
+        }
+    }
+
+    template <typename T>
+    void checkPayloadSize(const StoredSketch& aStored, size_t aExpectedCount)
+    {
+        if (aStored.payload.size() != aExpectedCount * sizeof(T))
+        {
+            throw std::invalid_argument("Stored sketch payload has an unexpected size");
+        }
+    }
+
+    template <typename T, typename Combine>
+    void mergeRegisters(std::span<T> aRegisters, std::span<const T> aStored, Combine&& aCombine)
+    {
+        for (size_t i = 0; i < aRegisters.size(); ++i)
+        {
+            aRegisters[i] = aCombine(aRegisters[i], aStored[i]);
+        }
+    }
+
+    void mergeHyperLogLogRegisters(sketch::hll_t& aSketch, std::span<const uint8_t> aStored)
+    {
+        mergeRegisters<uint8_t>(
+            aSketch.core(), aStored, [](uint8_t aLeft, uint8_t aRight) { return std::max(aLeft, aRight); });
+        // Registers were changed behind the sketch's back, refresh its cached estimate.
+        aSketch.sum();
+    }
+}  // namespace
+
+void appendSketch(SketchStoreWriter& aWriter, const SparseHyperLogLog& aSketch, const SketchParameters& aParameters)
+{
+    const auto sRegisters = aSketch.getRegisters();
+    aWriter.add(SketchType::HYPER_LOG_LOG, aParameters, std::span<const uint8_t>(sRegisters));
+}
+
+void appendSketch(SketchStoreWriter&                    aWriter,
+                  const sketch::RangeMinHash<uint64_t>& aSketch,
+                  const SketchParameters&               aParameters)
+{
+    const auto sMinimums = aSketch.mh2vec();
+    aWriter.add(SketchType::RANGE_MIN_HASH, aParameters, std::span<const uint64_t>(sMinimums));
+}
+
+void appendSketch(SketchStoreWriter&                     aWriter,
+                  const sketch::BBitMinHasher<uint64_t>& aSketch,
+                  const SketchParameters&                aParameters)
+{
+    aWriter.add(SketchType::BBIT_MIN_HASH, aParameters, std::span<const uint64_t>(aSketch.core()));
+}
+
+void appendSketch(SketchStoreWriter& aWriter, const sketch::bf_t& aSketch, const SketchParameters& aParameters)
+{
+    aWriter.add(SketchType::BLOOM_FILTER, aParameters, std::span<const uint64_t>(aSketch.core()));
+}
+
+void appendSketch(SketchStoreWriter& aWriter, const sketch::hlf_t& aSketch, const SketchParameters& aParameters)
+{
+    const auto& sSeeds = HyperLogLogFilterAccess::getSeeds(aSketch);
+    const auto& sHlls  = HyperLogLogFilterAccess::getHlls(aSketch);
+
+    std::vector<std::byte> sPayload(sizeof(uint64_t) * sSeeds.size());
+    std::memcpy(sPayload.data(), sSeeds.data(), sPayload.size());
+    for (const auto& sHll : sHlls)
+    {
+        const auto sRegisters = std::as_bytes(std::span<const uint8_t>(sHll.core()));
+        sPayload.insert(sPayload.end(), sRegisters.begin(), sRegisters.end());
+    }
+
+    aWriter.add(SketchType::HYPER_LOG_LOG_FILTER, aParameters, std::span<const std::byte>(sPayload));
+}
+
+void mergeStoredSketch(SparseHyperLogLog& aSketch, const StoredSketch& aStored, const SketchParameters& aParameters)
+{
+    checkCompatible(aStored, SketchType::HYPER_LOG_LOG, aParameters);
+    checkPayloadSize<uint8_t>(aStored, size_t{1} << aSketch.getBucketCountLog2());
+
+    // Stored registers are dense already, merging them sparsely would not save anything.
+    mergeHyperLogLogRegisters(aSketch.densify(), aStored.getPayloadAs<uint8_t>());
+}
+
+void mergeStoredSketch(sketch::RangeMinHash<uint64_t>& aSketch,
+                       const StoredSketch&             aStored,
+                       const SketchParameters&         aParameters)
+{
+    checkCompatible(aStored, SketchType::RANGE_MIN_HASH, aParameters);
+    if (aStored.payload.size() > aParameters.parameter * sizeof(uint64_t))
+    {
+        throw std::invalid_argument("Stored sketch payload has an unexpected size");
+    }
+
+    // The minimums are hashes already, add() keeps the smallest of them.
+    for (auto sMinimum : aStored.getPayloadAs<uint64_t>())
+    {
+        aSketch.add(sMinimum);
+    }
+}
+
+void mergeStoredSketch(sketch::BBitMinHasher<uint64_t>& aSketch,
+                       const StoredSketch&              aStored,
+                       const SketchParameters&          aParameters)
+{
+    checkCompatible(aStored, SketchType::BBIT_MIN_HASH, aParameters);
+    checkPayloadSize<uint64_t>(aStored, aSketch.core().size());
+
+    mergeRegisters<uint64_t>(aSketch.core(),
+                             aStored.getPayloadAs<uint64_t>(),
+                             [](uint64_t aLeft, uint64_t aRight) { return std::min(aLeft, aRight); });
+}
+
+void mergeStoredSketch(sketch::bf_t& aSketch, const StoredSketch& aStored, const SketchParameters& aParameters)
+{
+    checkCompatible(aStored, SketchType::BLOOM_FILTER, aParameters);
+    checkPayloadSize<uint64_t>(aStored, aSketch.core().size());
+
+    mergeRegisters<uint64_t>(aSketch.core(),
+                             aStored.getPayloadAs<uint64_t>(),
+                             [](uint64_t aLeft, uint64_t aRight) { return aLeft | aRight; });
+}
+
+void mergeStoredSketch(sketch::hlf_t& aSketch, const StoredSketch& aStored, const SketchParameters& aParameters)
+{
+    checkCompatible(aStored, SketchType::HYPER_LOG_LOG_FILTER, aParameters);
+
+    auto&        sHlls         = HyperLogLogFilterAccess::getHlls(aSketch);
+    const auto&  sSeeds        = HyperLogLogFilterAccess::getSeeds(aSketch);
+    const size_t sSeedBytes    = sizeof(uint64_t) * sSeeds.size();
+    const size_t sRegisterSize = sHlls.empty() ? 0 : sHlls.front().core().size();
+    if (aStored.payload.size() != sSeedBytes + sHlls.size() * sRegisterSize
+        || std::memcmp(aStored.payload.data(), sSeeds.data(), sSeedBytes) != 0)
+    {
+        throw std::invalid_argument("Stored sketch was built with different seeds");
+    }
+
+    const auto sRegisters = aStored.payload.subspan(sSeedBytes);
+    for (size_t i = 0; i < sHlls.size(); ++i)
+    {
+        const auto sHllRegisters = sRegisters.subspan(i * sRegisterSize, sRegisterSize);
+        mergeHyperLogLogRegisters(
+            sHlls[i], {reinterpret_cast<const uint8_t*>(sHllRegisters.data()), sHllRegisters.size()});
+    }
+}
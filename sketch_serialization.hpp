@@ -0,0 +1,40 @@
+#pragma once
+
+#include "sketch_store.hpp"
+#include "sparse_hll.hpp"
+
+#include <sketch/bbmh.h>
+#include <sketch/bf.h>
+#include <sketch/hll.h>
+#include <sketch/mh.h>
+
+// Payload layouts, all arrays stored as-is:
+//   HYPER_LOG_LOG        registers (uint8_t[2^p]), also of sparse sketches, parameters {p, estimation method}
+//   RANGE_MIN_HASH       retained minimums in ascending order (uint64_t), parameters {sketch size}
+//   BBIT_MIN_HASH        registers (uint64_t[2^p]),                      parameters {p}
+//   BLOOM_FILTER         bit words (uint64_t),                           parameters {size log2, hash count, seed}
+//   HYPER_LOG_LOG_FILTER seeds (uint64_t[count]), then the registers of every HLL (uint8_t[count][2^p]),
+//                        parameters {count, p, seed}
+//
+// The merge functions read the payload straight from the store and throw std::invalid_argument when the
+// record was written with another type or other parameters than aParameters.
+
+void appendSketch(SketchStoreWriter& aWriter, const SparseHyperLogLog& aSketch, const SketchParameters& aParameters);
+void appendSketch(SketchStoreWriter&                    aWriter,
+                  const sketch::RangeMinHash<uint64_t>& aSketch,
+                  const SketchParameters&               aParameters);
+void appendSketch(SketchStoreWriter&                     aWriter,
+                  const sketch::BBitMinHasher<uint64_t>& aSketch,
+                  const SketchParameters&                aParameters);
+void appendSketch(SketchStoreWriter& aWriter, const sketch::bf_t& aSketch, const SketchParameters& aParameters);
+void appendSketch(SketchStoreWriter& aWriter, const sketch::hlf_t& aSketch, const SketchParameters& aParameters);
+
+void mergeStoredSketch(SparseHyperLogLog& aSketch, const StoredSketch& aStored, const SketchParameters& aParameters);
+void mergeStoredSketch(sketch::RangeMinHash<uint64_t>& aSketch,
+                       const StoredSketch&             aStored,
+                       const SketchParameters&         aParameters);
+void mergeStoredSketch(sketch::BBitMinHasher<uint64_t>& aSketch,
+                       const StoredSketch&              aStored,
+                       const SketchParameters&          aParameters);
+void mergeStoredSketch(sketch::bf_t& aSketch, const StoredSketch& aStored, const SketchParameters& aParameters);
+void mergeStoredSketch(sketch::hlf_t& aSketch, const StoredSketch& aStored, const SketchParameters& aParameters);
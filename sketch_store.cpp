@@ -0,0 +1,200 @@
+#include "sketch_store.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr char     MAGIC[8]        = {'S', 'K', 'S', 'T', 'O', 'R', 'E', '\0'};
+    constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    constexpr size_t   ALIGNMENT       = 64;
+
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t record_count;
+        uint64_t reserved[5];
+    };
+
+    struct RecordHeader
+    {
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t parameter;
+        uint64_t secondary_parameter;
+        uint64_t seed;
+        uint64_t payload_offset;
+        uint64_t payload_size;
+        uint64_t reserved_tail[2];
+    };
+
+    static_assert(sizeof(FileHeader) == ALIGNMENT && sizeof(RecordHeader) == ALIGNMENT);
+
+    size_t alignUp(size_t aValue)
+    {
+        return (aValue + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+
+    const RecordHeader* getRecordHeaders(const std::byte* aData)
+    {
+        return reinterpret_cast<const RecordHeader*>(aData + sizeof(FileHeader));
+    }
+}  // namespace
+
+void SketchStoreWriter::add(SketchType aType, const SketchParameters& aParameters, std::span<const std::byte> aPayload)
+{
+    records.push_back({aType, aParameters, std::vector<std::byte>(aPayload.begin(), aPayload.end())});
+}
+
+void SketchStoreWriter::write(const std::string& aPath) const
+{
+    FileHeader sHeader{};
+    std::memcpy(sHeader.magic, MAGIC, sizeof(MAGIC));
+    sHeader.version      = SKETCH_STORE_FORMAT_VERSION;
+    sHeader.byte_order   = BYTE_ORDER_MARK;
+    sHeader.record_count = records.size();
+
+    std::vector<RecordHeader> sRecordHeaders(records.size());
+
+    size_t sOffset = sizeof(FileHeader) + sizeof(RecordHeader) * records.size();
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        sRecordHeaders[i].type                = static_cast<uint32_t>(records[i].type);
+        sRecordHeaders[i].parameter           = records[i].parameters.parameter;
+        sRecordHeaders[i].secondary_parameter = records[i].parameters.secondary_parameter;
+        sRecordHeaders[i].seed                = records[i].parameters.seed;
+        sRecordHeaders[i].payload_offset      = sOffset;
+        sRecordHeaders[i].payload_size        = records[i].payload.size();
+
+        sOffset = alignUp(sOffset + records[i].payload.size());
+    }
+
+    std::ofstream sOutput(aPath, std::ios::binary | std::ios::trunc);
+    if (!sOutput)
+    {
+        throw std::runtime_error("Failed to open sketch store " + aPath + " for writing");
+    }
+
+    sOutput.write(reinterpret_cast<const char*>(&sHeader), sizeof(sHeader));
+    sOutput.write(reinterpret_cast<const char*>(sRecordHeaders.data()), sizeof(RecordHeader) * sRecordHeaders.size());
+
+    const char sPadding[ALIGNMENT]{};
+    for (const auto& sRecord : records)
+    {
+        sOutput.write(reinterpret_cast<const char*>(sRecord.payload.data()), sRecord.payload.size());
+        sOutput.write(sPadding, alignUp(sRecord.payload.size()) - sRecord.payload.size());
+    }
+
+    if (!sOutput)
+    {
+        throw std::runtime_error("Failed to write sketch store " + aPath);
+    }
+}
+
+size_t SketchStoreWriter::size() const
+{
+    return records.size();
+}
+
+MappedSketchStore::MappedSketchStore(const std::string& aPath)
+{
+    const int sDescriptor = ::open(aPath.c_str(), O_RDONLY);
+    if (sDescriptor < 0)
+    {
+        throw std::runtime_error("Failed to open sketch store " + aPath);
+    }
+
+    struct stat sStat{};
+    if (::fstat(sDescriptor, &sStat) != 0 || static_cast<size_t>(sStat.st_size) < sizeof(FileHeader))
+    {
+        ::close(sDescriptor);
+        throw std::runtime_error("Sketch store " + aPath + " is truncated");
+    }
+
+    length         = sStat.st_size;
+    void* sMapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, sDescriptor, 0);
+    ::close(sDescriptor);
+    if (sMapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map sketch store " + aPath);
+    }
+    data = static_cast<const std::byte*>(sMapping);
+
+    try
+    {
+        record_count = validate();
+    }
+    catch (...)
+    {
+        ::munmap(const_cast<std::byte*>(data), length);
+        throw;
+    }
+}
+
+MappedSketchStore::~MappedSketchStore()
+{
+    ::munmap(const_cast<std::byte*>(data), length);
+}
+
+size_t MappedSketchStore::size() const
+{
+    return record_count;
+}
+
+StoredSketch MappedSketchStore::operator[](size_t aIndex) const
+{
+    const auto& sHeader = getRecordHeaders(data)[aIndex];
+
+    return {static_cast<SketchType>(sHeader.type),
+            {sHeader.parameter, sHeader.secondary_parameter, sHeader.seed},
+            {data + sHeader.payload_offset, sHeader.payload_size}};
+}
+
+size_t MappedSketchStore::validate() const
+{
+    FileHeader sHeader;
+    std::memcpy(&sHeader, data, sizeof(sHeader));
+
+    if (std::memcmp(sHeader.magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        throw std::runtime_error("Not a sketch store");
+    }
+    if (sHeader.version != SKETCH_STORE_FORMAT_VERSION)
+    {
+        throw std::runtime_error("Unsupported sketch store version " + std::to_string(sHeader.version));
+    }
+    if (sHeader.byte_order != BYTE_ORDER_MARK)
+    {
+        throw std::runtime_error("Sketch store was written with another byte order");
+    }
+    if (sHeader.record_count > (length - sizeof(FileHeader)) / sizeof(RecordHeader))
+    {
+        throw std::runtime_error("Sketch store record table is truncated");
+    }
+
+    const auto* sRecordHeaders = getRecordHeaders(data);
+    for (size_t i = 0; i < sHeader.record_count; ++i)
+    {
+        const auto& sRecord = sRecordHeaders[i];
+        if (sRecord.payload_offset % ALIGNMENT != 0 || sRecord.payload_offset > length
+            || sRecord.payload_size > length - sRecord.payload_offset)
+        {
+            throw std::runtime_error("Sketch store record " + std::to_string(i) + " is out of bounds");
+        }
+        if (sRecord.type < static_cast<uint32_t>(SketchType::HYPER_LOG_LOG)
+            || sRecord.type > static_cast<uint32_t>(SketchType::HYPER_LOG_LOG_FILTER))
+        {
+            throw std::runtime_error("Sketch store record " + std::to_string(i) + " has an unknown type");
+        }
+    }
+
+    return sHeader.record_count;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Versioned binary container for precomputed sketches. A store is a 64-byte file header, a table of
+// 64-byte record headers and the record payloads, every payload aligned to 64 bytes so that it can be
+// read in place from a memory mapping. All integers are stored in the host (little-endian) byte order.
+enum class SketchType : uint32_t
+{
+    HYPER_LOG_LOG        = 1,
+    RANGE_MIN_HASH       = 2,
+    BBIT_MIN_HASH        = 3,
+    BLOOM_FILTER         = 4,
+    HYPER_LOG_LOG_FILTER = 5
+};
+
+// Whatever is needed to tell whether two sketches of the same type can be merged.
+struct SketchParameters
+{
+    uint64_t parameter{0};
+    uint64_t secondary_parameter{0};
+    uint64_t seed{0};
+
+    bool operator==(const SketchParameters&) const = default;
+};
+
+// View of a record, the payload points into the mapped file.
+struct StoredSketch
+{
+    SketchType                 type;
+    SketchParameters           parameters;
+    std::span<const std::byte> payload;
+
+    template <typename T>
+    std::span<const T> getPayloadAs() const
+    {
+        return {reinterpret_cast<const T*>(payload.data()), payload.size() / sizeof(T)};
+    }
+};
+
+constexpr uint32_t SKETCH_STORE_FORMAT_VERSION = 1;
+
+class SketchStoreWriter
+{
+public:
+    void   add(SketchType aType, const SketchParameters& aParameters, std::span<const std::byte> aPayload);
+    void   write(const std::string& aPath) const;
+    size_t size() const;
+
+    template <typename T>
+    void add(SketchType aType, const SketchParameters& aParameters, std::span<const T> aPayload)
+    {
+        add(aType, aParameters, std::as_bytes(aPayload));
+    }
+
+private:
+    struct Record
+    {
+        SketchType             type;
+        SketchParameters       parameters;
+        std::vector<std::byte> payload;
+    };
+
+    std::vector<Record> records;
+};
+
+// Read-only memory mapping of a store written by SketchStoreWriter. Throws std::runtime_error when the file
+// cannot be mapped, is truncated or was written with another format version.
+class MappedSketchStore
+{
+public:
+    explicit MappedSketchStore(const std::string& aPath);
+    ~MappedSketchStore();
+
+    MappedSketchStore(const MappedSketchStore&)            = delete;
+    MappedSketchStore& operator=(const MappedSketchStore&) = delete;
+
+    size_t       size() const;
+    StoredSketch operator[](size_t aIndex) const;
+
+private:
+    const std::byte* data{nullptr};
+    size_t           length{0};
+    size_t           record_count{0};
+
+    // Returns the record count.
+    size_t validate() const;
+};
@@ -0,0 +1,239 @@
+#include "sketch_wire_format.hpp"
+
+#include "wire_codecs.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    enum class HyperLogLogEncoding : uint8_t
+    {
+        SPARSE = 0,
+        PACKED = 1
+    };
+
+    constexpr uint32_t HYPER_LOG_LOG_REGISTER_BITS = 6;
+    // At precision p a rank reaches 64 - p + 1, which only fits HYPER_LOG_LOG_REGISTER_BITS from p = 2 on.
+    constexpr uint32_t MIN_HYPER_LOG_LOG_PRECISION = 2;
+    // Registers of b-bit MinHash buckets that saw no hash.
+    constexpr uint64_t EMPTY_MIN_HASH_REGISTER = std::numeric_limits<uint64_t>::max();
+
+    WireWriter startMessage(SketchType aType, const SketchParameters& aParameters)
+    {
+        WireWriter sWriter;
+        sWriter.writeByte(static_cast<uint8_t>(aType));
+        sWriter.writeVarint(aParameters.parameter);
+        sWriter.writeVarint(aParameters.secondary_parameter);
+        sWriter.writeVarint(aParameters.seed);
+
+        return sWriter;
+    }
+
+    WireReader openMessage(std::span<const std::byte> aMessage, SketchType aType, const SketchParameters& aParameters)
+    {
+        WireReader sReader(aMessage);
+        if (static_cast<SketchType>(sReader.readByte()) != aType)
+        {
+            throw std::invalid_argument("Encoded sketch has a different type");
+        }
+
+        SketchParameters sParameters;
+        sParameters.parameter           = sReader.readVarint();
+        sParameters.secondary_parameter = sReader.readVarint();
+        sParameters.seed                = sReader.readVarint();
+        if (sParameters != aParameters)
+        {
+            throw std::invalid_argument("Encoded sketch was built with different parameters");
+        }
+
+        return sReader;
+    }
+
+    void checkEnd(const WireReader& aReader)
+    {
+        if (!aReader.atEnd())
+        {
+            throw std::invalid_argument("Encoded sketch has trailing bytes");
+        }
+    }
+
+    void checkHyperLogLogPrecision(uint32_t aBucketCountLog2)
+    {
+        if (aBucketCountLog2 < MIN_HYPER_LOG_LOG_PRECISION)
+        {
+            throw std::invalid_argument("Encoded HyperLogLog sketches need a precision of at least 2");
+        }
+    }
+}  // namespace
+
+std::vector<std::byte> encodeSketch(const SparseHyperLogLog& aSketch, const SketchParameters& aParameters)
+{
+    checkHyperLogLogPrecision(aSketch.getBucketCountLog2());
+
+    auto sWriter = startMessage(SketchType::HYPER_LOG_LOG, aParameters);
+
+    if (const auto* sSparse = aSketch.getSparseRegisters())
+    {
+        auto sCompacted = *sSparse;
+        sCompacted.compact();
+
+        std::vector<uint64_t> sEntries;
+        sEntries.reserve(sCompacted.size());
+        sCompacted.forEachRegister([&](uint32_t aIndex, uint8_t aRank)
+                                   { sEntries.push_back(uint64_t{aIndex} << 8 | aRank); });
+
+        sWriter.writeByte(static_cast<uint8_t>(HyperLogLogEncoding::SPARSE));
+        writeSortedValues(sWriter, sEntries);
+    }
+    else
+    {
+        sWriter.writeByte(static_cast<uint8_t>(HyperLogLogEncoding::PACKED));
+        writePackedRegisters(sWriter, aSketch.getRegisters(), HYPER_LOG_LOG_REGISTER_BITS);
+    }
+
+    return sWriter.release();
+}
+
+std::vector<std::byte> encodeSketch(const sketch::RangeMinHash<uint64_t>& aSketch, const SketchParameters& aParameters)
+{
+    auto sWriter = startMessage(SketchType::RANGE_MIN_HASH, aParameters);
+    writeSortedValues(sWriter, aSketch.mh2vec());
+
+    return sWriter.release();
+}
+
+std::vector<std::byte> encodeSketch(const sketch::BBitMinHasher<uint64_t>& aSketch, const SketchParameters& aParameters)
+{
+    auto        sWriter    = startMessage(SketchType::BBIT_MIN_HASH, aParameters);
+    const auto& sRegisters = aSketch.core();
+
+    std::vector<uint64_t> sOccupied((sRegisters.size() + 63) / 64);
+    for (size_t i = 0; i < sRegisters.size(); ++i)
+    {
+        if (sRegisters[i] != EMPTY_MIN_HASH_REGISTER)
+        {
+            sOccupied[i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+
+    writeBitmap(sWriter, sOccupied);
+    for (auto sRegister : sRegisters)
+    {
+        if (sRegister != EMPTY_MIN_HASH_REGISTER)
+        {
+            sWriter.writeValue(encodeMinimum(sRegister));
+        }
+    }
+
+    return sWriter.release();
+}
+
+std::vector<std::byte> encodeSketch(const sketch::bf_t& aSketch, const SketchParameters& aParameters)
+{
+    auto sWriter = startMessage(SketchType::BLOOM_FILTER, aParameters);
+    writeBitmap(sWriter, aSketch.core());
+
+    return sWriter.release();
+}
+
+void mergeEncodedSketch(SparseHyperLogLog&         aSketch,
+                        std::span<const std::byte> aMessage,
+                        const SketchParameters&    aParameters)
+{
+    auto sReader = openMessage(aMessage, SketchType::HYPER_LOG_LOG, aParameters);
+
+    const uint32_t sBucketCountLog2 = aSketch.getBucketCountLog2();
+    checkHyperLogLogPrecision(sBucketCountLog2);
+    const auto     sEncoding        = static_cast<HyperLogLogEncoding>(sReader.readByte());
+    if (sEncoding == HyperLogLogEncoding::SPARSE)
+    {
+        SparseHyperLogLogRegisters sRegisters(sBucketCountLog2);
+        for (auto sEntry : readSortedValues(sReader))
+        {
+            const uint64_t sIndex = sEntry >> 8;
+            const auto     sRank  = static_cast<uint8_t>(sEntry);
+            if (sIndex >> sBucketCountLog2 != 0 || sRank == 0 || sRank > 64 - sBucketCountLog2 + 1)
+            {
+                throw std::invalid_argument("Encoded sketch has an invalid register");
+            }
+            sRegisters.addRegister(static_cast<uint32_t>(sIndex), sRank);
+        }
+
+        checkEnd(sReader);
+        aSketch += SparseHyperLogLog(std::move(sRegisters), aSketch.getEstimationMethod());
+        return;
+    }
+    if (sEncoding != HyperLogLogEncoding::PACKED)
+    {
+        throw std::invalid_argument("Encoded sketch has an unknown encoding");
+    }
+
+    std::vector<uint8_t> sRegisters(size_t{1} << sBucketCountLog2);
+    readPackedRegisters(sReader, sRegisters, HYPER_LOG_LOG_REGISTER_BITS);
+    checkEnd(sReader);
+
+    auto& sDense = aSketch.densify();
+    auto& sCore  = sDense.core();
+    for (size_t i = 0; i < sRegisters.size(); ++i)
+    {
+        sCore[i] = std::max(sCore[i], sRegisters[i]);
+    }
+    // Registers were changed behind the sketch's back, refresh its cached estimate.
+    sDense.sum();
+}
+
+void mergeEncodedSketch(sketch::RangeMinHash<uint64_t>& aSketch,
+                        std::span<const std::byte>      aMessage,
+                        const SketchParameters&         aParameters)
+{
+    auto       sReader   = openMessage(aMessage, SketchType::RANGE_MIN_HASH, aParameters);
+    const auto sMinimums = readSortedValues(sReader);
+    checkEnd(sReader);
+
+    // The minimums are hashes already, add() keeps the smallest of them.
+    for (auto sMinimum : sMinimums)
+    {
+        aSketch.add(sMinimum);
+    }
+}
+
+void mergeEncodedSketch(sketch::BBitMinHasher<uint64_t>& aSketch,
+                        std::span<const std::byte>       aMessage,
+                        const SketchParameters&          aParameters)
+{
+    auto  sReader = openMessage(aMessage, SketchType::BBIT_MIN_HASH, aParameters);
+    auto& sCore   = aSketch.core();
+
+    std::vector<uint64_t> sOccupied((sCore.size() + 63) / 64);
+    readBitmap(sReader, sOccupied);
+
+    size_t sOccupiedCount = 0;
+    for (auto sWord : sOccupied)
+    {
+        sOccupiedCount += static_cast<size_t>(std::popcount(sWord));
+    }
+    const auto sCodes = sReader.readBytes(sOccupiedCount * sizeof(uint16_t));
+    checkEnd(sReader);
+
+    size_t sNextCode = 0;
+    for (size_t i = 0; i < sCore.size(); ++i)
+    {
+        if ((sOccupied[i / 64] >> (i % 64) & 1) != 0)
+        {
+            uint16_t sCode;
+            std::memcpy(&sCode, sCodes.data() + sNextCode++ * sizeof(uint16_t), sizeof(uint16_t));
+            sCore[i] = std::min(sCore[i], decodeMinimum(sCode));
+        }
+    }
+}
+
+void mergeEncodedSketch(sketch::bf_t& aSketch, std::span<const std::byte> aMessage, const SketchParameters& aParameters)
+{
+    auto sReader = openMessage(aMessage, SketchType::BLOOM_FILTER, aParameters);
+    readBitmap(sReader, aSketch.core());
+    checkEnd(sReader);
+}
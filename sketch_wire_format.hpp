@@ -0,0 +1,45 @@
+#pragma once
+
+#include "sketch_store.hpp"
+#include "sparse_hll.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <sketch/bbmh.h>
+#include <sketch/bf.h>
+#include <sketch/mh.h>
+
+// Compact encodings of per-shard sketches, for shards on other nodes shipping their states to an aggregator
+// instead of their ids. A message starts with the sketch type and the varint parameters, as in a sketch store
+// record, followed by the encoded sketch:
+//   HYPER_LOG_LOG  sparse: (index << 8 | rank) of the non-zero registers as varint gaps,
+//                  dense:  registers packed into 6 bits each, so the precision must be at least 2
+//   RANGE_MIN_HASH retained minimums as varint gaps
+//   BBIT_MIN_HASH  bitmap of the non-empty registers, then their 16-bit codes, see encodeMinimum. Lossy: the
+//                  receiver gets every register rounded up to the largest value of its code, which merges exactly
+//                  with other coded registers.
+//   BLOOM_FILTER   bit words, run-length encoded or as set bit positions
+//
+// The merge functions throw std::invalid_argument when the message is malformed or was encoded with another type
+// or other parameters than aParameters. Both sides throw it for a HyperLogLog precision below 2.
+
+std::vector<std::byte> encodeSketch(const SparseHyperLogLog& aSketch, const SketchParameters& aParameters);
+std::vector<std::byte> encodeSketch(const sketch::RangeMinHash<uint64_t>& aSketch, const SketchParameters& aParameters);
+std::vector<std::byte> encodeSketch(const sketch::BBitMinHasher<uint64_t>& aSketch,
+                                    const SketchParameters&                aParameters);
+std::vector<std::byte> encodeSketch(const sketch::bf_t& aSketch, const SketchParameters& aParameters);
+
+void mergeEncodedSketch(SparseHyperLogLog&         aSketch,
+                        std::span<const std::byte> aMessage,
+                        const SketchParameters&    aParameters);
+void mergeEncodedSketch(sketch::RangeMinHash<uint64_t>& aSketch,
+                        std::span<const std::byte>      aMessage,
+                        const SketchParameters&         aParameters);
+void mergeEncodedSketch(sketch::BBitMinHasher<uint64_t>& aSketch,
+                        std::span<const std::byte>       aMessage,
+                        const SketchParameters&          aParameters);
+void mergeEncodedSketch(sketch::bf_t&              aSketch,
+                        std::span<const std::byte> aMessage,
+                        const SketchParameters&    aParameters);
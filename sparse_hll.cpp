@@ -0,0 +1,174 @@
+#include "sparse_hll.hpp"
+
+#include "hashing.hpp"
+
+namespace
+{
+    // Dense registers per sparse entry at which a sketch turns dense: an entry takes four bytes, a register one.
+    constexpr uint64_t REGISTERS_PER_SPARSE_ENTRY = 8;
+
+    std::variant<SparseHyperLogLogRegisters, sketch::hll_t>
+    makeEmptyRegisters(uint32_t aBucketCountLog2, sketch::hll::EstimationMethod aMethod)
+    {
+        if (aBucketCountLog2 > SparseHyperLogLogRegisters::MAX_PRECISION)
+        {
+            return sketch::hll_t(aBucketCountLog2, aMethod);
+        }
+
+        return SparseHyperLogLogRegisters(aBucketCountLog2);
+    }
+}  // namespace
+
+SparseHyperLogLog::SparseHyperLogLog(uint32_t aBucketCountLog2, sketch::hll::EstimationMethod aMethod)
+: bucket_count_log2(aBucketCountLog2)
+, estimation_method(aMethod)
+, registers(makeEmptyRegisters(aBucketCountLog2, aMethod))
+{}
+
+SparseHyperLogLog::SparseHyperLogLog(SparseHyperLogLogRegisters aRegisters, sketch::hll::EstimationMethod aMethod)
+: bucket_count_log2(aRegisters.getPrecision()), estimation_method(aMethod), registers(std::move(aRegisters))
+{
+    densifyIfLarge();
+}
+
+void SparseHyperLogLog::add(uint64_t aHash)
+{
+    if (auto* sSparse = std::get_if<SparseHyperLogLogRegisters>(&registers))
+    {
+        sSparse->add(aHash);
+        densifyIfLarge();
+    }
+    else
+    {
+        std::get<sketch::hll_t>(registers).add(aHash);
+    }
+}
+
+void SparseHyperLogLog::addh(uint64_t aId)
+{
+    add(wangHash(aId));
+}
+
+SparseHyperLogLog& SparseHyperLogLog::operator+=(const SparseHyperLogLog& aOther)
+{
+    const auto* sOtherSparse = std::get_if<SparseHyperLogLogRegisters>(&aOther.registers);
+    if (auto* sSparse = std::get_if<SparseHyperLogLogRegisters>(&registers);
+        sSparse != nullptr && sOtherSparse != nullptr)
+    {
+        sSparse->merge(*sOtherSparse);
+        densifyIfLarge();
+    }
+    else if (sOtherSparse != nullptr)
+    {
+        auto& sDense = std::get<sketch::hll_t>(registers);
+        sOtherSparse->fillRegisters(sDense.core());
+        // Registers were changed behind the sketch's back, refresh its cached estimate.
+        sDense.sum();
+    }
+    else
+    {
+        densify() += std::get<sketch::hll_t>(aOther.registers);
+    }
+
+    return *this;
+}
+
+SparseHyperLogLog SparseHyperLogLog::operator+(const SparseHyperLogLog& aOther) const
+{
+    SparseHyperLogLog sResult(*this);
+    sResult += aOther;
+
+    return sResult;
+}
+
+double SparseHyperLogLog::cardinality_estimate() const
+{
+    if (const auto* sSparse = std::get_if<SparseHyperLogLogRegisters>(&registers))
+    {
+        return makeDense(*sSparse).cardinality_estimate();
+    }
+
+    return std::get<sketch::hll_t>(registers).cardinality_estimate();
+}
+
+bool SparseHyperLogLog::isSparse() const
+{
+    return std::holds_alternative<SparseHyperLogLogRegisters>(registers);
+}
+
+const SparseHyperLogLogRegisters* SparseHyperLogLog::getSparseRegisters() const
+{
+    return std::get_if<SparseHyperLogLogRegisters>(&registers);
+}
+
+sketch::hll_t& SparseHyperLogLog::densify()
+{
+    if (const auto* sSparse = std::get_if<SparseHyperLogLogRegisters>(&registers))
+    {
+        registers = makeDense(*sSparse);
+    }
+
+    return std::get<sketch::hll_t>(registers);
+}
+
+std::vector<uint8_t> SparseHyperLogLog::getRegisters() const
+{
+    if (const auto* sSparse = std::get_if<SparseHyperLogLogRegisters>(&registers))
+    {
+        std::vector<uint8_t> sResult(size_t{1} << bucket_count_log2);
+        sSparse->fillRegisters(sResult);
+
+        return sResult;
+    }
+
+    const auto& sCore = std::get<sketch::hll_t>(registers).core();
+    return std::vector<uint8_t>(sCore.begin(), sCore.end());
+}
+
+uint32_t SparseHyperLogLog::getBucketCountLog2() const
+{
+    return bucket_count_log2;
+}
+
+sketch::hll::EstimationMethod SparseHyperLogLog::getEstimationMethod() const
+{
+    return estimation_method;
+}
+
+uint64_t SparseHyperLogLog::estimateMemoryUsage() const
+{
+    if (const auto* sSparse = std::get_if<SparseHyperLogLogRegisters>(&registers))
+    {
+        return sSparse->estimateMemoryUsage();
+    }
+
+    const auto sUsage = std::get<sketch::hll_t>(registers).est_memory_usage();
+    return sUsage.first + sUsage.second;
+}
+
+sketch::hll_t SparseHyperLogLog::makeDense(const SparseHyperLogLogRegisters& aSparse) const
+{
+    sketch::hll_t sResult(bucket_count_log2, estimation_method);
+    aSparse.fillRegisters(sResult.core());
+    sResult.sum();
+
+    return sResult;
+}
+
+void SparseHyperLogLog::densifyIfLarge()
+{
+    auto&          sSparse     = std::get<SparseHyperLogLogRegisters>(registers);
+    const uint64_t sEntryLimit = (uint64_t{1} << bucket_count_log2) / REGISTERS_PER_SPARSE_ENTRY;
+    // Entries of the same index may still be counted twice, so the size is only checked after compacting. The
+    // slack keeps a sketch just below the limit from compacting on every add.
+    if (sSparse.size() <= sEntryLimit + sEntryLimit / 4)
+    {
+        return;
+    }
+
+    sSparse.compact();
+    if (sSparse.size() > sEntryLimit)
+    {
+        densify();
+    }
+}
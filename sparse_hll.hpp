@@ -0,0 +1,54 @@
+#pragma once
+
+#include "hll_sparse_registers.hpp"
+
+#include <variant>
+#include <vector>
+
+#include <sketch/hll.h>
+
+// HyperLogLog that holds its non-zero registers as a sparse list while they take about half the dense
+// registers, and turns into a dense sketch::hll_t after that, as HLL++ does. Both representations hold the same
+// registers, so estimates and merges do not depend on when a sketch switched. Per-shard sketches of small shards
+// thereby cost a few bytes per id rather than 2^aBucketCountLog2 bytes each.
+class SparseHyperLogLog
+{
+public:
+    // Precisions above SparseHyperLogLogRegisters::MAX_PRECISION start dense.
+    SparseHyperLogLog(uint32_t aBucketCountLog2, sketch::hll::EstimationMethod aMethod);
+    // Sparse sketch holding aRegisters, turns dense right away if they are too many.
+    SparseHyperLogLog(SparseHyperLogLogRegisters aRegisters, sketch::hll::EstimationMethod aMethod);
+
+    void add(uint64_t aHash);
+    // Hashes like sketch::hll_t::addh.
+    void addh(uint64_t aId);
+
+    // Both sketches must have the same bucket count.
+    SparseHyperLogLog& operator+=(const SparseHyperLogLog& aOther);
+    SparseHyperLogLog  operator+(const SparseHyperLogLog& aOther) const;
+
+    // Estimate of the dense sketch, a sparse one is densified into a temporary for it. Named after the sketch
+    // library's method, which the generic estimator code calls.
+    double cardinality_estimate() const;
+
+    bool                              isSparse() const;
+    // nullptr once the sketch is dense.
+    const SparseHyperLogLogRegisters* getSparseRegisters() const;
+    // Switches to the dense representation if needed. Callers changing the registers call sum() afterwards.
+    sketch::hll_t&                    densify();
+    // The dense register layout, also for a sparse sketch.
+    std::vector<uint8_t>              getRegisters() const;
+
+    uint32_t                      getBucketCountLog2() const;
+    sketch::hll::EstimationMethod getEstimationMethod() const;
+    uint64_t                      estimateMemoryUsage() const;
+
+private:
+    uint32_t                                                bucket_count_log2{0};
+    sketch::hll::EstimationMethod                           estimation_method;
+    std::variant<SparseHyperLogLogRegisters, sketch::hll_t> registers;
+
+    sketch::hll_t makeDense(const SparseHyperLogLogRegisters& aSparse) const;
+    // Densifies once the sparse entries would take more than half of the dense registers.
+    void          densifyIfLarge();
+};
@@ -0,0 +1,135 @@
+#include "split_block_bloom_filter.hpp"
+
+#include <algorithm>
+
+#include <immintrin.h>
+
+namespace
+{
+    // Odd multipliers of the eight words, as in the Parquet and Impala filters.
+    alignas(32) constexpr uint32_t SALTS[SplitBlockBloomFilter::WORDS_PER_BLOCK]
+        = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+#if defined(__AVX2__)
+    // One bit per 32-bit lane, chosen by the top five bits of aKey * SALTS[lane].
+    inline __m256i makeMask(uint32_t aKey)
+    {
+        const __m256i sSalts   = _mm256_load_si256(reinterpret_cast<const __m256i*>(SALTS));
+        const __m256i sProduct = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(aKey)), sSalts);
+
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), _mm256_srli_epi32(sProduct, 27));
+    }
+#endif
+
+    inline uint32_t maskWord(uint32_t aKey, uint32_t aWord)
+    {
+        return uint32_t{1} << ((aKey * SALTS[aWord]) >> 27);
+    }
+}  // namespace
+
+SplitBlockBloomFilter::SplitBlockBloomFilter(uint32_t aBlockCountLog2, uint64_t aSeed)
+: block_count_log2(std::clamp(aBlockCountLog2, 1u, 32u))
+, seed(aSeed)
+, blocks(uint64_t{1} << block_count_log2)
+{}
+
+void SplitBlockBloomFilter::add(uint64_t aId)
+{
+    const uint64_t sHash  = hash(aId);
+    const auto     sKey   = static_cast<uint32_t>(sHash);
+    Block&         sBlock = blocks[blockIndex(sHash)];
+
+#if defined(__AVX2__)
+    auto* sWords = reinterpret_cast<__m256i*>(sBlock.words);
+    _mm256_store_si256(sWords, _mm256_or_si256(_mm256_load_si256(sWords), makeMask(sKey)));
+#else
+    for (uint32_t i = 0; i < WORDS_PER_BLOCK; ++i)
+    {
+        sBlock.words[i] |= maskWord(sKey, i);
+    }
+#endif
+}
+
+void SplitBlockBloomFilter::addIds(std::span<const uint64_t> aIds)
+{
+    for (auto sId : aIds)
+    {
+        add(sId);
+    }
+}
+
+bool SplitBlockBloomFilter::mayContain(uint64_t aId) const
+{
+    return probe(hash(aId));
+}
+
+void SplitBlockBloomFilter::mayContainBatch(std::span<const uint64_t> aIds, std::span<uint8_t> aResults) const
+{
+    constexpr size_t GROUP_SIZE = 16;
+
+    uint64_t sHashes[GROUP_SIZE];
+    for (size_t sOffset = 0; sOffset < aIds.size(); sOffset += GROUP_SIZE)
+    {
+        const size_t sCount = std::min(GROUP_SIZE, aIds.size() - sOffset);
+        for (size_t i = 0; i < sCount; ++i)
+        {
+            sHashes[i] = hash(aIds[sOffset + i]);
+            __builtin_prefetch(&blocks[blockIndex(sHashes[i])]);
+        }
+
+        for (size_t i = 0; i < sCount; ++i)
+        {
+            aResults[sOffset + i] = probe(sHashes[i]);
+        }
+    }
+}
+
+bool SplitBlockBloomFilter::probe(uint64_t aHash) const
+{
+    const auto   sKey   = static_cast<uint32_t>(aHash);
+    const Block& sBlock = blocks[blockIndex(aHash)];
+
+#if defined(__AVX2__)
+    // testc sets the carry flag when every bit of the mask is set in the block.
+    return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(sBlock.words)), makeMask(sKey));
+#else
+    bool sResult = true;
+    for (uint32_t i = 0; i < WORDS_PER_BLOCK; ++i)
+    {
+        sResult &= (sBlock.words[i] & maskWord(sKey, i)) != 0;
+    }
+
+    return sResult;
+#endif
+}
+
+SplitBlockBloomFilter& SplitBlockBloomFilter::operator|=(const SplitBlockBloomFilter& aOther)
+{
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        for (uint32_t sWord = 0; sWord < WORDS_PER_BLOCK; ++sWord)
+        {
+            blocks[i].words[sWord] |= aOther.blocks[i].words[sWord];
+        }
+    }
+
+    return *this;
+}
+
+SplitBlockBloomFilter& SplitBlockBloomFilter::operator&=(const SplitBlockBloomFilter& aOther)
+{
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        for (uint32_t sWord = 0; sWord < WORDS_PER_BLOCK; ++sWord)
+        {
+            blocks[i].words[sWord] &= aOther.blocks[i].words[sWord];
+        }
+    }
+
+    return *this;
+}
+
+uint64_t SplitBlockBloomFilter::estimateMemoryUsage() const
+{
+    return blocks.size() * sizeof(Block);
+}
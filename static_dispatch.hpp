@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Calls aFunction(std::integral_constant<uint32_t, aValue>{}), turning a runtime parameter into a compile-time
+// constant so that loops over it unroll and the arithmetic on it folds. aFunction is instantiated once per value
+// in [MIN, MAX]; aValue must be in that range.
+template <uint32_t MIN, uint32_t MAX, typename Function>
+decltype(auto) dispatchConstant(uint32_t aValue, Function&& aFunction)
+{
+    static_assert(MIN <= MAX);
+
+    if constexpr (MIN == MAX)
+    {
+        return aFunction(std::integral_constant<uint32_t, MIN>{});
+    }
+    else
+    {
+        if (aValue == MIN)
+        {
+            return aFunction(std::integral_constant<uint32_t, MIN>{});
+        }
+
+        return dispatchConstant<MIN + 1, MAX>(aValue, std::forward<Function>(aFunction));
+    }
+}
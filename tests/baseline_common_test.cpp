@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include "baseline_common.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace
+{
+    ShardData MakeShardData(const std::vector<std::vector<uint64_t>> &aShards)
+    {
+        ShardData sResult;
+        for (const auto &sShard : aShards)
+        {
+            sResult.ids.insert(sResult.ids.end(), sShard.begin(), sShard.end());
+            sResult.offsets.push_back(sResult.ids.size());
+        }
+        sResult.total_size = sResult.ids.size();
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(RadixSortTest, MatchesStdSort)
+{
+    std::mt19937_64       sEngine(42);
+    std::vector<uint64_t> sValues(100'000);
+    std::generate(sValues.begin(), sValues.end(), sEngine);
+    sValues.insert(sValues.end(), {0, 0, UINT64_MAX, 1, UINT64_MAX});
+
+    auto sExpected = sValues;
+    std::sort(sExpected.begin(), sExpected.end());
+
+    details::radixSort(sValues);
+    EXPECT_EQ(sValues, sExpected);
+}
+
+TEST(RadixSortTest, SharedDigits)
+{
+    std::vector<uint64_t> sValues{7, 3, 5, 3, 1};
+    details::radixSort(sValues);
+    EXPECT_EQ(sValues, (std::vector<uint64_t>{1, 3, 3, 5, 7}));
+}
+
+TEST(BaselineCommonTest, PassCondition)
+{
+    const std::vector<ShardData> sDependencies{MakeShardData({{1, 2, 3}, {4, 5}}),
+                                               MakeShardData({{2, 4}, {6}}),
+                                               MakeShardData({{4}, {7, 2}})};
+
+    BaselineCommon sBaseline;
+
+    sBaseline.addShardData(sDependencies, 1);
+    EXPECT_EQ(sBaseline.getIds(), (std::vector<uint64_t>{1, 2, 3, 4, 5, 6, 7}));
+
+    sBaseline.addShardData(sDependencies, 2);
+    EXPECT_EQ(sBaseline.getIds(), (std::vector<uint64_t>{2, 4}));
+
+    sBaseline.addShardData(sDependencies, 3);
+    EXPECT_EQ(sBaseline.getIds(), (std::vector<uint64_t>{2, 4}));
+    EXPECT_EQ(sBaseline.estimateMemoryUsage(), 2 * sizeof(uint64_t));
+
+    sBaseline.addShardData(sDependencies, 4);
+    EXPECT_TRUE(sBaseline.getIds().empty());
+}
+
+TEST(BaselineCommonTest, DependenciesOneAtATime)
+{
+    const std::vector<ShardData> sDependencies{MakeShardData({{1, 2, 3}, {4, 5}}),
+                                               MakeShardData({{2, 4}, {6}}),
+                                               MakeShardData({{4}, {7, 2}})};
+
+    BaselineCommon sBaseline;
+    for (uint32_t sPassCondition : {1, 2, 3})
+    {
+        BaselineCommon sExpected;
+        sExpected.addShardData(sDependencies, sPassCondition);
+
+        for (const auto &sDependency : sDependencies)
+        {
+            sBaseline.addDependencyData(sDependency);
+        }
+        sBaseline.finishDependencies(sPassCondition);
+        EXPECT_EQ(sBaseline.getIds(), sExpected.getIds()) << sPassCondition;
+    }
+}
+
+TEST(BaselineCommonTest, Contains)
+{
+    BaselineCommon sBaseline;
+    EXPECT_FALSE(sBaseline.contains(0));
+
+    sBaseline.addShardData({MakeShardData({{10, 20, 30}, {40, 50}})}, 1);
+    for (uint64_t sId : {10, 20, 30, 40, 50})
+    {
+        EXPECT_TRUE(sBaseline.contains(sId));
+    }
+    for (uint64_t sId : std::initializer_list<uint64_t>{0, 15, 25, 45, 51, UINT64_MAX})
+    {
+        EXPECT_FALSE(sBaseline.contains(sId));
+    }
+}
+
+TEST(BaselineCommonTest, ContainsBatchMatchesContains)
+{
+    std::mt19937_64       sEngine(42);
+    std::vector<uint64_t> sIds(1'000);
+    std::generate(sIds.begin(), sIds.end(), [&] { return sEngine() % 4'000; });
+
+    BaselineCommon sBaseline;
+    sBaseline.addShardData({MakeShardData({sIds})}, 1);
+
+    // Not a multiple of the group size, and covering ids past both ends.
+    std::vector<uint64_t> sProbes(4'003);
+    std::iota(sProbes.begin(), sProbes.end(), 0);
+    sProbes.push_back(UINT64_MAX);
+
+    std::vector<uint8_t> sResults(sProbes.size());
+    sBaseline.containsBatch(sProbes, sResults);
+    for (size_t i = 0; i < sProbes.size(); ++i)
+    {
+        ASSERT_EQ(sResults[i], sBaseline.contains(sProbes[i])) << sProbes[i];
+    }
+
+    BaselineCommon sEmpty;
+    sEmpty.containsBatch(sProbes, sResults);
+    EXPECT_EQ(std::count(sResults.begin(), sResults.end(), 1), 0);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "binary_fuse_filter.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace
+{
+    std::vector<uint64_t> MakeRandomIds(size_t aCount, uint64_t aSeed)
+    {
+        std::mt19937_64       sEngine(aSeed);
+        std::vector<uint64_t> sResult(aCount);
+        std::generate(sResult.begin(), sResult.end(), sEngine);
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(BinaryFuseFilterTest, NoFalseNegatives)
+{
+    for (size_t sCount : {1, 2, 10, 1'000, 100'000})
+    {
+        const auto       sIds = MakeRandomIds(sCount, sCount);
+        BinaryFuseFilter sFilter(sIds, 137);
+
+        for (auto sId : sIds)
+        {
+            ASSERT_TRUE(sFilter.mayContain(sId)) << sCount << ' ' << sId;
+        }
+    }
+}
+
+TEST(BinaryFuseFilterTest, FalsePositiveRateAndSize)
+{
+    const auto       sIds = MakeRandomIds(1'000'000, 1);
+    BinaryFuseFilter sFilter(sIds, 137);
+
+    // 1/256 expected.
+    uint32_t sFalsePositives = 0;
+    for (auto sId : MakeRandomIds(1'000'000, 2))
+    {
+        sFalsePositives += sFilter.mayContain(sId);
+    }
+    EXPECT_LT(sFalsePositives, 1'000'000 / 200);
+
+    EXPECT_LT(sFilter.estimateMemoryUsage() * 8, sIds.size() * 10);
+}
+
+TEST(BinaryFuseFilterTest, BatchMatchesSingle)
+{
+    const auto       sIds = MakeRandomIds(10'000, 4);
+    BinaryFuseFilter sFilter(sIds, 137);
+
+    auto sProbes = MakeRandomIds(1'003, 5);
+    sProbes.insert(sProbes.end(), sIds.begin(), sIds.begin() + 100);
+
+    std::vector<uint8_t> sResults(sProbes.size());
+    sFilter.mayContainBatch(sProbes, sResults);
+    for (size_t i = 0; i < sProbes.size(); ++i)
+    {
+        ASSERT_EQ(sResults[i], sFilter.mayContain(sProbes[i])) << sProbes[i];
+    }
+}
+
+TEST(BinaryFuseFilterTest, Empty)
+{
+    BinaryFuseFilter sFilter(std::span<const uint64_t>{}, 137);
+    EXPECT_FALSE(sFilter.mayContain(0));
+    EXPECT_EQ(sFilter.estimateMemoryUsage(), 0);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "bottom_k_sketch.hpp"
+#include "hashing.hpp"
+
+#include <cmath>
+#include <map>
+
+namespace
+{
+    // Ids [aBegin, aEnd) hashed into a fresh sketch.
+    CountingBottomKSketch MakeSketch(uint32_t aSampleSize, uint64_t aBegin, uint64_t aEnd)
+    {
+        CountingBottomKSketch sResult(aSampleSize);
+        for (uint64_t sId = aBegin; sId < aEnd; ++sId)
+        {
+            sResult.add(wangHash(sId));
+        }
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(CountingBottomKSketchTest, ExactBelowSampleSize)
+{
+    auto sSketch = MakeSketch(1024, 0, 100);
+    sSketch += MakeSketch(1024, 50, 200);
+    sSketch += MakeSketch(1024, 90, 120);
+
+    EXPECT_EQ(sSketch.cardinality_estimate(), 200);
+    EXPECT_EQ(sSketch.countAtLeastEstimate(1), 200);
+    EXPECT_EQ(sSketch.countAtLeastEstimate(2), 70);
+    EXPECT_EQ(sSketch.countAtLeastEstimate(3), 10);
+    EXPECT_EQ(sSketch.countAtLeastEstimate(4), 0);
+}
+
+TEST(CountingBottomKSketchTest, MergeMatchesSingleSketch)
+{
+    CountingBottomKSketch sSingle(256);
+    auto                  sMerged = MakeSketch(256, 0, 0);
+    for (uint64_t sBegin = 0; sBegin < 40'000; sBegin += 10'000)
+    {
+        for (uint64_t sId = sBegin; sId < sBegin + 20'000; ++sId)
+        {
+            sSingle.add(wangHash(sId));
+        }
+        sMerged += MakeSketch(256, sBegin, sBegin + 20'000);
+    }
+
+    for (uint32_t sMinCount = 1; sMinCount <= 3; ++sMinCount)
+    {
+        EXPECT_EQ(sSingle.countAtLeastEstimate(sMinCount), sMerged.countAtLeastEstimate(sMinCount));
+    }
+}
+
+TEST(CountingBottomKSketchTest, KOfNAccuracy)
+{
+    // Four overlapping ranges: ids in [0, 200'000) are covered by 1 to 4 ranges.
+    CountingBottomKSketch sSketch(4096);
+    std::map<uint64_t, uint32_t> sCoverage;
+    for (uint64_t sBegin : {0, 50'000, 80'000, 100'000})
+    {
+        sSketch += MakeSketch(4096, sBegin, sBegin + 100'000);
+        for (uint64_t sId = sBegin; sId < sBegin + 100'000; ++sId)
+        {
+            ++sCoverage[sId];
+        }
+    }
+
+    for (uint32_t sMinCount = 1; sMinCount <= 4; ++sMinCount)
+    {
+        const auto sExpected = std::count_if(
+            sCoverage.begin(), sCoverage.end(), [sMinCount](const auto& aPair) { return aPair.second >= sMinCount; });
+        EXPECT_NEAR(sSketch.countAtLeastEstimate(sMinCount), sExpected, 0.1 * sExpected) << sMinCount;
+    }
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include "counting_bloom_filter.hpp"
+
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    std::vector<uint64_t> MakeRange(uint64_t aBegin, uint64_t aEnd)
+    {
+        std::vector<uint64_t> sResult(aEnd - aBegin);
+        std::iota(sResult.begin(), sResult.end(), aBegin);
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(CountingBloomFilterTest, NoFalseNegatives)
+{
+    CountingBloomFilter sFilter(20, 4, 137);
+
+    // Ids [0, 30'000) are in 1 to 3 dependencies.
+    for (const auto& sIds : {MakeRange(0, 20'000), MakeRange(10'000, 30'000), MakeRange(15'000, 25'000)})
+    {
+        auto sSet = sFilter.makeDependencySet();
+        sFilter.addIds(sSet, sIds);
+        sFilter.addDependency(sSet);
+    }
+
+    for (uint64_t sId = 0; sId < 30'000; ++sId)
+    {
+        const uint32_t sExpected = (sId < 20'000) + (sId >= 10'000) + (sId >= 15'000 && sId < 25'000);
+        ASSERT_GE(sFilter.getCount(sId), sExpected) << sId;
+    }
+}
+
+TEST(CountingBloomFilterTest, DuplicatesInDependencyCountOnce)
+{
+    CountingBloomFilter sFilter(16, 3, 137);
+
+    auto sSet = sFilter.makeDependencySet();
+    sFilter.addIds(sSet, MakeRange(0, 100));
+    sFilter.addIds(sSet, MakeRange(0, 100));
+
+    auto sSplit = sFilter.makeDependencySet();
+    sFilter.addIds(sSplit, MakeRange(50, 100));
+    sSet |= sSplit;
+
+    sFilter.addDependency(sSet);
+    EXPECT_EQ(sFilter.getCount(42), 1);
+}
+
+TEST(CountingBloomFilterTest, ThresholdFalsePositiveRate)
+{
+    CountingBloomFilter sFilter(22, 4, 137);
+
+    // 100'000 ids in both dependencies, 100'000 more in only one of them.
+    for (const auto& sIds : {MakeRange(0, 200'000), MakeRange(100'000, 200'000)})
+    {
+        auto sSet = sFilter.makeDependencySet();
+        sFilter.addIds(sSet, sIds);
+        sFilter.addDependency(sSet);
+    }
+
+    uint32_t sFalsePositives = 0;
+    for (uint64_t sId = 0; sId < 100'000; ++sId)
+    {
+        sFalsePositives += sFilter.getCount(sId) >= 2;
+    }
+
+    EXPECT_LT(sFalsePositives, 100'000 / 100);
+}
+
+TEST(CountingBloomFilterTest, RejectsOutOfRangeParameters)
+{
+    EXPECT_THROW(CountingBloomFilter(5, 4, 137), std::invalid_argument);
+    EXPECT_THROW(CountingBloomFilter(41, 4, 137), std::invalid_argument);
+    EXPECT_THROW(CountingBloomFilter(16, 0, 137), std::invalid_argument);
+    EXPECT_THROW(CountingBloomFilter(16, CountingBloomFilter::MAX_HASH_FUNCTION_COUNT + 1, 137), std::invalid_argument);
+
+    EXPECT_NO_THROW(CountingBloomFilter(6, CountingBloomFilter::MAX_HASH_FUNCTION_COUNT, 137));
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "cuckoo_filter.hpp"
+
+TEST(CuckooFilterTest, InsertEraseAndFalsePositiveRate)
+{
+    // 2^16 buckets hold 262'144 entries.
+    CuckooFilter sFilter(16, 137);
+    for (uint64_t sId = 0; sId < 200'000; ++sId)
+    {
+        ASSERT_TRUE(sFilter.insert(sId)) << sId;
+    }
+    EXPECT_EQ(sFilter.size(), 200'000);
+
+    for (uint64_t sId = 0; sId < 200'000; ++sId)
+    {
+        ASSERT_TRUE(sFilter.mayContain(sId)) << sId;
+    }
+
+    uint32_t sFalsePositives = 0;
+    for (uint64_t sId = 200'000; sId < 400'000; ++sId)
+    {
+        sFalsePositives += sFilter.mayContain(sId);
+    }
+    // 8 / 2^16 at full load.
+    EXPECT_LT(sFalsePositives, 200'000 / 2'000);
+
+    for (uint64_t sId = 0; sId < 100'000; ++sId)
+    {
+        ASSERT_TRUE(sFilter.erase(sId)) << sId;
+    }
+    EXPECT_EQ(sFilter.size(), 100'000);
+
+    uint32_t sErasedPositives = 0;
+    for (uint64_t sId = 0; sId < 100'000; ++sId)
+    {
+        sErasedPositives += sFilter.mayContain(sId);
+    }
+    EXPECT_LT(sErasedPositives, 100'000 / 2'000);
+
+    for (uint64_t sId = 100'000; sId < 200'000; ++sId)
+    {
+        ASSERT_TRUE(sFilter.mayContain(sId)) << sId;
+    }
+}
+
+TEST(CuckooFilterTest, FullFilterKeepsEveryInsertedId)
+{
+    CuckooFilter sFilter(8, 137);
+
+    uint64_t sInserted = 0;
+    while (sFilter.insert(sInserted))
+    {
+        ++sInserted;
+    }
+    EXPECT_GT(sInserted, 4 * 256 * 9 / 10);
+
+    for (uint64_t sId = 0; sId <= sInserted; ++sId)
+    {
+        ASSERT_TRUE(sFilter.mayContain(sId)) << sId;
+    }
+
+    // Freeing a slot re-admits the evicted entry, and then new ids.
+    EXPECT_FALSE(sFilter.insert(sInserted + 1));
+    EXPECT_TRUE(sFilter.erase(0));
+    EXPECT_TRUE(sFilter.mayContain(sInserted));
+}
+
+TEST(CuckooFilterTest, MergeAndIntersect)
+{
+    CuckooFilter sLeft(12, 137);
+    CuckooFilter sRight(12, 137);
+    for (uint64_t sId = 0; sId < 6'000; ++sId)
+    {
+        sLeft.insert(sId);
+        sRight.insert(sId + 3'000);
+    }
+
+    CuckooFilter sUnion = sLeft;
+    ASSERT_TRUE(sUnion.merge(sRight));
+    EXPECT_EQ(sUnion.size(), 12'000);
+    for (uint64_t sId = 0; sId < 9'000; ++sId)
+    {
+        ASSERT_TRUE(sUnion.mayContain(sId)) << sId;
+    }
+
+    // Ids in both dependencies are stored twice, one erase per dependency removes them.
+    EXPECT_TRUE(sUnion.erase(4'000));
+    EXPECT_TRUE(sUnion.mayContain(4'000));
+    EXPECT_TRUE(sUnion.erase(4'000));
+    EXPECT_FALSE(sUnion.mayContain(4'000));
+
+    sLeft.intersect(sRight);
+    EXPECT_GE(sLeft.size(), 3'000);
+    EXPECT_LT(sLeft.size(), 3'000 + 10);
+    for (uint64_t sId = 3'000; sId < 6'000; ++sId)
+    {
+        ASSERT_TRUE(sLeft.mayContain(sId)) << sId;
+    }
+}
+
+TEST(CuckooFilterTest, MergeKeepsCollidingIds)
+{
+    // An id that a filter holding only id 0 reports present shares its fingerprint and buckets with id 0.
+    CuckooFilter sProbe(4, 137);
+    sProbe.insert(0);
+
+    uint64_t sCollidingId = 1;
+    while (!sProbe.mayContain(sCollidingId))
+    {
+        ++sCollidingId;
+    }
+
+    CuckooFilter sFirstShard(4, 137);
+    CuckooFilter sSecondShard(4, 137);
+    sFirstShard.insert(0);
+    sSecondShard.insert(sCollidingId);
+
+    ASSERT_TRUE(sFirstShard.merge(sSecondShard));
+    EXPECT_EQ(sFirstShard.size(), 2);
+
+    // The shard that held id 0 dropped it, the other shard still holds sCollidingId.
+    EXPECT_TRUE(sFirstShard.erase(0));
+    EXPECT_TRUE(sFirstShard.mayContain(sCollidingId));
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "estimators.hpp"
+
+#include <vector>
+
+namespace
+{
+    // Two overlapping dependencies of 2'000 ids each, in 10 shards.
+    std::vector<ShardData> MakeDependencies()
+    {
+        std::vector<ShardData> sResult(2);
+        for (uint32_t sDependency = 0; sDependency < sResult.size(); ++sDependency)
+        {
+            auto& sData = sResult[sDependency];
+            for (uint32_t i = 0; i < 2'000; ++i)
+            {
+                sData.ids.push_back(sDependency * 1'000 + i);
+                if ((i + 1) % 200 == 0)
+                {
+                    sData.offsets.push_back(sData.ids.size());
+                }
+            }
+            sData.total_size = sData.ids.size();
+        }
+
+        return sResult;
+    }
+
+    template <typename Estimator>
+    void ExpectSameAsDirectCalls(Estimator aDirect, const std::vector<ShardData>& aShardData, uint32_t aPassCondition)
+    {
+        AnyCoverageEstimator sDispatched(aDirect);
+
+        aDirect.addShardData(aShardData, aPassCondition);
+        addShardData(sDispatched, aShardData, aPassCondition);
+
+        ASSERT_TRUE(std::holds_alternative<Estimator>(sDispatched));
+        EXPECT_EQ(estimateCoverage(sDispatched), aDirect.estimateCoverage()) << Estimator::Name;
+        EXPECT_EQ(estimateMemoryUsage(sDispatched), aDirect.estimateMemoryUsage()) << Estimator::Name;
+    }
+}  // namespace
+
+TEST(AnyCoverageEstimatorTest, DispatchesToTheHeldEstimator)
+{
+    const auto sDependencies = MakeDependencies();
+
+    for (uint32_t sPassCondition : {1, 2})
+    {
+        AnyCoverageEstimator sBaseline{BaselineEstimator()};
+        addShardData(sBaseline, sDependencies, sPassCondition);
+        EXPECT_EQ(estimateCoverage(sBaseline), sPassCondition == 1 ? 3'000 : 1'000);
+
+        ExpectSameAsDirectCalls(HyperLogLogEstimator(12), sDependencies, sPassCondition);
+        ExpectSameAsDirectCalls(BBitMinHashEstimator(16), sDependencies, sPassCondition);
+        ExpectSameAsDirectCalls(RangeMinHashEstimator(256), sDependencies, sPassCondition);
+        ExpectSameAsDirectCalls(KOfNCoverageEstimator(256), sDependencies, sPassCondition);
+    }
+}
+
+TEST(AnyCoverageEstimatorTest, KOfNStreamedDependenciesMatchShardData)
+{
+    const auto sDependencies = MakeDependencies();
+
+    KOfNCoverageEstimator sDirect(256);
+    sDirect.addShardData(sDependencies, 2);
+
+    AnyCoverageEstimator sStreamed{KOfNCoverageEstimator(256, 2)};
+    for (const auto& sDep : sDependencies)
+    {
+        addDependencyData(sStreamed, sDep);
+    }
+
+    EXPECT_EQ(estimateCoverage(sStreamed), sDirect.estimateCoverage());
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "hashing.hpp"
+
+#include <vector>
+
+namespace
+{
+    std::vector<uint64_t> MakeIds(size_t aCount)
+    {
+        std::vector<uint64_t> sResult(aCount);
+        for (size_t i = 0; i < aCount; ++i)
+        {
+            sResult[i] = i * 0x9E3779B97F4A7C15 + (i % 3 == 0 ? 0 : ~uint64_t{0} - i);
+        }
+
+        return sResult;
+    }
+}  // namespace
+
+// Lengths around the AVX2 and AVX-512 widths of 4 and 8 ids, most of them ending in a partial vector.
+TEST(HashingTest, BatchMatchesScalarHash)
+{
+    const auto sIds = MakeIds(1'004);
+
+    for (size_t sLength : {0, 1, 3, 4, 5, 7, 8, 9, 15, 17, 63, 1'003})
+    {
+        // Starts one id in so that the input is not 64-byte aligned either.
+        const auto            sInput = std::span<const uint64_t>(sIds).subspan(1, sLength);
+        std::vector<uint64_t> sHashes(sLength + 1, 0);
+        wangHashBatch(sInput, sHashes);
+
+        for (size_t i = 0; i < sLength; ++i)
+        {
+            ASSERT_EQ(sHashes[i], wangHash(sInput[i])) << sLength << ' ' << i;
+        }
+        EXPECT_EQ(sHashes[sLength], 0) << sLength;
+    }
+}
+
+TEST(HashingTest, ForEachWangHashKeepsInputOrder)
+{
+    const auto sIds = MakeIds(3 * HASH_BATCH_SIZE + 5);
+
+    std::vector<uint64_t> sHashes;
+    forEachWangHash(sIds, [&](uint64_t aHash) { sHashes.push_back(aHash); });
+
+    ASSERT_EQ(sHashes.size(), sIds.size());
+    for (size_t i = 0; i < sIds.size(); ++i)
+    {
+        EXPECT_EQ(sHashes[i], wangHash(sIds[i])) << i;
+    }
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "hll_folding.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Register layout of sketch::hll_t: the index is the top aPrecision bits of the hash, the rank is the position
+    // of the first set bit in the remaining ones, capped at 64 - aPrecision + 1.
+    std::vector<uint8_t> MakeRegisters(const std::vector<uint64_t>& aHashes, uint32_t aPrecision)
+    {
+        std::vector<uint8_t> sResult(size_t{1} << aPrecision);
+        for (auto sHash : aHashes)
+        {
+            const auto sIndex = sHash >> (64 - aPrecision);
+            const auto sRank  = static_cast<uint8_t>(__builtin_clzll(((sHash << 1) | 1) << (aPrecision - 1)) + 1);
+            sResult[sIndex]   = std::max(sResult[sIndex], sRank);
+        }
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(HyperLogLogFoldingTest, MatchesDirectConstruction)
+{
+    std::mt19937_64       sEngine(42);
+    std::vector<uint64_t> sHashes(50'000);
+    std::generate(sHashes.begin(), sHashes.end(), sEngine);
+    // Hashes with long zero runs exercise the capped ranks.
+    sHashes.insert(sHashes.end(), {0, 1, uint64_t{1} << 40, uint64_t{1} << 63});
+
+    const auto sRegisters = MakeRegisters(sHashes, 16);
+    for (uint32_t sTargetPrecision = 4; sTargetPrecision <= 16; ++sTargetPrecision)
+    {
+        std::vector<uint8_t> sFolded(size_t{1} << sTargetPrecision);
+        details::foldHyperLogLogRegisters(sRegisters, 16, sTargetPrecision, sFolded);
+
+        EXPECT_EQ(sFolded, MakeRegisters(sHashes, sTargetPrecision)) << sTargetPrecision;
+    }
+}
+
+TEST(HyperLogLogFoldingTest, RejectsHigherPrecision)
+{
+    std::vector<uint8_t> sRegisters(16);
+    std::vector<uint8_t> sResult(32);
+
+    EXPECT_THROW(details::foldHyperLogLogRegisters(sRegisters, 4, 5, sResult), std::invalid_argument);
+}
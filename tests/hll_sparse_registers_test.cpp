@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include "hll_sparse_registers.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Registers of sketch::hll_t after adding aHashes.
+    std::vector<uint8_t> MakeRegisters(const std::vector<uint64_t>& aHashes, uint32_t aPrecision)
+    {
+        std::vector<uint8_t> sResult(size_t{1} << aPrecision);
+        for (auto sHash : aHashes)
+        {
+            const auto sIndex = sHash >> (64 - aPrecision);
+            const auto sRank  = static_cast<uint8_t>(__builtin_clzll(((sHash << 1) | 1) << (aPrecision - 1)) + 1);
+            sResult[sIndex]   = std::max(sResult[sIndex], sRank);
+        }
+
+        return sResult;
+    }
+
+    std::vector<uint8_t> GetRegisters(const SparseHyperLogLogRegisters& aSparse)
+    {
+        std::vector<uint8_t> sResult(size_t{1} << aSparse.getPrecision());
+        aSparse.fillRegisters(sResult);
+
+        return sResult;
+    }
+
+    std::vector<uint64_t> MakeHashes(size_t aCount, uint64_t aSeed)
+    {
+        std::mt19937_64       sEngine(aSeed);
+        std::vector<uint64_t> sResult(aCount);
+        std::generate(sResult.begin(), sResult.end(), sEngine);
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(SparseHyperLogLogRegistersTest, MatchesDenseRegisters)
+{
+    auto sHashes = MakeHashes(20'000, 42);
+    // Repeated hashes and long zero runs exercise the deduplication and the capped ranks.
+    sHashes.insert(sHashes.end(), sHashes.begin(), sHashes.begin() + 5'000);
+    sHashes.insert(sHashes.end(), {0, 1, uint64_t{1} << 40, uint64_t{1} << 63});
+
+    for (uint32_t sPrecision : {4u, 12u, 16u, 24u})
+    {
+        SparseHyperLogLogRegisters sSparse(sPrecision);
+        for (auto sHash : sHashes)
+        {
+            sSparse.add(sHash);
+        }
+
+        EXPECT_EQ(GetRegisters(sSparse), MakeRegisters(sHashes, sPrecision)) << sPrecision;
+
+        sSparse.compact();
+        EXPECT_EQ(GetRegisters(sSparse), MakeRegisters(sHashes, sPrecision)) << sPrecision;
+        EXPECT_EQ(sSparse.size(),
+                  static_cast<size_t>(std::ranges::count_if(MakeRegisters(sHashes, sPrecision),
+                                                            [](uint8_t aRegister) { return aRegister != 0; })));
+    }
+}
+
+TEST(SparseHyperLogLogRegistersTest, MergeIsUnion)
+{
+    const auto sLeftHashes  = MakeHashes(3'000, 1);
+    const auto sRightHashes = MakeHashes(7'000, 2);
+
+    SparseHyperLogLogRegisters sLeft(14);
+    SparseHyperLogLogRegisters sRight(14);
+    for (auto sHash : sLeftHashes)
+    {
+        sLeft.add(sHash);
+    }
+    for (auto sHash : sRightHashes)
+    {
+        sRight.add(sHash);
+    }
+
+    sLeft.merge(sRight);
+
+    auto sAllHashes = sLeftHashes;
+    sAllHashes.insert(sAllHashes.end(), sRightHashes.begin(), sRightHashes.end());
+    EXPECT_EQ(GetRegisters(sLeft), MakeRegisters(sAllHashes, 14));
+}
+
+TEST(SparseHyperLogLogRegistersTest, StaysSmall)
+{
+    SparseHyperLogLogRegisters sSparse(20);
+    for (auto sHash : MakeHashes(1'000, 3))
+    {
+        sSparse.add(sHash);
+    }
+
+    // A thousand entries instead of a mebibyte of registers.
+    EXPECT_LT(sSparse.estimateMemoryUsage(), 16 * 1'024);
+}
+
+TEST(SparseHyperLogLogRegistersTest, RejectsUnsupportedPrecision)
+{
+    EXPECT_THROW(SparseHyperLogLogRegisters(0), std::invalid_argument);
+    EXPECT_THROW(SparseHyperLogLogRegisters(25), std::invalid_argument);
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include "common.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    // The subset of JSON the dump writes: objects, strings and numbers.
+    struct JsonValue
+    {
+        std::string                                    string;
+        double                                         number{0};
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        const JsonValue& at(const std::string& aKey) const
+        {
+            for (const auto& [sKey, sValue] : object)
+            {
+                if (sKey == aKey)
+                {
+                    return sValue;
+                }
+            }
+
+            throw std::out_of_range("Missing key " + aKey);
+        }
+    };
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string& aText) : text(aText) {}
+
+        JsonValue parseDocument()
+        {
+            auto sResult = parseValue();
+            if (position != text.size())
+            {
+                throw std::runtime_error("Trailing characters in " + text);
+            }
+
+            return sResult;
+        }
+
+    private:
+        const std::string& text;
+        size_t             position{0};
+
+        char peek() const
+        {
+            if (position >= text.size())
+            {
+                throw std::runtime_error("Unexpected end of " + text);
+            }
+
+            return text[position];
+        }
+
+        void expect(char aChar)
+        {
+            if (peek() != aChar)
+            {
+                throw std::runtime_error(std::string("Expected ") + aChar + " in " + text);
+            }
+            ++position;
+        }
+
+        JsonValue parseValue()
+        {
+            JsonValue sResult;
+            if (peek() == '"')
+            {
+                sResult.string = parseString();
+            }
+            else if (peek() == '{')
+            {
+                sResult.object = parseObject();
+            }
+            else
+            {
+                const char* sBegin = text.c_str() + position;
+                char*       sEnd   = nullptr;
+                sResult.number     = std::strtod(sBegin, &sEnd);
+                if (sEnd == sBegin)
+                {
+                    throw std::runtime_error("Expected a value in " + text);
+                }
+                position += sEnd - sBegin;
+            }
+
+            return sResult;
+        }
+
+        std::string parseString()
+        {
+            expect('"');
+
+            std::string sResult;
+            while (peek() != '"')
+            {
+                if (peek() == '\\')
+                {
+                    ++position;
+                }
+                sResult += peek();
+                ++position;
+            }
+            ++position;
+
+            return sResult;
+        }
+
+        std::vector<std::pair<std::string, JsonValue>> parseObject()
+        {
+            expect('{');
+
+            std::vector<std::pair<std::string, JsonValue>> sResult;
+            while (peek() != '}')
+            {
+                if (!sResult.empty())
+                {
+                    expect(',');
+                }
+
+                auto sKey = parseString();
+                expect(':');
+                sResult.emplace_back(std::move(sKey), parseValue());
+            }
+            ++position;
+
+            return sResult;
+        }
+    };
+
+    void RecordFromThread(uint64_t aIds)
+    {
+        {
+            Timer sTimer(R"(InstrumentationTest "quoted" \ span)");
+        }
+        {
+            Timer sTimer("InstrumentationTest span");
+        }
+        addToCounter("InstrumentationTest phase", Counter::IDS_INGESTED, aIds);
+    }
+}  // namespace
+
+TEST(InstrumentationTest, DumpsRecordsOfEveryThreadAsJsonLines)
+{
+    std::thread sWorker(
+        []
+        {
+            RecordFromThread(5);
+            addToCounter("InstrumentationTest phase", Counter::MERGES, 1);
+        });
+    sWorker.join();
+
+    RecordFromThread(7);
+    recordResult("InstrumentationTest result", {{"error_percent", 0.1}, {"bucket_count_log2", 14}});
+
+    const std::string sPath = ::testing::TempDir() + "instrumentation_test.jsonl";
+    {
+        std::ofstream sOutput(sPath);
+        dumpInstrumentation(sOutput);
+    }
+
+    std::ifstream                   sInput(sPath);
+    std::string                     sLine;
+    std::set<uint64_t>              sSpanThreads;
+    std::map<std::string, uint64_t> sCounters;
+    uint32_t                        sQuotedSpanCount = 0;
+    uint32_t                        sSpanCount       = 0;
+    uint32_t                        sResultCount     = 0;
+    while (std::getline(sInput, sLine))
+    {
+        JsonValue sRecord;
+        ASSERT_NO_THROW(sRecord = JsonParser(sLine).parseDocument()) << sLine;
+
+        const auto& sType = sRecord.at("type").string;
+        if (sType == "span")
+        {
+            const auto& sName = sRecord.at("name").string;
+            if (sName.starts_with("InstrumentationTest"))
+            {
+                ++sSpanCount;
+                sQuotedSpanCount += sName == R"(InstrumentationTest "quoted" \ span)";
+                sSpanThreads.insert(static_cast<uint64_t>(sRecord.at("thread").number));
+                EXPECT_GE(sRecord.at("start_ns").number, 0) << sLine;
+                EXPECT_GE(sRecord.at("duration_ns").number, 0) << sLine;
+            }
+        }
+        else if (sType == "result")
+        {
+            if (sRecord.at("name").string == "InstrumentationTest result")
+            {
+                ++sResultCount;
+                const auto& sFields = sRecord.at("fields");
+                EXPECT_EQ(sFields.at("error_percent").number, 0.1);
+                EXPECT_EQ(sFields.at("bucket_count_log2").number, 14);
+            }
+        }
+        else if (sType == "counter")
+        {
+            if (sRecord.at("phase").string == "InstrumentationTest phase")
+            {
+                sCounters[sRecord.at("name").string] = static_cast<uint64_t>(sRecord.at("value").number);
+            }
+        }
+        else
+        {
+            ADD_FAILURE() << "Unknown record type in " << sLine;
+        }
+    }
+
+    EXPECT_EQ(sSpanCount, 4);
+    EXPECT_EQ(sQuotedSpanCount, 2);
+    EXPECT_EQ(sSpanThreads.size(), 2);
+    EXPECT_EQ(sResultCount, 1);
+
+    // Counters of both threads are summed into one record per phase and counter.
+    EXPECT_EQ(sCounters,
+              (std::map<std::string, uint64_t>{
+                  {"ids_ingested", 12}, {"merges", 1}, {"bytes_allocated", 0}, {"bytes_shipped", 0}}));
+}
+
+TEST(InstrumentationTest, TimerAddsItsDurationToTotal)
+{
+    uint64_t sTotal = 0;
+    {
+        Timer sTimer("TimerTotal span", &sTotal);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    const uint64_t sFirst = sTotal;
+    EXPECT_GE(sFirst, 2'000'000);
+
+    {
+        Timer sTimer("TimerTotal span", &sTotal);
+    }
+    EXPECT_GE(sTotal, sFirst);
+}
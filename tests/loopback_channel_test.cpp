@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "loopback_channel.hpp"
+
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::vector<std::byte> MakeMessage(uint32_t aNode, uint32_t aIndex)
+    {
+        // Larger than the pipe buffer now and then, so sends block and interleave.
+        std::vector<std::byte> sResult((aIndex % 7 == 0 ? 100'000 : 10) + aIndex);
+        std::fill(sResult.begin(), sResult.end(), static_cast<std::byte>(aNode));
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(LoopbackChannelTest, DeliversEveryMessageIntact)
+{
+    constexpr uint32_t NODE_COUNT    = 4;
+    constexpr uint32_t MESSAGE_COUNT = 50;
+
+    std::vector<uint32_t> sReceived(NODE_COUNT);
+    uint64_t              sReceivedBytes = 0;
+    aggregateOverLoopback(
+        "LoopbackChannelTest",
+        NODE_COUNT,
+        [](uint32_t aNode, LoopbackChannel& aChannel)
+        {
+            for (uint32_t i = 0; i < MESSAGE_COUNT; ++i)
+            {
+                aChannel.send(MakeMessage(aNode, i));
+            }
+        },
+        [&](std::span<const std::byte> aMessage)
+        {
+            ASSERT_FALSE(aMessage.empty());
+            const auto sNode = static_cast<uint32_t>(aMessage.front());
+            ASSERT_LT(sNode, NODE_COUNT);
+            EXPECT_EQ(std::vector<std::byte>(aMessage.begin(), aMessage.end()), MakeMessage(sNode, sReceived[sNode]));
+
+            ++sReceived[sNode];
+            sReceivedBytes += aMessage.size();
+        });
+
+    EXPECT_EQ(sReceived, std::vector<uint32_t>(NODE_COUNT, MESSAGE_COUNT));
+    EXPECT_GT(sReceivedBytes, 0);
+}
+
+TEST(LoopbackChannelTest, RethrowsReceiveErrorsAfterDraining)
+{
+    const auto sSendMany = [](uint32_t, LoopbackChannel& aChannel)
+    {
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            aChannel.send(MakeMessage(0, i));
+        }
+    };
+
+    EXPECT_THROW(aggregateOverLoopback("LoopbackChannelTest",
+                                       2,
+                                       sSendMany,
+                                       [](std::span<const std::byte>) { throw std::runtime_error("merge failed"); }),
+                 std::runtime_error);
+}
+
+TEST(LoopbackChannelTest, EmptyMessagesAndEndOfStream)
+{
+    LoopbackChannel sChannel;
+    sChannel.send({});
+    sChannel.closeSending();
+
+    std::vector<std::byte> sMessage(3);
+    EXPECT_TRUE(sChannel.receive(sMessage));
+    EXPECT_TRUE(sMessage.empty());
+    EXPECT_FALSE(sChannel.receive(sMessage));
+    EXPECT_EQ(sChannel.getBytesSent(), sizeof(uint64_t));
+}
+
+TEST(LoopbackChannelTest, ClosingReceivingEndFailsBlockedSend)
+{
+    LoopbackChannel sChannel;
+
+    // Far larger than the pipe buffer, so the send blocks until the reading end goes away.
+    std::thread sSender([&] { EXPECT_THROW(sChannel.send(std::vector<std::byte>(1 << 22)), std::system_error); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sChannel.closeReceiving();
+    sSender.join();
+
+    EXPECT_THROW(sChannel.send(MakeMessage(0, 1)), std::system_error);
+}
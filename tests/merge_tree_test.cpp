@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "merge_tree.hpp"
+
+#include <numeric>
+
+namespace
+{
+    struct Sum
+    {
+        void operator()(uint64_t& aLeft, uint64_t aRight) const { aLeft += aRight; }
+    };
+
+    struct CountingSum
+    {
+        size_t* merge_count;
+
+        void operator()(uint64_t& aLeft, uint64_t aRight) const
+        {
+            ++*merge_count;
+            aLeft += aRight;
+        }
+    };
+}  // namespace
+
+TEST(MergeTreeTest, RootIsMergeOfLeaves)
+{
+    for (size_t sLeafCount : {0, 1, 2, 5, 40, 64})
+    {
+        std::vector<uint64_t> sLeaves(sLeafCount);
+        std::iota(sLeaves.begin(), sLeaves.end(), 1);
+
+        MergeTree<uint64_t, Sum> sTree(sLeaves, 0);
+        EXPECT_EQ(sTree.getRoot(), sLeafCount * (sLeafCount + 1) / 2) << sLeafCount;
+        EXPECT_EQ(sTree.size(), sLeafCount);
+    }
+}
+
+TEST(MergeTreeTest, ReplaceAndAppend)
+{
+    MergeTree<uint64_t, Sum> sTree({1, 2, 3}, 0);
+
+    sTree.replace(1, 10);
+    EXPECT_EQ(sTree.getRoot(), 14);
+
+    for (uint64_t sValue = 1; sValue <= 10; ++sValue)
+    {
+        sTree.append(sValue);
+    }
+    EXPECT_EQ(sTree.getRoot(), 14 + 55);
+    EXPECT_EQ(sTree.size(), 13);
+    EXPECT_EQ(sTree.getLeaf(12), 10);
+
+    EXPECT_THROW(sTree.replace(13, 0), std::out_of_range);
+}
+
+TEST(MergeTreeTest, ReplaceTakesLogarithmicMerges)
+{
+    size_t                           sMergeCount = 0;
+    MergeTree<uint64_t, CountingSum> sTree(std::vector<uint64_t>(1024, 1), 0, CountingSum{&sMergeCount});
+    EXPECT_EQ(sMergeCount, 1023);
+
+    sMergeCount = 0;
+    sTree.replace(517, 2);
+    EXPECT_EQ(sMergeCount, 10);
+    EXPECT_EQ(sTree.getRoot(), 1025);
+}
+
+TEST(MergeTreeTest, ForEachNodeVisitsPaddedTree)
+{
+    MergeTree<uint64_t, Sum> sTree({1, 2, 3, 4, 5}, 0);
+
+    size_t   sNodeCount = 0;
+    uint64_t sNodeSum   = 0;
+    sTree.forEachNode(
+        [&](uint64_t aState)
+        {
+            ++sNodeCount;
+            sNodeSum += aState;
+        });
+
+    // Eight leaves, three of them padding, and seven inner nodes. Every level sums to the root.
+    EXPECT_EQ(sNodeCount, 15);
+    EXPECT_EQ(sNodeSum, 4 * 15);
+}
@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+
+#include "bounded_queue.hpp"
+#include "cuckoo_filter.hpp"
+#include "hashing.hpp"
+#include "hll_sparse_registers.hpp"
+#include "ingestion.hpp"
+
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    ShardData MakeShardData(uint32_t aShardCount)
+    {
+        ShardData sResult;
+        for (uint32_t i = 0; i < aShardCount; ++i)
+        {
+            for (uint32_t j = 0; j <= i % 5; ++j)
+            {
+                sResult.ids.push_back(i * 10 + j);
+            }
+            sResult.offsets.push_back(sResult.ids.size());
+        }
+        sResult.total_size = sResult.ids.size();
+
+        return sResult;
+    }
+
+    void MergeIdSets(std::set<uint64_t>& aLeft, const std::set<uint64_t>& aRight)
+    {
+        aLeft.insert(aRight.begin(), aRight.end());
+    }
+
+    std::set<uint64_t> BuildIdSet(const ShardData& aData, IngestionMode aMode, uint32_t aWorkerCount)
+    {
+        ThreadPool       sPool(aWorkerCount);
+        IngestionOptions sOptions{.mode = aMode, .worker_count = aWorkerCount};
+
+        return buildDependencyState(
+            aData,
+            sPool,
+            sOptions,
+            {},
+            "PipelinedIngestionTest",
+            0,
+            [] { return std::set<uint64_t>(); },
+            [](std::set<uint64_t>& aState, std::span<const uint64_t> aIds) { aState.insert(aIds.begin(), aIds.end()); },
+            MergeIdSets);
+    }
+
+    // Shards that share ids, so that the filters hold several copies of some of them.
+    ShardData MakeOverlappingShardData(uint32_t aShardCount)
+    {
+        ShardData sResult;
+        for (uint32_t i = 0; i < aShardCount; ++i)
+        {
+            for (uint64_t sId = i * 7; sId < i * 7 + 20; ++sId)
+            {
+                sResult.ids.push_back(sId);
+            }
+            sResult.offsets.push_back(sResult.ids.size());
+        }
+        sResult.total_size = sResult.ids.size();
+
+        return sResult;
+    }
+
+    template <typename State, typename MakeState, typename AddIds, typename Merge>
+    State BuildState(const ShardData& aData,
+                     IngestionMode    aMode,
+                     uint32_t         aWorkerCount,
+                     MakeState&&      aMakeState,
+                     AddIds&&         aAddIds,
+                     Merge&&          aMerge)
+    {
+        ThreadPool       sPool(aWorkerCount);
+        IngestionOptions sOptions{.mode = aMode, .worker_count = aWorkerCount};
+
+        return buildDependencyState(
+            aData, sPool, sOptions, {}, "PipelinedIngestionTest", 0, aMakeState, aAddIds, aMerge);
+    }
+
+    std::vector<uint8_t> BuildHyperLogLogRegisters(const ShardData& aData, IngestionMode aMode, uint32_t aWorkerCount)
+    {
+        constexpr uint32_t PRECISION = 10;
+
+        const auto sRegisters = BuildState<SparseHyperLogLogRegisters>(
+            aData,
+            aMode,
+            aWorkerCount,
+            [] { return SparseHyperLogLogRegisters(PRECISION); },
+            [](SparseHyperLogLogRegisters& aState, std::span<const uint64_t> aIds)
+            {
+                for (auto sId : aIds)
+                {
+                    aState.add(wangHash(sId));
+                }
+            },
+            [](SparseHyperLogLogRegisters& aLeft, const SparseHyperLogLogRegisters& aRight) { aLeft.merge(aRight); });
+
+        std::vector<uint8_t> sResult(size_t{1} << PRECISION);
+        sRegisters.fillRegisters(sResult);
+
+        return sResult;
+    }
+
+    CuckooFilter BuildCuckooFilter(const ShardData& aData, IngestionMode aMode, uint32_t aWorkerCount)
+    {
+        return BuildState<CuckooFilter>(
+            aData,
+            aMode,
+            aWorkerCount,
+            [] { return CuckooFilter(10, 137); },
+            [](CuckooFilter& aState, std::span<const uint64_t> aIds)
+            {
+                for (auto sId : aIds)
+                {
+                    ASSERT_TRUE(aState.insert(sId));
+                }
+            },
+            [](CuckooFilter& aLeft, const CuckooFilter& aRight) { ASSERT_TRUE(aLeft.merge(aRight)); });
+    }
+}  // namespace
+
+TEST(BoundedQueueTest, KeepsOrderAndDrainsAfterClose)
+{
+    BoundedQueue<int> sQueue(4);
+    ASSERT_TRUE(sQueue.push(1));
+    ASSERT_TRUE(sQueue.push(2));
+    sQueue.close();
+
+    EXPECT_FALSE(sQueue.push(3));
+    EXPECT_EQ(sQueue.pop(), 1);
+    EXPECT_EQ(sQueue.pop(), 2);
+    EXPECT_EQ(sQueue.pop(), std::nullopt);
+}
+
+TEST(BoundedQueueTest, BlocksProducerAtCapacity)
+{
+    constexpr int VALUE_COUNT = 10'000;
+
+    BoundedQueue<int> sQueue(2);
+    std::jthread      sProducer(
+        [&]
+        {
+            for (int i = 0; i < VALUE_COUNT; ++i)
+            {
+                sQueue.push(i);
+            }
+            sQueue.close();
+        });
+
+    int sExpected = 0;
+    while (auto sValue = sQueue.pop())
+    {
+        EXPECT_EQ(*sValue, sExpected++);
+    }
+    EXPECT_EQ(sExpected, VALUE_COUNT);
+}
+
+TEST(BoundedQueueTest, CloseReleasesBlockedProducer)
+{
+    BoundedQueue<int> sQueue(1);
+    ASSERT_TRUE(sQueue.push(0));
+
+    std::jthread sProducer([&] { EXPECT_FALSE(sQueue.push(1)); });
+    sQueue.close();
+}
+
+TEST(PipelinedIngestionTest, MatchesPerShardIngestion)
+{
+    const auto sData = MakeShardData(100);
+
+    const auto sExpected = BuildIdSet(sData, IngestionMode::PER_SHARD, 4);
+    EXPECT_EQ(sExpected.size(), sData.total_size);
+    for (uint32_t sWorkerCount : {1, 3, 8})
+    {
+        EXPECT_EQ(BuildIdSet(sData, IngestionMode::PIPELINED, sWorkerCount), sExpected);
+    }
+}
+
+TEST(PipelinedIngestionTest, RethrowsBuildErrors)
+{
+    const auto sData = MakeShardData(50);
+
+    ThreadPool       sPool(4);
+    IngestionOptions sOptions{.mode = IngestionMode::PIPELINED, .worker_count = 4};
+
+    const auto sBuild = [&]
+    {
+        return buildDependencyState(
+            sData,
+            sPool,
+            sOptions,
+            {},
+            "PipelinedIngestionTest",
+            0,
+            [] { return std::set<uint64_t>(); },
+            [](std::set<uint64_t>& aState, std::span<const uint64_t> aIds)
+            {
+                if (aIds.front() == 250)
+                {
+                    throw std::runtime_error("Failed shard");
+                }
+                aState.insert(aIds.begin(), aIds.end());
+            },
+            MergeIdSets);
+    };
+
+    EXPECT_THROW(sBuild(), std::runtime_error);
+}
+
+TEST(StreamingIngestionTest, MatchesPerShardIngestion)
+{
+    const auto sData = MakeShardData(100);
+
+    const auto sExpected = BuildIdSet(sData, IngestionMode::PER_SHARD, 4);
+    for (uint32_t sWorkerCount : {1, 3, 8})
+    {
+        EXPECT_EQ(BuildIdSet(sData, IngestionMode::STREAMING, sWorkerCount), sExpected);
+    }
+}
+
+TEST(StreamingIngestionTest, SameHyperLogLogRegistersInEveryMode)
+{
+    const auto sData = MakeOverlappingShardData(60);
+
+    const auto sExpected = BuildHyperLogLogRegisters(sData, IngestionMode::PER_SHARD, 4);
+    for (auto sMode : {IngestionMode::STREAMING, IngestionMode::PIPELINED})
+    {
+        for (uint32_t sWorkerCount : {1, 3, 8})
+        {
+            EXPECT_EQ(BuildHyperLogLogRegisters(sData, sMode, sWorkerCount), sExpected) << sWorkerCount;
+        }
+    }
+}
+
+TEST(StreamingIngestionTest, SameCuckooFilterContentsInEveryMode)
+{
+    const auto sData = MakeOverlappingShardData(60);
+
+    // Entries may sit in either of their buckets depending on the insertion order, so the contents are compared
+    // by what the filters answer: membership, entry counts, and how many erases every id takes to vanish.
+    const auto sExpected = BuildCuckooFilter(sData, IngestionMode::PER_SHARD, 4);
+    EXPECT_EQ(sExpected.size(), sData.total_size);
+
+    for (auto sMode : {IngestionMode::STREAMING, IngestionMode::PIPELINED})
+    {
+        for (uint32_t sWorkerCount : {1, 3, 8})
+        {
+            auto sFilter = BuildCuckooFilter(sData, sMode, sWorkerCount);
+            auto sCopy   = sExpected;
+            ASSERT_EQ(sFilter.size(), sCopy.size());
+
+            for (uint64_t sId = 0; sId < 1'000; ++sId)
+            {
+                ASSERT_EQ(sFilter.mayContain(sId), sCopy.mayContain(sId)) << sId;
+            }
+
+            for (auto sId : sData.ids)
+            {
+                ASSERT_TRUE(sFilter.erase(sId)) << sId;
+                ASSERT_TRUE(sCopy.erase(sId)) << sId;
+            }
+            EXPECT_EQ(sFilter.size(), 0);
+            EXPECT_EQ(sCopy.size(), 0);
+        }
+    }
+}
+
+TEST(CachedIngestionTest, RebuildHitsEveryShard)
+{
+    auto        sData = MakeShardData(30);
+    SketchCache sCache(1 << 20);
+
+    ThreadPool       sPool(4);
+    IngestionOptions sOptions{.worker_count = 4, .sketch_cache = &sCache};
+
+    const auto sBuild = [&]
+    {
+        return buildDependencyState(
+            sData,
+            sPool,
+            sOptions,
+            {},
+            "PipelinedIngestionTest",
+            0,
+            [] { return std::set<uint64_t>(); },
+            [](std::set<uint64_t>& aState, std::span<const uint64_t> aIds) { aState.insert(aIds.begin(), aIds.end()); },
+            MergeIdSets);
+    };
+
+    // Lookups key on the fingerprints kept in the shard data instead of hashing the ids again.
+    EXPECT_THROW(sBuild(), std::invalid_argument);
+
+    fingerprintShards(sData);
+    const auto sExpected = BuildIdSet(sData, IngestionMode::PER_SHARD, 4);
+    EXPECT_EQ(sBuild(), sExpected);
+    EXPECT_EQ(sCache.getStatistics().misses, sData.shardCount());
+
+    EXPECT_EQ(sBuild(), sExpected);
+    EXPECT_EQ(sCache.getStatistics().hits, sData.shardCount());
+}
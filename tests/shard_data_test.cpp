@@ -2,9 +2,11 @@
 
 #include "shard_data.hpp"
 
+#include <algorithm>
 #include <array>
 #include <numeric>
 #include <ranges>
+#include <unordered_set>
 
 namespace
 {
@@ -52,23 +54,34 @@ namespace
         }
     }
 
+    std::vector<size_t> ShardSizes(const ShardData &aData)
+    {
+        std::vector<size_t> sResult;
+        for (const auto &sShard : aData.shards())
+        {
+            sResult.push_back(sShard.size());
+        }
+
+        return sResult;
+    }
+
     void ShardDataPrototypeTest(const ShardData   &aExisting,
                                 const ShardData   &aGenerated,
                                 ShardDataPrototype aPrototype)
     {
-        ASSERT_EQ(aGenerated.data.size(), aExisting.data.size());
+        ASSERT_EQ(aGenerated.shardCount(), aExisting.shardCount());
         ASSERT_EQ(aGenerated.total_size, aPrototype.response_size);
 
         std::unordered_set<uint64_t> sExistingIds;
 
-        for (const auto &sShard : aExisting.data)
+        for (const auto &sShard : aExisting.shards())
         {
             sExistingIds.insert(sShard.begin(), sShard.end());
         }
 
         bool     sIsIntersection = aPrototype.operation == ShardDataPrototype::INTERSECTION;
         uint32_t sOperationSize  = sIsIntersection ? 0 : aExisting.total_size;
-        for (const auto &sShard : aGenerated.data)
+        for (const auto &sShard : aGenerated.shards())
         {
             for (auto sId : sShard)
             {
@@ -95,29 +108,33 @@ namespace
 
 TEST(DistributionTest, EvenDistribution)
 {
-    EvenDistributionTest(details::generateShardResponseSizes, [](auto aSize) { return aSize; });
+    EvenDistributionTest([](uint32_t aResponseSize, uint32_t aShardCount, ShardDataDistribution aDistributionType)
+                         { return details::generateShardResponseSizes(aResponseSize, aShardCount, aDistributionType); },
+                         [](auto aSize) { return aSize; });
 }
 
 TEST(DistributionTest, RandomDistribution)
 {
-    RandomDistributionTest(details::generateShardResponseSizes,
-                           [](const auto &aResult, const auto &aCurr) { return aResult + aCurr; });
+    RandomDistributionTest(
+        [](uint32_t aResponseSize, uint32_t aShardCount, ShardDataDistribution aDistributionType)
+        { return details::generateShardResponseSizes(aResponseSize, aShardCount, aDistributionType); },
+        [](const auto &aResult, const auto &aCurr) { return aResult + aCurr; });
 }
 
 TEST(ShardDataTest, EvenDistribution)
 {
     EvenDistributionTest(
         [](uint32_t aResponseSize, uint32_t aShardCount, ShardDataDistribution aDistributionType)
-        { return generateShardData(aResponseSize, aShardCount, aDistributionType).data; },
-        [](const auto &aData) { return aData.size(); });
+        { return ShardSizes(generateShardData(aResponseSize, aShardCount, aDistributionType)); },
+        [](auto aSize) { return aSize; });
 }
 
 TEST(ShardDataTest, RandomDistribution)
 {
     RandomDistributionTest(
         [](uint32_t aResponseSize, uint32_t aShardCount, ShardDataDistribution aDistributionType)
-        { return generateShardData(aResponseSize, aShardCount, aDistributionType).data; },
-        [](const auto &aResult, const auto &aCurr) { return aResult + aCurr.size(); });
+        { return ShardSizes(generateShardData(aResponseSize, aShardCount, aDistributionType)); },
+        [](const auto &aResult, const auto &aCurr) { return aResult + aCurr; });
 }
 
 TEST(ShardDataPrototypeTests, Intersection)
@@ -177,4 +194,73 @@ TEST(ShardDataPrototypeTests, Union)
             generateShardDataUsingExisting(sExisting, sPrototype, ShardDataDistribution::EVEN),
             sPrototype);
     }
-}
\ No newline at end of file
+}
+
+TEST(ShardDataTest, ContiguousLayout)
+{
+    const auto sData = generateShardData(1000, 7, ShardDataDistribution::RANDOM);
+
+    ASSERT_EQ(sData.shardCount(), 7);
+    ASSERT_EQ(sData.offsets.front(), 0);
+    ASSERT_EQ(sData.offsets.back(), sData.ids.size());
+    ASSERT_EQ(sData.ids.size(), sData.total_size);
+
+    const uint64_t *sExpectedBegin = sData.ids.data();
+    for (const auto &sShard : sData.shards())
+    {
+        EXPECT_EQ(sShard.data(), sExpectedBegin);
+        sExpectedBegin += sShard.size();
+    }
+    EXPECT_EQ(sExpectedBegin, sData.ids.data() + sData.ids.size());
+}
+
+TEST(ShardDataTest, NoShards)
+{
+    const auto sData = generateShardData(1000, 0, ShardDataDistribution::RANDOM);
+
+    EXPECT_EQ(sData.shardCount(), 0);
+    EXPECT_EQ(sData.offsets.front(), 0);
+    EXPECT_TRUE(sData.ids.empty());
+    EXPECT_EQ(sData.total_size, 0);
+}
+
+TEST(GenerateIdsTest, SameSeedSameIds)
+{
+    const auto sFirst  = generateIds(3'000'000, {}, 42);
+    const auto sSecond = generateIds(3'000'000, {}, 42);
+
+    EXPECT_EQ(sFirst, sSecond);
+    EXPECT_NE(sFirst, generateIds(3'000'000, {}, 43));
+}
+
+TEST(GenerateIdsTest, Exclusion)
+{
+    auto sExcluded = generateIds(1000, {}, 7);
+    std::sort(sExcluded.begin(), sExcluded.end());
+
+    // The same seed draws exactly the excluded ids first, so every one of them has to be redrawn.
+    const auto sIds = generateIds(1000, sExcluded, 7);
+    ASSERT_EQ(sIds.size(), 1000);
+    for (auto sId : sIds)
+    {
+        EXPECT_FALSE(std::binary_search(sExcluded.begin(), sExcluded.end(), sId));
+    }
+}
+
+TEST(ShardDataTest, SameSeedSameData)
+{
+    const auto sFirst  = generateShardData(10'000, 40, ShardDataDistribution::RANDOM, 42);
+    const auto sSecond = generateShardData(10'000, 40, ShardDataDistribution::RANDOM, 42);
+
+    EXPECT_EQ(sFirst.ids, sSecond.ids);
+    EXPECT_EQ(sFirst.offsets, sSecond.offsets);
+
+    const ShardDataPrototype sPrototype{ShardDataPrototype::UNION, 15'000, 10'000};
+    const auto               sFirstUnion
+        = generateShardDataUsingExisting(sFirst, sPrototype, ShardDataDistribution::RANDOM, 7);
+    const auto sSecondUnion
+        = generateShardDataUsingExisting(sSecond, sPrototype, ShardDataDistribution::RANDOM, 7);
+
+    EXPECT_EQ(sFirstUnion.ids, sSecondUnion.ids);
+    EXPECT_EQ(sFirstUnion.offsets, sSecondUnion.offsets);
+}
@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include "estimators.hpp"
+#include "shard_fetch_simulation.hpp"
+
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    // Exact distinct count, ingests raw ids like estimators that do not ship sketches.
+    struct IdSetEstimator
+    {
+        std::set<uint64_t> ids;
+
+        void addBatch(std::span<const uint64_t> aIds) { ids.insert(aIds.begin(), aIds.end()); }
+
+        uint64_t estimateCoverage() const { return ids.size(); }
+    };
+
+    ShardData MakeShardData(uint32_t aShardCount, uint32_t aShardSize)
+    {
+        ShardData sResult;
+        for (uint32_t i = 0; i < aShardCount * aShardSize; ++i)
+        {
+            sResult.ids.push_back(i);
+        }
+        for (uint32_t i = 1; i <= aShardCount; ++i)
+        {
+            sResult.offsets.push_back(i * aShardSize);
+        }
+        sResult.total_size = sResult.ids.size();
+
+        return sResult;
+    }
+
+    std::chrono::microseconds GetSampleMedian(const LatencyModel& aModel)
+    {
+        std::vector<std::chrono::microseconds> sLatencies;
+        for (uint64_t i = 0; i < 10'001; ++i)
+        {
+            sLatencies.push_back(sampleLatency(aModel, 42, i));
+        }
+        std::nth_element(sLatencies.begin(), sLatencies.begin() + 5'000, sLatencies.end());
+
+        return sLatencies[5'000];
+    }
+
+    SimulationTask RecordWake(SimulationExecutor&                   aExecutor,
+                              SimulationExecutor::Clock::time_point aWakeTime,
+                              int                                   aValue,
+                              std::vector<int>&                     aOrder)
+    {
+        co_await aExecutor.sleepUntil(aWakeTime);
+        aOrder.push_back(aValue);
+    }
+
+    SimulationTask FailAfterSleep(SimulationExecutor& aExecutor)
+    {
+        co_await aExecutor.sleepUntil(SimulationExecutor::Clock::now());
+        throw std::runtime_error("Failed fetch");
+    }
+}  // namespace
+
+TEST(ShardFetchSimulationTest, LatencyDistributionsHaveTheConfiguredMedian)
+{
+    for (auto sDistribution : {LatencyDistribution::CONSTANT,
+                               LatencyDistribution::UNIFORM,
+                               LatencyDistribution::EXPONENTIAL,
+                               LatencyDistribution::LOG_NORMAL,
+                               LatencyDistribution::PARETO})
+    {
+        const LatencyModel sModel{.distribution = sDistribution, .median = 10'000us, .spread = 1.5};
+        EXPECT_NEAR(static_cast<double>(GetSampleMedian(sModel).count()), 10'000, 500)
+            << static_cast<int>(sDistribution);
+        EXPECT_EQ(sampleLatency(sModel, 7, 3), sampleLatency(sModel, 7, 3));
+    }
+}
+
+TEST(ShardFetchSimulationTest, HeavyTailsAreCapped)
+{
+    const LatencyModel sModel{.distribution = LatencyDistribution::PARETO, .median = 1'000us, .spread = 0.1};
+
+    std::chrono::microseconds sMax{0};
+    for (uint64_t i = 0; i < 10'000; ++i)
+    {
+        sMax = std::max(sMax, sampleLatency(sModel, 42, i));
+    }
+
+    EXPECT_GT(sMax, 100 * sModel.median);
+    EXPECT_LE(sMax, 1'000 * sModel.median);
+}
+
+TEST(ShardFetchSimulationTest, ExecutorResumesInDeadlineOrder)
+{
+    SimulationExecutor sExecutor;
+    std::vector<int>   sOrder;
+
+    const auto sNow = SimulationExecutor::Clock::now();
+    sExecutor.spawn(RecordWake(sExecutor, sNow + 3ms, 3, sOrder));
+    sExecutor.spawn(RecordWake(sExecutor, sNow + 1ms, 1, sOrder));
+    sExecutor.spawn(RecordWake(sExecutor, sNow + 2ms, 2, sOrder));
+    sExecutor.spawn(RecordWake(sExecutor, sNow + 1ms, 4, sOrder));
+    sExecutor.run();
+
+    EXPECT_EQ(sOrder, (std::vector<int>{1, 4, 2, 3}));
+    EXPECT_GE(SimulationExecutor::Clock::now(), sNow + 3ms);
+}
+
+TEST(ShardFetchSimulationTest, ExecutorRethrowsTaskErrors)
+{
+    SimulationExecutor sExecutor;
+    std::vector<int>   sOrder;
+
+    sExecutor.spawn(FailAfterSleep(sExecutor));
+    sExecutor.spawn(RecordWake(sExecutor, SimulationExecutor::Clock::now() + 1s, 1, sOrder));
+
+    EXPECT_THROW(sExecutor.run(), std::runtime_error);
+    EXPECT_TRUE(sOrder.empty());
+}
+
+TEST(ShardFetchSimulationTest, MergesEveryShardAndRecordsSnapshots)
+{
+    const auto     sData = MakeShardData(20, 10);
+    IdSetEstimator sEstimator;
+
+    ShardFetchOptions sOptions;
+    sOptions.latency           = {.distribution = LatencyDistribution::EXPONENTIAL, .median = 2'000us};
+    sOptions.seed              = 5;
+    sOptions.snapshot_interval = 3;
+
+    const auto sReport = simulateShardFetch(sEstimator, sData, sOptions);
+
+    EXPECT_EQ(sEstimator.estimateCoverage(), sData.total_size);
+    ASSERT_FALSE(sReport.snapshots.empty());
+    EXPECT_EQ(sReport.snapshots.front().merged_shard_count, 1);
+    EXPECT_EQ(sReport.snapshots.front().estimate, 10);
+    EXPECT_EQ(sReport.snapshots.back().merged_shard_count, 20);
+    EXPECT_EQ(sReport.snapshots.back().estimate, sData.total_size);
+    // First, every third and the last shard.
+    EXPECT_EQ(sReport.snapshots.size(), 8);
+    for (size_t i = 1; i < sReport.snapshots.size(); ++i)
+    {
+        EXPECT_GE(sReport.snapshots[i].elapsed, sReport.snapshots[i - 1].elapsed);
+        EXPECT_GT(sReport.snapshots[i].merged_shard_count, sReport.snapshots[i - 1].merged_shard_count);
+    }
+
+    EXPECT_LE(sReport.time_to_first_estimate, sReport.time_to_final_estimate);
+    EXPECT_GE(sReport.time_to_final_estimate, sReport.latency_max);
+    EXPECT_LE(sReport.latency_p50, sReport.latency_p99);
+    EXPECT_LE(sReport.latency_p99, sReport.latency_max);
+
+    EXPECT_EQ(answerAtQuorum(sReport, sData.shardCount(), 0.5).merged_shard_count, 12);
+    EXPECT_EQ(answerAtQuorum(sReport, sData.shardCount(), 1.0).merged_shard_count, 20);
+    EXPECT_EQ(answerAtDeadline(sReport, 0ns), nullptr);
+    EXPECT_EQ(answerAtDeadline(sReport, sReport.time_to_final_estimate)->merged_shard_count, 20);
+}
+
+TEST(ShardFetchSimulationTest, HandlesNoShards)
+{
+    IdSetEstimator sEstimator;
+    const auto     sReport = simulateShardFetch(sEstimator, ShardData(), ShardFetchOptions());
+
+    ASSERT_EQ(sReport.snapshots.size(), 1);
+    EXPECT_EQ(sReport.snapshots.front().estimate, 0);
+    EXPECT_EQ(answerAtQuorum(sReport, 0, 0.9).merged_shard_count, 0);
+}
+
+// Small shards keep every shipped HyperLogLog sparse, the later merges densify the aggregate.
+TEST(ShardFetchEstimatorTest, HyperLogLogMatchesSequentialIngestion)
+{
+    constexpr uint64_t BUCKET_COUNT_LOG2 = 12;
+
+    const auto sData = MakeShardData(30, 40);
+
+    HyperLogLogEstimator sSequential(BUCKET_COUNT_LOG2);
+    sSequential.addShardData({sData}, 1);
+
+    HyperLogLogEstimator sFetched(BUCKET_COUNT_LOG2);
+    ASSERT_TRUE(sFetched.constructDefault().isSparse());
+
+    ShardFetchOptions sOptions;
+    sOptions.latency = {.distribution = LatencyDistribution::EXPONENTIAL, .median = 500us};
+    sOptions.seed    = 11;
+
+    const auto sReport = simulateShardFetch(sFetched, sData, sOptions);
+
+    ASSERT_EQ(sReport.snapshots.size(), sData.shardCount());
+    EXPECT_FALSE(sFetched.getInternalState().isSparse());
+    EXPECT_EQ(sReport.snapshots.back().estimate, sSequential.estimateCoverage());
+    for (size_t i = 1; i < sReport.snapshots.size(); ++i)
+    {
+        EXPECT_GE(sReport.snapshots[i].estimate, sReport.snapshots[i - 1].estimate) << i;
+    }
+}
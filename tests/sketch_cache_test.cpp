@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "sketch_cache.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace
+{
+    std::vector<uint64_t> MakeRange(uint64_t aBegin, uint64_t aEnd)
+    {
+        std::vector<uint64_t> sResult(aEnd - aBegin);
+        std::iota(sResult.begin(), sResult.end(), aBegin);
+
+        return sResult;
+    }
+
+    std::shared_ptr<const uint64_t> GetSum(SketchCache& aCache, const std::vector<uint64_t>& aIds, uint64_t aBytes = 8)
+    {
+        return aCache.getOrBuild<uint64_t>(fingerprintIds(aIds),
+                                           aIds.size(),
+                                           {},
+                                           aBytes,
+                                           [&] { return std::accumulate(aIds.begin(), aIds.end(), uint64_t{0}); });
+    }
+}  // namespace
+
+TEST(SketchCacheTest, FingerprintIgnoresOrder)
+{
+    auto sIds = MakeRange(0, 1000);
+    const auto sFingerprint = fingerprintIds(sIds);
+
+    std::reverse(sIds.begin(), sIds.end());
+    EXPECT_EQ(fingerprintIds(sIds), sFingerprint);
+
+    sIds.back() = 1000;
+    EXPECT_NE(fingerprintIds(sIds), sFingerprint);
+}
+
+TEST(SketchCacheTest, HitsAndMisses)
+{
+    SketchCache sCache(1024);
+    const auto  sIds = MakeRange(0, 100);
+
+    const auto sFirst  = GetSum(sCache, sIds);
+    const auto sSecond = GetSum(sCache, sIds);
+    EXPECT_EQ(sFirst, sSecond);
+    EXPECT_EQ(*sSecond, 4950);
+
+    // Different parameters or state types are different entries.
+    sCache.getOrBuild<uint64_t>(fingerprintIds(sIds), sIds.size(), {.parameter = 1}, 8, [] { return uint64_t{0}; });
+    sCache.getOrBuild<uint32_t>(fingerprintIds(sIds), sIds.size(), {}, 8, [] { return uint32_t{0}; });
+
+    const auto sStatistics = sCache.getStatistics();
+    EXPECT_EQ(sStatistics.hits, 1);
+    EXPECT_EQ(sStatistics.misses, 3);
+    EXPECT_EQ(sStatistics.bytes, 24);
+}
+
+TEST(SketchCacheTest, EvictsLeastRecentlyUsed)
+{
+    SketchCache sCache(16);
+    const auto  sFirst  = MakeRange(0, 10);
+    const auto  sSecond = MakeRange(10, 20);
+    const auto  sThird  = MakeRange(20, 30);
+
+    GetSum(sCache, sFirst);
+    GetSum(sCache, sSecond);
+    GetSum(sCache, sFirst);
+    GetSum(sCache, sThird);
+
+    EXPECT_EQ(sCache.getStatistics().evictions, 1);
+
+    // sSecond was the least recently used one.
+    GetSum(sCache, sFirst);
+    GetSum(sCache, sThird);
+    EXPECT_EQ(sCache.getStatistics().hits, 3);
+    GetSum(sCache, sSecond);
+    EXPECT_EQ(sCache.getStatistics().misses, 4);
+
+    // Too large to be cached at all.
+    GetSum(sCache, MakeRange(0, 5), 32);
+    EXPECT_LE(sCache.getStatistics().bytes, 16);
+}
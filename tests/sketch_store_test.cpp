@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "sketch_store.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    std::string GetStorePath(const std::string& aName)
+    {
+        return ::testing::TempDir() + aName;
+    }
+}  // namespace
+
+TEST(SketchStoreTest, RoundTrip)
+{
+    const std::vector<uint8_t>  sRegisters{1, 2, 3, 4, 5};
+    const std::vector<uint64_t> sWords{7, 11, UINT64_MAX};
+
+    SketchStoreWriter sWriter;
+    sWriter.add(SketchType::HYPER_LOG_LOG, {.parameter = 14}, std::span<const uint8_t>(sRegisters));
+    sWriter.add(SketchType::BLOOM_FILTER, {20, 4, 137}, std::span<const uint64_t>(sWords));
+    sWriter.add(SketchType::RANGE_MIN_HASH, {.parameter = 256}, std::span<const uint64_t>());
+    sWriter.write(GetStorePath("round_trip.sks"));
+
+    MappedSketchStore sStore(GetStorePath("round_trip.sks"));
+    ASSERT_EQ(sStore.size(), 3);
+
+    EXPECT_EQ(sStore[0].type, SketchType::HYPER_LOG_LOG);
+    EXPECT_EQ(sStore[0].parameters, SketchParameters{.parameter = 14});
+    const auto sStoredRegisters = sStore[0].getPayloadAs<uint8_t>();
+    EXPECT_EQ(std::vector<uint8_t>(sStoredRegisters.begin(), sStoredRegisters.end()), sRegisters);
+
+    EXPECT_EQ(sStore[1].type, SketchType::BLOOM_FILTER);
+    EXPECT_EQ(sStore[1].parameters, (SketchParameters{20, 4, 137}));
+    const auto sStoredWords = sStore[1].getPayloadAs<uint64_t>();
+    EXPECT_EQ(std::vector<uint64_t>(sStoredWords.begin(), sStoredWords.end()), sWords);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(sStoredWords.data()) % 64, 0);
+
+    EXPECT_TRUE(sStore[2].payload.empty());
+}
+
+TEST(SketchStoreTest, RejectsOtherVersions)
+{
+    SketchStoreWriter sWriter;
+    sWriter.write(GetStorePath("version.sks"));
+
+    // The version follows the 8-byte magic.
+    std::fstream sFile(GetStorePath("version.sks"), std::ios::in | std::ios::out | std::ios::binary);
+    const uint32_t sVersion = SKETCH_STORE_FORMAT_VERSION + 1;
+    sFile.seekp(8);
+    sFile.write(reinterpret_cast<const char*>(&sVersion), sizeof(sVersion));
+    sFile.close();
+
+    EXPECT_THROW(MappedSketchStore(GetStorePath("version.sks")), std::runtime_error);
+}
+
+TEST(SketchStoreTest, RejectsTruncatedFiles)
+{
+    const std::vector<uint64_t> sWords(16, 42);
+
+    SketchStoreWriter sWriter;
+    sWriter.add(SketchType::BBIT_MIN_HASH, {.parameter = 4}, std::span<const uint64_t>(sWords));
+    sWriter.write(GetStorePath("truncated.sks"));
+
+    std::ifstream     sInput(GetStorePath("truncated.sks"), std::ios::binary);
+    const std::string sContent((std::istreambuf_iterator<char>(sInput)), std::istreambuf_iterator<char>());
+    std::ofstream(GetStorePath("truncated.sks"), std::ios::binary | std::ios::trunc)
+        .write(sContent.data(), sContent.size() - 64);
+
+    EXPECT_THROW(MappedSketchStore(GetStorePath("truncated.sks")), std::runtime_error);
+    EXPECT_THROW(MappedSketchStore(GetStorePath("missing.sks")), std::runtime_error);
+}
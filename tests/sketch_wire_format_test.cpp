@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "sketch_wire_format.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Hash 0 has the largest rank the precision allows, 64 - p + 1.
+    SparseHyperLogLog MakeDenseSketch(uint32_t aBucketCountLog2)
+    {
+        SparseHyperLogLog sResult(aBucketCountLog2, sketch::hll::ORIGINAL);
+        sResult.add(0);
+        for (uint64_t i = 1; i <= 100; ++i)
+        {
+            sResult.add(i * 0x9E3779B97F4A7C15);
+        }
+        sResult.densify();
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(SketchWireFormatTest, PackedHyperLogLogKeepsTheLargestRank)
+{
+    constexpr uint32_t BUCKET_COUNT_LOG2 = 2;
+
+    const auto             sSketch = MakeDenseSketch(BUCKET_COUNT_LOG2);
+    const SketchParameters sParameters{.parameter = BUCKET_COUNT_LOG2};
+    ASSERT_EQ(sSketch.getRegisters()[0], 64 - BUCKET_COUNT_LOG2 + 1);
+
+    SparseHyperLogLog sReceived(BUCKET_COUNT_LOG2, sketch::hll::ORIGINAL);
+    mergeEncodedSketch(sReceived, encodeSketch(sSketch, sParameters), sParameters);
+
+    EXPECT_EQ(sReceived.getRegisters(), sSketch.getRegisters());
+}
+
+TEST(SketchWireFormatTest, RejectsHyperLogLogPrecisionOne)
+{
+    const SketchParameters sParameters{.parameter = 1};
+
+    EXPECT_THROW(encodeSketch(MakeDenseSketch(1), sParameters), std::invalid_argument);
+    SparseHyperLogLog sReceived(1, sketch::hll::ORIGINAL);
+    EXPECT_THROW(mergeEncodedSketch(sReceived, encodeSketch(MakeDenseSketch(2), sParameters), sParameters),
+                 std::invalid_argument);
+}
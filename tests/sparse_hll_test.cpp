@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include "sparse_hll.hpp"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    constexpr uint32_t PRECISION = 10;
+
+    std::vector<uint64_t> MakeHashes(size_t aCount, uint64_t aSeed)
+    {
+        std::mt19937_64       sRandom(aSeed);
+        std::vector<uint64_t> sResult(aCount);
+        for (auto& sHash : sResult)
+        {
+            sHash = sRandom();
+        }
+
+        return sResult;
+    }
+
+    sketch::hll_t MakeReference(const std::vector<std::vector<uint64_t>>& aHashSets)
+    {
+        sketch::hll_t sResult(PRECISION, sketch::hll::ORIGINAL);
+        for (const auto& sHashes : aHashSets)
+        {
+            for (auto sHash : sHashes)
+            {
+                sResult.add(sHash);
+            }
+        }
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(SparseHyperLogLogTest, SparseEstimateMatchesDenseSketch)
+{
+    const auto sHashes = MakeHashes(50, 1);
+
+    SparseHyperLogLog sSketch(PRECISION, sketch::hll::ORIGINAL);
+    for (auto sHash : sHashes)
+    {
+        sSketch.add(sHash);
+    }
+
+    ASSERT_TRUE(sSketch.isSparse());
+    EXPECT_DOUBLE_EQ(sSketch.cardinality_estimate(), MakeReference({sHashes}).cardinality_estimate());
+}
+
+TEST(SparseHyperLogLogTest, MergingSparseIntoEstimatedDenseRefreshesEstimate)
+{
+    const auto sDenseHashes  = MakeHashes(5'000, 2);
+    const auto sSparseHashes = MakeHashes(60, 3);
+
+    SparseHyperLogLog sDense(PRECISION, sketch::hll::ORIGINAL);
+    for (auto sHash : sDenseHashes)
+    {
+        sDense.add(sHash);
+    }
+    SparseHyperLogLog sSparse(PRECISION, sketch::hll::ORIGINAL);
+    for (auto sHash : sSparseHashes)
+    {
+        sSparse.add(sHash);
+    }
+    ASSERT_FALSE(sDense.isSparse());
+    ASSERT_TRUE(sSparse.isSparse());
+
+    // Caches the dense sketch's estimate before the merge.
+    const double sBefore = sDense.cardinality_estimate();
+    sDense += sSparse;
+
+    EXPECT_NE(sDense.cardinality_estimate(), sBefore);
+    EXPECT_DOUBLE_EQ(sDense.cardinality_estimate(),
+                     MakeReference({sDenseHashes, sSparseHashes}).cardinality_estimate());
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "split_block_bloom_filter.hpp"
+
+#include <numeric>
+
+namespace
+{
+    std::vector<uint64_t> MakeRange(uint64_t aBegin, uint64_t aEnd)
+    {
+        std::vector<uint64_t> sResult(aEnd - aBegin);
+        std::iota(sResult.begin(), sResult.end(), aBegin);
+
+        return sResult;
+    }
+}  // namespace
+
+TEST(SplitBlockBloomFilterTest, NoFalseNegatives)
+{
+    SplitBlockBloomFilter sFilter(12, 137);
+    sFilter.addIds(MakeRange(0, 100'000));
+
+    for (uint64_t sId = 0; sId < 100'000; ++sId)
+    {
+        ASSERT_TRUE(sFilter.mayContain(sId)) << sId;
+    }
+}
+
+TEST(SplitBlockBloomFilterTest, FalsePositiveRate)
+{
+    // 2^20 bits for 100'000 ids, about 10 bits per id.
+    SplitBlockBloomFilter sFilter(12, 137);
+    sFilter.addIds(MakeRange(0, 100'000));
+
+    uint32_t sFalsePositives = 0;
+    for (uint64_t sId = 100'000; sId < 200'000; ++sId)
+    {
+        sFalsePositives += sFilter.mayContain(sId);
+    }
+
+    EXPECT_LT(sFalsePositives, 100'000 * 2 / 100);
+}
+
+TEST(SplitBlockBloomFilterTest, MergeMatchesDirectInsertion)
+{
+    SplitBlockBloomFilter sDirect(10, 137);
+    sDirect.addIds(MakeRange(0, 20'000));
+
+    SplitBlockBloomFilter sMerged(10, 137);
+    SplitBlockBloomFilter sRight(10, 137);
+    sMerged.addIds(MakeRange(0, 10'000));
+    sRight.addIds(MakeRange(10'000, 20'000));
+    sMerged |= sRight;
+
+    for (uint64_t sId = 0; sId < 40'000; ++sId)
+    {
+        ASSERT_EQ(sMerged.mayContain(sId), sDirect.mayContain(sId)) << sId;
+    }
+}
+
+TEST(SplitBlockBloomFilterTest, IntersectionKeepsCommonIds)
+{
+    SplitBlockBloomFilter sLeft(12, 137);
+    SplitBlockBloomFilter sRight(12, 137);
+    sLeft.addIds(MakeRange(0, 20'000));
+    sRight.addIds(MakeRange(10'000, 30'000));
+    sLeft &= sRight;
+
+    for (uint64_t sId = 10'000; sId < 20'000; ++sId)
+    {
+        ASSERT_TRUE(sLeft.mayContain(sId)) << sId;
+    }
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndexOnce)
+{
+    // Zero, below the worker count, odd and well above the worker count.
+    for (uint32_t sWorkerCount : {1, 4})
+    {
+        ThreadPool sPool(sWorkerCount);
+        EXPECT_EQ(sPool.getWorkerCount(), sWorkerCount);
+
+        for (size_t sCount : {0, 1, 3, 7, 1'001})
+        {
+            std::vector<std::atomic<uint32_t>> sVisits(sCount);
+            parallelFor(sPool, sCount, [&](size_t i) { ++sVisits[i]; });
+
+            for (size_t i = 0; i < sCount; ++i)
+            {
+                ASSERT_EQ(sVisits[i], 1) << sWorkerCount << ' ' << sCount << ' ' << i;
+            }
+        }
+    }
+}
+
+TEST(ThreadPoolTest, ParallelTransformKeepsOrder)
+{
+    for (uint32_t sWorkerCount : {1, 4})
+    {
+        ThreadPool sPool(sWorkerCount);
+
+        EXPECT_TRUE(parallelTransform(sPool, 0, [](size_t i) { return i; }).empty());
+
+        for (size_t sCount : {1, 3, 7, 1'001})
+        {
+            const auto sSquares = parallelTransform(sPool, sCount, [](size_t i) { return i * i; });
+
+            ASSERT_EQ(sSquares.size(), sCount);
+            for (size_t i = 0; i < sCount; ++i)
+            {
+                ASSERT_EQ(sSquares[i], i * i) << sWorkerCount << ' ' << sCount;
+            }
+        }
+    }
+}
+
+TEST(ThreadPoolTest, RethrowsTaskExceptionAfterAllTasks)
+{
+    for (uint32_t sWorkerCount : {1, 4})
+    {
+        ThreadPool            sPool(sWorkerCount);
+        std::atomic<uint32_t> sFinished{0};
+
+        const auto sRun = [&]
+        {
+            parallelFor(sPool,
+                        9,
+                        [&](size_t i)
+                        {
+                            if (i % 3 == 1)
+                            {
+                                throw std::runtime_error("Failed task");
+                            }
+                            ++sFinished;
+                        });
+        };
+
+        EXPECT_THROW(sRun(), std::runtime_error);
+        EXPECT_EQ(sFinished, 6) << sWorkerCount;
+
+        EXPECT_THROW(parallelTransform(sPool,
+                                       5,
+                                       [](size_t i)
+                                       {
+                                           if (i == 4)
+                                           {
+                                               throw std::invalid_argument("Failed task");
+                                           }
+                                           return i;
+                                       }),
+                     std::invalid_argument);
+
+        // The pool stays usable after a failed task.
+        EXPECT_EQ(parallelTransform(sPool, 2, [](size_t i) { return i; }), (std::vector<size_t>{0, 1}));
+    }
+}
+
+TEST(ThreadPoolTest, TreeReduceMatchesLeftFold)
+{
+    // Concatenation is associative but not commutative, so the order of the merges is checked as well.
+    const auto sConcatenate = [](std::string& aLeft, const std::string& aRight) { aLeft += aRight; };
+
+    for (uint32_t sWorkerCount : {1, 3})
+    {
+        ThreadPool sPool(sWorkerCount);
+
+        for (size_t sCount : {1, 2, 3, 5, 8, 40, 41})
+        {
+            std::vector<std::string> sStates;
+            for (size_t i = 0; i < sCount; ++i)
+            {
+                sStates.push_back(std::to_string(i) + ',');
+            }
+
+            const auto sExpected = std::accumulate(sStates.begin(), sStates.end(), std::string());
+            EXPECT_EQ(treeReduce(sPool, sStates, sConcatenate), sExpected) << sWorkerCount << ' ' << sCount;
+        }
+    }
+}
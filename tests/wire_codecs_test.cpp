@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "wire_codecs.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+TEST(WireCodecsTest, VarintsRoundTrip)
+{
+    const std::vector<uint64_t> sValues{0, 1, 127, 128, 300, uint64_t{1} << 35, std::numeric_limits<uint64_t>::max()};
+
+    WireWriter sWriter;
+    for (auto sValue : sValues)
+    {
+        sWriter.writeVarint(sValue);
+    }
+    const auto sBytes = sWriter.release();
+    // 1 + 1 + 1 + 2 + 2 + 6 + 10 bytes.
+    EXPECT_EQ(sBytes.size(), 23);
+
+    WireReader sReader(sBytes);
+    for (auto sValue : sValues)
+    {
+        EXPECT_EQ(sReader.readVarint(), sValue);
+    }
+    EXPECT_TRUE(sReader.atEnd());
+    EXPECT_THROW(sReader.readVarint(), std::invalid_argument);
+}
+
+TEST(WireCodecsTest, PackedRegistersRoundTrip)
+{
+    std::mt19937         sEngine(42);
+    std::vector<uint8_t> sRegisters(1'001);
+    std::generate(sRegisters.begin(), sRegisters.end(), [&] { return static_cast<uint8_t>(sEngine() % 64); });
+
+    WireWriter sWriter;
+    writePackedRegisters(sWriter, sRegisters, 6);
+    const auto sBytes = sWriter.release();
+    EXPECT_EQ(sBytes.size(), (1'001 * 6 + 7) / 8);
+
+    std::vector<uint8_t> sDecoded(sRegisters.size());
+    WireReader           sReader(sBytes);
+    readPackedRegisters(sReader, sDecoded, 6);
+    EXPECT_EQ(sDecoded, sRegisters);
+
+    WireWriter sTooNarrow;
+    EXPECT_THROW(writePackedRegisters(sTooNarrow, std::vector<uint8_t>{64}, 6), std::invalid_argument);
+}
+
+TEST(WireCodecsTest, SortedValuesRoundTrip)
+{
+    const std::vector<uint64_t> sValues{3, 3, 10, 1'000, std::numeric_limits<uint64_t>::max()};
+
+    WireWriter sWriter;
+    writeSortedValues(sWriter, sValues);
+    const auto sBytes = sWriter.release();
+
+    WireReader sReader(sBytes);
+    EXPECT_EQ(readSortedValues(sReader), sValues);
+    EXPECT_TRUE(sReader.atEnd());
+
+    WireWriter sUnsorted;
+    EXPECT_THROW(writeSortedValues(sUnsorted, std::vector<uint64_t>{2, 1}), std::invalid_argument);
+
+    // The count promises more values than the message holds.
+    WireReader sTruncated{std::span(sBytes).first(3)};
+    EXPECT_THROW(readSortedValues(sTruncated), std::invalid_argument);
+}
+
+TEST(WireCodecsTest, MinimumCodesAreMonotoneAndMergeable)
+{
+    EXPECT_EQ(decodeMinimum(encodeMinimum(std::numeric_limits<uint64_t>::max())), std::numeric_limits<uint64_t>::max());
+    for (uint64_t sValue = 1; sValue < 2'048; ++sValue)
+    {
+        EXPECT_EQ(decodeMinimum(encodeMinimum(sValue)), sValue);
+    }
+
+    std::mt19937_64 sEngine(42);
+    for (int i = 0; i < 10'000; ++i)
+    {
+        const uint64_t sLeft  = (sEngine() >> (sEngine() % 64)) | 1;
+        const uint64_t sRight = sEngine() >> (sEngine() % 64);
+
+        // Rounded up to the largest value of the code, within 2^-10 relative.
+        const uint64_t sDecoded = decodeMinimum(encodeMinimum(sLeft));
+        EXPECT_GE(sDecoded, sLeft);
+        EXPECT_LE(static_cast<double>(sDecoded - sLeft), static_cast<double>(sLeft) / 1'024);
+
+        EXPECT_EQ(std::min(encodeMinimum(sLeft), encodeMinimum(sRight)), encodeMinimum(std::min(sLeft, sRight)));
+    }
+}
+
+TEST(WireCodecsTest, BitmapsRoundTripAndMerge)
+{
+    std::mt19937_64 sEngine(42);
+
+    // Few set bits, encoded as positions, and mostly full words, run-length encoded.
+    std::vector<uint64_t> sSparse(4'096);
+    for (int i = 0; i < 100; ++i)
+    {
+        sSparse[sEngine() % sSparse.size()] |= uint64_t{1} << (sEngine() % 64);
+    }
+    std::vector<uint64_t> sDense(4'096);
+    std::generate(sDense.begin(), sDense.end() - 1'000, sEngine);
+
+    for (const auto& sWords : {sSparse, sDense})
+    {
+        WireWriter sWriter;
+        writeBitmap(sWriter, sWords);
+        const auto sBytes = sWriter.release();
+        EXPECT_LT(sBytes.size(), sWords.size() * sizeof(uint64_t));
+
+        std::vector<uint64_t> sDecoded(sWords.size());
+        WireReader            sReader(sBytes);
+        readBitmap(sReader, sDecoded);
+        EXPECT_TRUE(sReader.atEnd());
+        EXPECT_EQ(sDecoded, sWords);
+    }
+
+    WireWriter sWriter;
+    writeBitmap(sWriter, sSparse);
+    const auto sBytes = sWriter.release();
+
+    auto       sUnion = sDense;
+    WireReader sReader(sBytes);
+    readBitmap(sReader, sUnion);
+    for (size_t i = 0; i < sUnion.size(); ++i)
+    {
+        EXPECT_EQ(sUnion[i], sDense[i] | sSparse[i]);
+    }
+
+    std::vector<uint64_t> sOtherLength(100);
+    WireReader            sMismatched(sBytes);
+    EXPECT_THROW(readBitmap(sMismatched, sOtherLength), std::invalid_argument);
+}
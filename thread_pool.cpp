@@ -0,0 +1,53 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t aWorkerCount)
+{
+    aWorkerCount = std::max(aWorkerCount, 1u);
+
+    workers.reserve(aWorkerCount);
+    for (uint32_t i = 0; i < aWorkerCount; ++i)
+    {
+        workers.emplace_back([this](std::stop_token aStopToken) { workerLoop(aStopToken); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    for (auto& sWorker : workers)
+    {
+        sWorker.request_stop();
+    }
+    condition.notify_all();
+}
+
+uint32_t ThreadPool::getWorkerCount() const
+{
+    return workers.size();
+}
+
+uint32_t ThreadPool::defaultWorkerCount()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void ThreadPool::workerLoop(std::stop_token aStopToken)
+{
+    while (true)
+    {
+        std::function<void()> sTask;
+        {
+            std::unique_lock sLock(mutex);
+            if (!condition.wait(sLock, aStopToken, [this] { return !tasks.empty(); }))
+            {
+                return;
+            }
+
+            sTask = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        sTask();
+    }
+}
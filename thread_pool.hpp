@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t aWorkerCount = defaultWorkerCount());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename Task>
+    std::future<std::invoke_result_t<Task>> submit(Task&& aTask)
+    {
+        using ResultType = std::invoke_result_t<Task>;
+
+        auto sTask   = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Task>(aTask));
+        auto sResult = sTask->get_future();
+        {
+            std::lock_guard sLock(mutex);
+            tasks.emplace([sTask] { (*sTask)(); });
+        }
+        condition.notify_one();
+
+        return sResult;
+    }
+
+    uint32_t getWorkerCount() const;
+
+    static uint32_t defaultWorkerCount();
+
+private:
+    void workerLoop(std::stop_token aStopToken);
+
+    std::mutex                        mutex;
+    std::condition_variable_any       condition;
+    std::queue<std::function<void()>> tasks;
+    std::vector<std::jthread>         workers;
+};
+
+// Calls aFunction(i) for every i in [0, aCount) on the pool and blocks until all of them are done.
+// The first exception thrown by a task is rethrown after every task has finished.
+template <typename Function>
+void parallelFor(ThreadPool& aPool, size_t aCount, Function&& aFunction)
+{
+    std::vector<std::future<void>> sFutures;
+    sFutures.reserve(aCount);
+
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        sFutures.push_back(aPool.submit([&aFunction, i] { aFunction(i); }));
+    }
+
+    std::exception_ptr sError;
+    for (auto& sFuture : sFutures)
+    {
+        try
+        {
+            sFuture.get();
+        }
+        catch (...)
+        {
+            if (!sError)
+            {
+                sError = std::current_exception();
+            }
+        }
+    }
+
+    if (sError)
+    {
+        std::rethrow_exception(sError);
+    }
+}
+
+template <typename Function>
+auto parallelTransform(ThreadPool& aPool, size_t aCount, Function&& aFunction)
+{
+    using ResultType = std::invoke_result_t<Function, size_t>;
+
+    std::vector<std::optional<ResultType>> sPartialResults(aCount);
+    parallelFor(aPool, aCount, [&](size_t i) { sPartialResults[i].emplace(aFunction(i)); });
+
+    std::vector<ResultType> sResult;
+    sResult.reserve(aCount);
+    for (auto& sPartialResult : sPartialResults)
+    {
+        sResult.push_back(std::move(*sPartialResult));
+    }
+
+    return sResult;
+}
+
+// Pairwise reduction: every round merges elements that are aStride apart concurrently, so n states
+// are folded in ceil(log2(n)) rounds. aMerge(aLeft, aRight) must accumulate aRight into aLeft. aStates must not
+// be empty.
+template <typename State, typename Merge>
+State treeReduce(ThreadPool& aPool, std::vector<State> aStates, Merge&& aMerge)
+{
+    for (size_t sStride = 1; sStride < aStates.size(); sStride *= 2)
+    {
+        parallelFor(aPool,
+                    (aStates.size() + 2 * sStride - 1) / (2 * sStride),
+                    [&](size_t i)
+                    {
+                        const size_t sLeft  = i * 2 * sStride;
+                        const size_t sRight = sLeft + sStride;
+                        if (sRight < aStates.size())
+                        {
+                            aMerge(aStates[sLeft], aStates[sRight]);
+                        }
+                    });
+    }
+
+    return std::move(aStates.front());
+}
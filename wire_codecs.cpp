@@ -0,0 +1,320 @@
+#include "wire_codecs.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace
+{
+    enum class BitmapEncoding : uint8_t
+    {
+        RUNS      = 0,
+        POSITIONS = 1
+    };
+
+    constexpr uint32_t MANTISSA_BITS = 10;
+
+    size_t getVarintSize(uint64_t aValue)
+    {
+        return std::max<size_t>(1, (std::bit_width(aValue) + 6) / 7);
+    }
+
+    // Calls aConsumer(zero word count, literal words) for every run of zero words and the non-zero words after it.
+    template <typename Consumer>
+    void forEachRun(std::span<const uint64_t> aWords, Consumer&& aConsumer)
+    {
+        size_t sOffset = 0;
+        while (sOffset < aWords.size())
+        {
+            size_t sZeroCount = 0;
+            while (sOffset + sZeroCount < aWords.size() && aWords[sOffset + sZeroCount] == 0)
+            {
+                ++sZeroCount;
+            }
+
+            const size_t sLiteralOffset = sOffset + sZeroCount;
+            size_t       sLiteralCount  = 0;
+            while (sLiteralOffset + sLiteralCount < aWords.size() && aWords[sLiteralOffset + sLiteralCount] != 0)
+            {
+                ++sLiteralCount;
+            }
+
+            aConsumer(sZeroCount, aWords.subspan(sLiteralOffset, sLiteralCount));
+            sOffset = sLiteralOffset + sLiteralCount;
+        }
+    }
+
+    template <typename Consumer>
+    void forEachSetBit(std::span<const uint64_t> aWords, Consumer&& aConsumer)
+    {
+        for (size_t i = 0; i < aWords.size(); ++i)
+        {
+            for (uint64_t sWord = aWords[i]; sWord != 0; sWord &= sWord - 1)
+            {
+                aConsumer(i * 64 + static_cast<uint64_t>(std::countr_zero(sWord)));
+            }
+        }
+    }
+}  // namespace
+
+void WireWriter::writeByte(uint8_t aValue)
+{
+    bytes.push_back(static_cast<std::byte>(aValue));
+}
+
+void WireWriter::writeVarint(uint64_t aValue)
+{
+    while (aValue >= 0x80)
+    {
+        writeByte(static_cast<uint8_t>(aValue | 0x80));
+        aValue >>= 7;
+    }
+    writeByte(static_cast<uint8_t>(aValue));
+}
+
+void WireWriter::writeBytes(std::span<const std::byte> aBytes)
+{
+    bytes.insert(bytes.end(), aBytes.begin(), aBytes.end());
+}
+
+size_t WireWriter::size() const
+{
+    return bytes.size();
+}
+
+std::vector<std::byte> WireWriter::release()
+{
+    return std::move(bytes);
+}
+
+WireReader::WireReader(std::span<const std::byte> aBytes) : bytes(aBytes) {}
+
+uint8_t WireReader::readByte()
+{
+    return static_cast<uint8_t>(readBytes(1)[0]);
+}
+
+uint64_t WireReader::readVarint()
+{
+    uint64_t sResult = 0;
+    for (uint32_t sShift = 0; sShift < 64; sShift += 7)
+    {
+        const uint8_t sByte = readByte();
+        sResult |= uint64_t{sByte & 0x7Fu} << sShift;
+        if ((sByte & 0x80) == 0)
+        {
+            return sResult;
+        }
+    }
+
+    throw std::invalid_argument("Wire message has a varint longer than 64 bits");
+}
+
+std::span<const std::byte> WireReader::readBytes(size_t aCount)
+{
+    if (aCount > bytes.size() - offset)
+    {
+        throw std::invalid_argument("Wire message is truncated");
+    }
+
+    const auto sResult = bytes.subspan(offset, aCount);
+    offset += aCount;
+
+    return sResult;
+}
+
+bool WireReader::atEnd() const
+{
+    return offset == bytes.size();
+}
+
+void writePackedRegisters(WireWriter& aWriter, std::span<const uint8_t> aRegisters, uint32_t aBitsPerRegister)
+{
+    uint64_t sBits     = 0;
+    uint32_t sBitCount = 0;
+    for (auto sRegister : aRegisters)
+    {
+        if ((sRegister >> aBitsPerRegister) != 0)
+        {
+            throw std::invalid_argument("Register does not fit the packed width");
+        }
+
+        sBits |= uint64_t{sRegister} << sBitCount;
+        sBitCount += aBitsPerRegister;
+        for (; sBitCount >= 8; sBitCount -= 8, sBits >>= 8)
+        {
+            aWriter.writeByte(static_cast<uint8_t>(sBits));
+        }
+    }
+
+    if (sBitCount > 0)
+    {
+        aWriter.writeByte(static_cast<uint8_t>(sBits));
+    }
+}
+
+void readPackedRegisters(WireReader& aReader, std::span<uint8_t> aRegisters, uint32_t aBitsPerRegister)
+{
+    const auto    sBytes = aReader.readBytes((aRegisters.size() * aBitsPerRegister + 7) / 8);
+    const uint8_t sMask  = static_cast<uint8_t>((1u << aBitsPerRegister) - 1);
+
+    uint64_t sBits     = 0;
+    uint32_t sBitCount = 0;
+    size_t   sNextByte = 0;
+    for (auto& sRegister : aRegisters)
+    {
+        for (; sBitCount < aBitsPerRegister; sBitCount += 8)
+        {
+            sBits |= uint64_t{static_cast<uint8_t>(sBytes[sNextByte++])} << sBitCount;
+        }
+
+        sRegister = static_cast<uint8_t>(sBits & sMask);
+        sBits >>= aBitsPerRegister;
+        sBitCount -= aBitsPerRegister;
+    }
+}
+
+void writeSortedValues(WireWriter& aWriter, std::span<const uint64_t> aValues)
+{
+    if (!std::is_sorted(aValues.begin(), aValues.end()))
+    {
+        throw std::invalid_argument("Values to write must be sorted");
+    }
+
+    aWriter.writeVarint(aValues.size());
+
+    uint64_t sPrevious = 0;
+    for (auto sValue : aValues)
+    {
+        aWriter.writeVarint(sValue - sPrevious);
+        sPrevious = sValue;
+    }
+}
+
+std::vector<uint64_t> readSortedValues(WireReader& aReader)
+{
+    const uint64_t sCount = aReader.readVarint();
+
+    std::vector<uint64_t> sResult;
+    uint64_t              sValue = 0;
+    for (uint64_t i = 0; i < sCount; ++i)
+    {
+        sValue += aReader.readVarint();
+        sResult.push_back(sValue);
+    }
+
+    return sResult;
+}
+
+uint16_t encodeMinimum(uint64_t aValue)
+{
+    const uint32_t sExponent = aValue == 0 ? 0 : static_cast<uint32_t>(std::bit_width(aValue)) - 1;
+    const uint64_t sBelow    = aValue & ((uint64_t{1} << sExponent) - 1);
+    const uint64_t sMantissa = sExponent >= MANTISSA_BITS ? sBelow >> (sExponent - MANTISSA_BITS)
+                                                          : sBelow << (MANTISSA_BITS - sExponent);
+
+    return static_cast<uint16_t>(sExponent << MANTISSA_BITS | sMantissa);
+}
+
+uint64_t decodeMinimum(uint16_t aCode)
+{
+    const uint32_t sExponent = aCode >> MANTISSA_BITS;
+    const uint64_t sMantissa = aCode & ((1u << MANTISSA_BITS) - 1);
+    if (sExponent < MANTISSA_BITS)
+    {
+        return (uint64_t{1} << sExponent) | (sMantissa >> (MANTISSA_BITS - sExponent));
+    }
+
+    const uint32_t sDroppedBits = sExponent - MANTISSA_BITS;
+    return (uint64_t{1} << sExponent) | (sMantissa << sDroppedBits) | ((uint64_t{1} << sDroppedBits) - 1);
+}
+
+void writeBitmap(WireWriter& aWriter, std::span<const uint64_t> aWords)
+{
+    size_t sRunsSize = 0;
+    forEachRun(aWords,
+               [&](size_t aZeroCount, std::span<const uint64_t> aLiterals)
+               {
+                   sRunsSize += getVarintSize(aZeroCount) + getVarintSize(aLiterals.size())
+                                + aLiterals.size() * sizeof(uint64_t);
+               });
+
+    size_t   sPositionsSize = 0;
+    uint64_t sPrevious      = 0;
+    forEachSetBit(aWords,
+                  [&](uint64_t aPosition)
+                  {
+                      sPositionsSize += getVarintSize(aPosition - sPrevious);
+                      sPrevious = aPosition;
+                  });
+
+    aWriter.writeVarint(aWords.size());
+    if (sPositionsSize < sRunsSize)
+    {
+        std::vector<uint64_t> sPositions;
+        forEachSetBit(aWords, [&](uint64_t aPosition) { sPositions.push_back(aPosition); });
+
+        aWriter.writeByte(static_cast<uint8_t>(BitmapEncoding::POSITIONS));
+        writeSortedValues(aWriter, sPositions);
+        return;
+    }
+
+    aWriter.writeByte(static_cast<uint8_t>(BitmapEncoding::RUNS));
+    forEachRun(aWords,
+               [&](size_t aZeroCount, std::span<const uint64_t> aLiterals)
+               {
+                   aWriter.writeVarint(aZeroCount);
+                   aWriter.writeVarint(aLiterals.size());
+                   aWriter.writeBytes(std::as_bytes(aLiterals));
+               });
+}
+
+void readBitmap(WireReader& aReader, std::span<uint64_t> aWords)
+{
+    if (aReader.readVarint() != aWords.size())
+    {
+        throw std::invalid_argument("Wire bitmap has a different length");
+    }
+
+    const auto sEncoding = static_cast<BitmapEncoding>(aReader.readByte());
+    if (sEncoding == BitmapEncoding::POSITIONS)
+    {
+        for (auto sPosition : readSortedValues(aReader))
+        {
+            if (sPosition / 64 >= aWords.size())
+            {
+                throw std::invalid_argument("Wire bitmap has a bit past its end");
+            }
+            aWords[sPosition / 64] |= uint64_t{1} << (sPosition % 64);
+        }
+        return;
+    }
+    if (sEncoding != BitmapEncoding::RUNS)
+    {
+        throw std::invalid_argument("Wire bitmap has an unknown encoding");
+    }
+
+    size_t sOffset = 0;
+    while (sOffset < aWords.size())
+    {
+        const uint64_t sZeroCount    = aReader.readVarint();
+        const uint64_t sLiteralCount = aReader.readVarint();
+        if (sZeroCount > aWords.size() - sOffset || sLiteralCount > aWords.size() - sOffset - sZeroCount)
+        {
+            throw std::invalid_argument("Wire bitmap has a run past its end");
+        }
+        if (sZeroCount + sLiteralCount == 0)
+        {
+            throw std::invalid_argument("Wire bitmap has an empty run");
+        }
+
+        sOffset += sZeroCount;
+        const auto sLiterals = aReader.readBytes(sLiteralCount * sizeof(uint64_t));
+        for (uint64_t i = 0; i < sLiteralCount; ++i)
+        {
+            uint64_t sWord;
+            std::memcpy(&sWord, sLiterals.data() + i * sizeof(uint64_t), sizeof(uint64_t));
+            aWords[sOffset++] |= sWord;
+        }
+    }
+}
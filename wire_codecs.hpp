@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// Byte buffer a wire message is appended to. Fixed-size values are written in host byte order: messages only
+// travel between processes of the same build.
+class WireWriter
+{
+public:
+    void writeByte(uint8_t aValue);
+    // LEB128: seven bits per byte, small values take a single byte.
+    void writeVarint(uint64_t aValue);
+    void writeBytes(std::span<const std::byte> aBytes);
+
+    template <typename T>
+    void writeValue(T aValue)
+    {
+        writeBytes(std::as_bytes(std::span<const T>(&aValue, 1)));
+    }
+
+    size_t                 size() const;
+    std::vector<std::byte> release();
+
+private:
+    std::vector<std::byte> bytes;
+};
+
+// Reads a wire message front to back. Throws std::invalid_argument when reading past the end of the message or
+// on a malformed varint.
+class WireReader
+{
+public:
+    explicit WireReader(std::span<const std::byte> aBytes);
+
+    uint8_t                    readByte();
+    uint64_t                   readVarint();
+    std::span<const std::byte> readBytes(size_t aCount);
+
+    template <typename T>
+    T readValue()
+    {
+        T sResult;
+        std::memcpy(&sResult, readBytes(sizeof(T)).data(), sizeof(T));
+
+        return sResult;
+    }
+
+    bool atEnd() const;
+
+private:
+    std::span<const std::byte> bytes;
+    size_t                     offset{0};
+};
+
+// Packs every register into its aBitsPerRegister low bits, registers must not exceed them. 6 bits hold any
+// HyperLogLog rank from precision 2 on, at precision 1 a rank can reach 64.
+void writePackedRegisters(WireWriter& aWriter, std::span<const uint8_t> aRegisters, uint32_t aBitsPerRegister);
+// aRegisters receives as many registers as it is long.
+void readPackedRegisters(WireReader& aReader, std::span<uint8_t> aRegisters, uint32_t aBitsPerRegister);
+
+// Ascending values as their count, the first value and the varint gaps between neighbours. Throws
+// std::invalid_argument when aValues is not sorted.
+void                  writeSortedValues(WireWriter& aWriter, std::span<const uint64_t> aValues);
+std::vector<uint64_t> readSortedValues(WireReader& aReader);
+
+// 16-bit code of a 64-bit minimum: the position of its highest set bit and the ten bits below it. The code is
+// monotone, so the minimum of codes is the code of the minimum and coded registers stay mergeable.
+// decodeMinimum returns the largest value with the code, which keeps UINT64_MAX (an empty register) exact.
+uint16_t encodeMinimum(uint64_t aValue);
+uint64_t decodeMinimum(uint16_t aCode);
+
+// Bit words as alternating runs of zero words and literal words, or as the positions of the set bits, whichever
+// is shorter. Filters of small shards are mostly zero words and shrink by orders of magnitude.
+void writeBitmap(WireWriter& aWriter, std::span<const uint64_t> aWords);
+// Sets the encoded bits in aWords and leaves the others alone, which merges the bitmap into aWords as a union.
+// aWords must have the length of the encoded bitmap.
+void readBitmap(WireReader& aReader, std::span<uint64_t> aWords);